@@ -0,0 +1,61 @@
+// DungeonAliasTable.cpp
+#include "DungeonAliasTable.h"
+
+void FDungeonAliasTable::Build(TArrayView<const float> Weights)
+{
+  Items.Reset();
+  Probabilities.Reset();
+  Aliases.Reset();
+
+  double Total = 0.0;
+  for (int32 i = 0; i < Weights.Num(); i++)
+  {
+    if (Weights[i] > 0.0f && FMath::IsFinite(Weights[i]))
+    {
+      Items.Add(i);
+      Total += Weights[i];
+    }
+  }
+
+  const int32 NumColumns = Items.Num();
+  if (NumColumns == 0) return;
+
+  // Scale so the average column holds exactly 1, then let every column under 1 be
+  // topped up by one that is over
+  TArray<double, TInlineAllocator<32>> Scaled;
+  TArray<int32, TInlineAllocator<32>> Small;
+  TArray<int32, TInlineAllocator<32>> Large;
+  Scaled.SetNumUninitialized(NumColumns);
+  for (int32 Column = 0; Column < NumColumns; Column++)
+  {
+    Scaled[Column] = Weights[Items[Column]] * NumColumns / Total;
+    (Scaled[Column] < 1.0 ? Small : Large).Add(Column);
+  }
+
+  Probabilities.SetNumUninitialized(NumColumns);
+  Aliases.SetNumUninitialized(NumColumns);
+  while (Small.Num() > 0 && Large.Num() > 0)
+  {
+    const int32 Under = Small.Pop(EAllowShrinking::No);
+    const int32 Over = Large.Last();
+    Probabilities[Under] = (float)Scaled[Under];
+    Aliases[Under] = Over;
+
+    Scaled[Over] -= 1.0 - Scaled[Under];
+    if (Scaled[Over] < 1.0)
+    {
+      Large.Pop(EAllowShrinking::No);
+      Small.Add(Over);
+    }
+  }
+
+  // Whatever is left is 1 up to rounding
+  for (const TArray<int32, TInlineAllocator<32>>* Rest : { &Small, &Large })
+  {
+    for (int32 Column : *Rest)
+    {
+      Probabilities[Column] = 1.0f;
+      Aliases[Column] = Column;
+    }
+  }
+}
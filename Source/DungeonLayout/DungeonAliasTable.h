@@ -0,0 +1,27 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Walker's alias method (Vose's construction): after an O(n) build, draws index i
+// with probability Weights[i] / sum of weights from one column pick and one fraction.
+class DUNGEONLAYOUT_API FDungeonAliasTable
+{
+public:
+  // Weights that are zero, negative or not finite are never drawn
+  void Build(TArrayView<const float> Weights);
+
+  bool IsEmpty() const { return Items.Num() == 0; }
+
+  // Index into the weights the table was built from. The table must not be empty.
+  int32 Sample(const FRandomStream& Stream) const
+  {
+    const int32 Column = Stream.RandHelper(Items.Num());
+    return Items[Stream.GetFraction() < Probabilities[Column] ? Column : Aliases[Column]];
+  }
+
+private:
+  // Per column: the weight index it stands for, the chance of keeping it, and the
+  // column taken instead otherwise. Only drawable weights get a column.
+  TArray<int32> Items;
+  TArray<float> Probabilities;
+  TArray<int32> Aliases;
+};
@@ -0,0 +1,49 @@
+// DungeonArena.cpp
+#include "DungeonArena.h"
+
+FDungeonArena::~FDungeonArena()
+{
+  for (const FBlock& Block : Blocks)
+  {
+    FMemory::Free(Block.Data);
+  }
+}
+
+void* FDungeonArena::Allocate(SIZE_T Size, SIZE_T Alignment)
+{
+  // Blocks kept from earlier floors are used in order before any new one is made,
+  // so a floor that repeats an earlier allocation pattern lands in the same places
+  while (BlockIndex < Blocks.Num())
+  {
+    const FBlock& Block = Blocks[BlockIndex];
+    const SIZE_T Start = Align(Offset, Alignment);
+    if (Start + Size <= Block.Size)
+    {
+      Offset = Start + Size;
+      return Block.Data + Start;
+    }
+    BlockIndex++;
+    Offset = 0;
+  }
+
+  // Doubling keeps the block count logarithmic in the largest floor seen
+  const SIZE_T LastSize = Blocks.Num() > 0 ? Blocks.Last().Size : 0;
+  const SIZE_T BlockSize = FMath::Max3(MinBlockSize, LastSize * 2, Align(Size, MinBlockSize));
+  uint8* Data = (uint8*)FMemory::Malloc(BlockSize, FMath::Max<SIZE_T>(Alignment, 16));
+  Blocks.Add({ Data, BlockSize });
+  NumBlockAllocations++;
+
+  BlockIndex = Blocks.Num() - 1;
+  Offset = Size;
+  return Data;
+}
+
+SIZE_T FDungeonArena::GetReservedSize() const
+{
+  SIZE_T Total = 0;
+  for (const FBlock& Block : Blocks)
+  {
+    Total += Block.Size;
+  }
+  return Total;
+}
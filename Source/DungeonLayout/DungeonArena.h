@@ -0,0 +1,143 @@
+#pragma once
+#include "CoreMinimal.h"
+#include <type_traits>
+
+// Linear allocator for the scratch data of one floor. Allocation bumps an offset in
+// the current block; Reset rewinds to the first block in O(1) and keeps every block,
+// so once the arena has seen a floor of a given size, later floors up to that size
+// never reach the global allocator. Nothing is destructed, hence trivial types only.
+class DUNGEONLAYOUT_API FDungeonArena
+{
+public:
+  FDungeonArena() = default;
+  ~FDungeonArena();
+
+  FDungeonArena(const FDungeonArena&) = delete;
+  FDungeonArena& operator=(const FDungeonArena&) = delete;
+
+  void* Allocate(SIZE_T Size, SIZE_T Alignment);
+
+  template <typename ElementType>
+  ElementType* AllocateArray(int32 Num)
+  {
+    static_assert(std::is_trivially_copyable_v<ElementType> && std::is_trivially_destructible_v<ElementType>,
+      "Arena memory is copied with memcpy and never destructed");
+    return (ElementType*)Allocate(FMath::Max(Num, 1) * sizeof(ElementType), alignof(ElementType));
+  }
+
+  // Invalidates everything allocated so far
+  void Reset()
+  {
+    BlockIndex = 0;
+    Offset = 0;
+  }
+
+  // Blocks requested from the global allocator over the arena's lifetime
+  int32 GetNumBlockAllocations() const { return NumBlockAllocations; }
+
+  SIZE_T GetReservedSize() const;
+
+private:
+  static constexpr SIZE_T MinBlockSize = 64 * 1024;
+
+  struct FBlock
+  {
+    uint8* Data;
+    SIZE_T Size;
+  };
+  TArray<FBlock, TInlineAllocator<16>> Blocks;
+  int32 BlockIndex = 0;
+  SIZE_T Offset = 0;
+  int32 NumBlockAllocations = 0;
+};
+
+// Array whose storage lives in an FDungeonArena. Growing takes a larger range from
+// the arena and leaves the old one behind until the next reset. Must be Init'ed
+// again after every reset of its arena.
+template <typename ElementType>
+class TDungeonArenaArray
+{
+public:
+  // Empty, with room for Capacity elements before the first regrowth
+  void Init(FDungeonArena& InArena, int32 Capacity)
+  {
+    Arena = &InArena;
+    Max = FMath::Max(Capacity, 1);
+    Data = Arena->AllocateArray<ElementType>(Max);
+    Count = 0;
+  }
+
+  // Number copies of Value, as TArray::Init
+  void Init(FDungeonArena& InArena, const ElementType& Value, int32 Number)
+  {
+    Init(InArena, Number);
+    for (int32 i = 0; i < Number; i++)
+    {
+      Data[i] = Value;
+    }
+    Count = Number;
+  }
+
+  int32 Num() const { return Count; }
+  bool IsEmpty() const { return Count == 0; }
+  void Reset() { Count = 0; }
+
+  int32 Add(const ElementType& Item)
+  {
+    if (Count == Max)
+    {
+      Grow();
+    }
+    Data[Count] = Item;
+    return Count++;
+  }
+
+  ElementType Pop()
+  {
+    check(Count > 0);
+    return Data[--Count];
+  }
+
+  void RemoveAtSwap(int32 Index)
+  {
+    check(Index >= 0 && Index < Count);
+    Data[Index] = Data[--Count];
+  }
+
+  void Swap(int32 A, int32 B) { ::Swap(Data[A], Data[B]); }
+
+  ElementType& operator[](int32 Index)
+  {
+    checkSlow(Index >= 0 && Index < Count);
+    return Data[Index];
+  }
+
+  const ElementType& operator[](int32 Index) const
+  {
+    checkSlow(Index >= 0 && Index < Count);
+    return Data[Index];
+  }
+
+  ElementType& Last() { return (*this)[Count - 1]; }
+  const ElementType& Last() const { return (*this)[Count - 1]; }
+
+  ElementType* begin() { return Data; }
+  ElementType* end() { return Data + Count; }
+  const ElementType* begin() const { return Data; }
+  const ElementType* end() const { return Data + Count; }
+
+private:
+  void Grow()
+  {
+    check(Arena);
+    ElementType* Grown = Arena->AllocateArray<ElementType>(Max * 2);
+    FMemory::Memcpy(Grown, Data, Count * sizeof(ElementType));
+    Data = Grown;
+    Max *= 2;
+  }
+
+  FDungeonArena* Arena = nullptr;
+  ElementType* Data = nullptr;
+  int32 Count = 0;
+  int32 Max = 0;
+};
@@ -0,0 +1,190 @@
+// DungeonArticulation.cpp
+#include "DungeonArticulation.h"
+
+void FDungeonArticulationTracker::Build(FDungeonArena& Arena, const FDungeonGrid& InGrid, FIntPoint Root)
+{
+  Grid = &InGrid;
+
+  const int32 NumGridCells = Grid->NumIndices();
+  Discovery.Init(Arena, 0, NumGridCells);
+  Low.Init(Arena, 0, NumGridCells);
+  DoorBlocks.Init(Arena, INDEX_NONE, NumGridCells * DungeonDoor::NumDirections);
+  BlockDoorCounts.Init(Arena, Grid->NumCells());
+  Frames.Init(Arena, Grid->NumCells());
+  DoorStack.Init(Arena, Grid->NumCells());
+  Time = 0;
+
+  RootIndex = INDEX_NONE;
+  if (Grid->IsOccupied(Root) && !Grid->HasFlag(Grid->ToIndex(Root), DungeonCell::Locked))
+  {
+    RootIndex = Grid->ToIndex(Root);
+    FindBlocks(RootIndex, INDEX_NONE);
+  }
+
+  // Unlocked cells the root cannot reach. Only locking the last of them can fix that.
+  StrayCount = 0;
+  StrayIndex = INDEX_NONE;
+  UnlockedCount = 0;
+  for (const FIntPoint& Cell : Grid->GetCells())
+  {
+    const int32 Index = Grid->ToIndex(Cell);
+    if (Grid->HasFlag(Index, DungeonCell::Locked)) continue;
+
+    UnlockedCount++;
+    if (Discovery[Index] == 0)
+    {
+      StrayCount++;
+      StrayIndex = Index;
+    }
+  }
+}
+
+bool FDungeonArticulationTracker::CanLock(int32 Index) const
+{
+  if (Grid->HasFlag(Index, DungeonCell::Locked)) return false;
+
+  // Locking the last unlocked cell leaves nothing to isolate
+  if (UnlockedCount == 1) return true;
+
+  if (RootIndex == INDEX_NONE || Index == RootIndex) return false;
+
+  if (StrayCount > 0)
+  {
+    return StrayCount == 1 && Index == StrayIndex;
+  }
+
+  return !IsArticulation(Index);
+}
+
+void FDungeonArticulationTracker::OnLocked(int32 Index)
+{
+  UnlockedCount--;
+
+  if (Index == StrayIndex)
+  {
+    StrayCount = 0;
+    StrayIndex = INDEX_NONE;
+    return;
+  }
+
+  // All of the cell's live doors share one block, otherwise it was an articulation point
+  int32 Block = INDEX_NONE;
+  int32 RestartIndex = INDEX_NONE;
+  for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+  {
+    if (IsLiveDoor(Index, Dir))
+    {
+      Block = DoorBlocks[Index * DungeonDoor::NumDirections + Dir];
+      RestartIndex = Grid->Neighbour(Index, Dir);
+      BlockDoorCounts[Block]--;
+    }
+  }
+
+  // A bridge just disappears. A larger block minus one cell stays connected but may
+  // split into several blocks, so re-run the search over what is left of it.
+  if (Block != INDEX_NONE && BlockDoorCounts[Block] > 0)
+  {
+    FindBlocks(RestartIndex, Block);
+  }
+}
+
+bool FDungeonArticulationTracker::IsLiveDoor(int32 Index, int32 Direction) const
+{
+  return (Grid->GetDoors(Index) & DungeonDoor::FromIndex(Direction)) &&
+    !Grid->HasFlag(Grid->Neighbour(Index, Direction), DungeonCell::Locked);
+}
+
+bool FDungeonArticulationTracker::IsArticulation(int32 Index) const
+{
+  int32 FirstBlock = INDEX_NONE;
+  for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+  {
+    if (!IsLiveDoor(Index, Dir)) continue;
+
+    const int32 Block = DoorBlocks[Index * DungeonDoor::NumDirections + Dir];
+    if (FirstBlock == INDEX_NONE)
+    {
+      FirstBlock = Block;
+    }
+    else if (Block != FirstBlock)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FDungeonArticulationTracker::FindBlocks(int32 Start, int32 RestrictToBlock)
+{
+  // Discovery times from earlier searches count as unvisited
+  SearchStart = Time;
+  Frames.Reset();
+  DoorStack.Reset();
+
+  Discovery[Start] = Low[Start] = ++Time;
+  Frames.Add({ Start, INDEX_NONE, 0 });
+
+  while (Frames.Num() > 0)
+  {
+    FFrame& Frame = Frames.Last();
+    const int32 Current = Frame.Index;
+
+    if (Frame.NextDirection < DungeonDoor::NumDirections)
+    {
+      const int32 Dir = Frame.NextDirection++;
+      const int32 Door = Current * DungeonDoor::NumDirections + Dir;
+
+      if (!IsLiveDoor(Current, Dir)) continue;
+      if (RestrictToBlock != INDEX_NONE && DoorBlocks[Door] != RestrictToBlock) continue;
+      if (Frame.InDirection != INDEX_NONE && Dir == (Frame.InDirection + 2) % DungeonDoor::NumDirections) continue;
+
+      const int32 Next = Grid->Neighbour(Current, Dir);
+      if (Discovery[Next] <= SearchStart)
+      {
+        DoorStack.Add(Door);
+        Discovery[Next] = Low[Next] = ++Time;
+        Frames.Add({ Next, Dir, 0 });
+      }
+      else if (Discovery[Next] < Discovery[Current])
+      {
+        // Back edge to an ancestor
+        DoorStack.Add(Door);
+        Low[Current] = FMath::Min(Low[Current], Discovery[Next]);
+      }
+    }
+    else
+    {
+      const FFrame Done = Frames.Pop();
+      if (Frames.Num() > 0)
+      {
+        const int32 Parent = Frames.Last().Index;
+        Low[Parent] = FMath::Min(Low[Parent], Low[Done.Index]);
+
+        if (Low[Done.Index] >= Discovery[Parent])
+        {
+          CloseBlock(Parent, Done.InDirection);
+        }
+      }
+    }
+  }
+}
+
+void FDungeonArticulationTracker::CloseBlock(int32 Index, int32 Direction)
+{
+  const int32 Block = BlockDoorCounts.Add(0);
+  const int32 TreeDoor = Index * DungeonDoor::NumDirections + Direction;
+
+  while (DoorStack.Num() > 0)
+  {
+    const int32 Door = DoorStack.Pop();
+    const int32 From = Door / DungeonDoor::NumDirections;
+    const int32 Dir = Door % DungeonDoor::NumDirections;
+    const int32 To = Grid->Neighbour(From, Dir);
+
+    DoorBlocks[Door] = Block;
+    DoorBlocks[To * DungeonDoor::NumDirections + (Dir + 2) % DungeonDoor::NumDirections] = Block;
+    BlockDoorCounts[Block]++;
+
+    if (Door == TreeDoor) break;
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+#include "DungeonArena.h"
+
+// Tracks the biconnected components (blocks) of the door graph restricted to
+// unlocked cells, so the locked-area phase can reject a cell whose locking would cut
+// unlocked rooms off from the root in O(1).
+//
+// A cell can be locked without isolating anything iff it is not an articulation
+// point, i.e. all of its live doors lie in a single block. Locking a cell that
+// only touches a bridge just drops that bridge. Locking a cell inside a larger
+// block re-runs Tarjan on that block alone, since only it can split. On the
+// tree-shaped graphs the minimal connection phase produces every block is a bridge,
+// so the whole locked-area phase stays linear.
+class DUNGEONLAYOUT_API FDungeonArticulationTracker
+{
+public:
+  // Computes the blocks of the unlocked door graph reachable from Root. The
+  // tracker's arrays live on Arena until its next reset.
+  void Build(FDungeonArena& Arena, const FDungeonGrid& InGrid, FIntPoint Root);
+
+  // True if locking the cell keeps every other unlocked cell reachable from the root
+  bool CanLock(int32 Index) const;
+
+  // Call after the cell has been flagged Locked in the grid
+  void OnLocked(int32 Index);
+
+private:
+  bool IsLiveDoor(int32 Index, int32 Direction) const;
+  bool IsArticulation(int32 Index) const;
+
+  // Iterative Tarjan over live doors from Start. When RestrictToBlock is set only
+  // doors inside that block are followed.
+  void FindBlocks(int32 Start, int32 RestrictToBlock);
+  void CloseBlock(int32 Index, int32 Direction);
+
+  const FDungeonGrid* Grid = nullptr;
+  int32 RootIndex = INDEX_NONE;
+  int32 StrayCount = 0;
+  int32 StrayIndex = INDEX_NONE;
+  int32 UnlockedCount = 0;
+
+  // Per cell: DFS discovery time (0 = never reached from the root) and low link
+  TDungeonArenaArray<int32> Discovery;
+  TDungeonArenaArray<int32> Low;
+  int32 Time = 0;
+  int32 SearchStart = 0;
+
+  // Per cell and direction: block id of the door, per block: number of doors
+  TDungeonArenaArray<int32> DoorBlocks;
+  TDungeonArenaArray<int32> BlockDoorCounts;
+
+  struct FFrame
+  {
+    int32 Index;
+    int32 InDirection;
+    int32 NextDirection;
+  };
+  TDungeonArenaArray<FFrame> Frames;
+  TDungeonArenaArray<int32> DoorStack;
+};
@@ -0,0 +1,230 @@
+// DungeonBitboard.cpp
+#include "DungeonBitboard.h"
+
+#if PLATFORM_ALWAYS_HAS_AVX_2
+#include <immintrin.h>
+#elif PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+  // Row operations the kernels are written against, one set per instruction set.
+  // A vector holds Lanes consecutive rows.
+  struct FScalarRowOps
+  {
+    using FVector = uint64;
+    static constexpr int32 Lanes = 1;
+    static constexpr const TCHAR* Name = TEXT("Scalar");
+
+    static FVector Zero() { return 0; }
+    static FVector Load(const uint64* Rows) { return *Rows; }
+    static void Store(uint64* Rows, FVector A) { *Rows = A; }
+    static FVector And(FVector A, FVector B) { return A & B; }
+    static FVector Or(FVector A, FVector B) { return A | B; }
+    static FVector AndNot(FVector A, FVector B) { return A & ~B; }
+    template <int32 Bits> static FVector ShiftUp(FVector A) { return A << Bits; }
+    template <int32 Bits> static FVector ShiftDown(FVector A) { return A >> Bits; }
+    static bool Any(FVector A) { return A != 0; }
+  };
+
+#if PLATFORM_ALWAYS_HAS_AVX_2
+  struct FAvx2RowOps
+  {
+    using FVector = __m256i;
+    static constexpr int32 Lanes = 4;
+    static constexpr const TCHAR* Name = TEXT("AVX2");
+
+    static FVector Zero() { return _mm256_setzero_si256(); }
+    static FVector Load(const uint64* Rows) { return _mm256_loadu_si256((const __m256i*)Rows); }
+    static void Store(uint64* Rows, FVector A) { _mm256_storeu_si256((__m256i*)Rows, A); }
+    static FVector And(FVector A, FVector B) { return _mm256_and_si256(A, B); }
+    static FVector Or(FVector A, FVector B) { return _mm256_or_si256(A, B); }
+    static FVector AndNot(FVector A, FVector B) { return _mm256_andnot_si256(B, A); }
+    template <int32 Bits> static FVector ShiftUp(FVector A) { return _mm256_slli_epi64(A, Bits); }
+    template <int32 Bits> static FVector ShiftDown(FVector A) { return _mm256_srli_epi64(A, Bits); }
+    static bool Any(FVector A) { return !_mm256_testz_si256(A, A); }
+  };
+  using FRowOps = FAvx2RowOps;
+#elif PLATFORM_CPU_X86_FAMILY
+  struct FSse2RowOps
+  {
+    using FVector = __m128i;
+    static constexpr int32 Lanes = 2;
+    static constexpr const TCHAR* Name = TEXT("SSE2");
+
+    static FVector Zero() { return _mm_setzero_si128(); }
+    static FVector Load(const uint64* Rows) { return _mm_loadu_si128((const __m128i*)Rows); }
+    static void Store(uint64* Rows, FVector A) { _mm_storeu_si128((__m128i*)Rows, A); }
+    static FVector And(FVector A, FVector B) { return _mm_and_si128(A, B); }
+    static FVector Or(FVector A, FVector B) { return _mm_or_si128(A, B); }
+    static FVector AndNot(FVector A, FVector B) { return _mm_andnot_si128(B, A); }
+    template <int32 Bits> static FVector ShiftUp(FVector A) { return _mm_slli_epi64(A, Bits); }
+    template <int32 Bits> static FVector ShiftDown(FVector A) { return _mm_srli_epi64(A, Bits); }
+    static bool Any(FVector A) { return _mm_movemask_epi8(_mm_cmpeq_epi8(A, _mm_setzero_si128())) != 0xFFFF; }
+  };
+  using FRowOps = FSse2RowOps;
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+  struct FNeonRowOps
+  {
+    using FVector = uint64x2_t;
+    static constexpr int32 Lanes = 2;
+    static constexpr const TCHAR* Name = TEXT("NEON");
+
+    static FVector Zero() { return vdupq_n_u64(0); }
+    static FVector Load(const uint64* Rows) { return vld1q_u64(Rows); }
+    static void Store(uint64* Rows, FVector A) { vst1q_u64(Rows, A); }
+    static FVector And(FVector A, FVector B) { return vandq_u64(A, B); }
+    static FVector Or(FVector A, FVector B) { return vorrq_u64(A, B); }
+    static FVector AndNot(FVector A, FVector B) { return vbicq_u64(A, B); }
+    template <int32 Bits> static FVector ShiftUp(FVector A) { return vshlq_n_u64(A, Bits); }
+    template <int32 Bits> static FVector ShiftDown(FVector A) { return vshrq_n_u64(A, Bits); }
+    static bool Any(FVector A) { return (vgetq_lane_u64(A, 0) | vgetq_lane_u64(A, 1)) != 0; }
+  };
+  using FRowOps = FNeonRowOps;
+#else
+  using FRowOps = FScalarRowOps;
+#endif
+
+  // Vectors starting at any row up to MaxSize must end inside the padding
+  static_assert(FDungeonBitboard::MaxSize + FRowOps::Lanes < UE_ARRAY_COUNT(FDungeonBitboard::FRows::Rows), "Row padding too small for the widest vector");
+
+  template <typename Ops>
+  bool StepRows(const uint64* Frontier, uint64* Visited, const uint64* East, const uint64* South, uint64* Next, int32 FirstRow, int32 LastRow)
+  {
+    typename Ops::FVector Found = Ops::Zero();
+    for (int32 Row = FirstRow; Row <= LastRow; Row += Ops::Lanes)
+    {
+      const typename Ops::FVector Here = Ops::Load(Frontier + Row);
+      const typename Ops::FVector EastLinks = Ops::Load(East + Row);
+
+      // East and west within the row, then down from the row above and up from the row below
+      typename Ops::FVector Reached = Ops::Or(Ops::template ShiftUp<1>(Ops::And(Here, EastLinks)), Ops::And(Ops::template ShiftDown<1>(Here), EastLinks));
+      Reached = Ops::Or(Reached, Ops::And(Ops::Load(Frontier + Row - 1), Ops::Load(South + Row - 1)));
+      Reached = Ops::Or(Reached, Ops::And(Ops::Load(Frontier + Row + 1), Ops::Load(South + Row)));
+      const typename Ops::FVector Seen = Ops::Load(Visited + Row);
+      Reached = Ops::AndNot(Reached, Seen);
+
+      Ops::Store(Next + Row, Reached);
+      Ops::Store(Visited + Row, Ops::Or(Seen, Reached));
+      Found = Ops::Or(Found, Reached);
+    }
+    return Ops::Any(Found);
+  }
+
+  // Runs Row along every chain of east-west links in log2(64) steps (a Kogge-Stone fill)
+  FORCEINLINE uint64 FillAlongRow(uint64 Row, uint64 EastLinks)
+  {
+    // Bit X of ToEast: X can be entered from X - 1. Bit X of ToWest: from X + 1.
+    uint64 ToEast = EastLinks << 1;
+    uint64 ToWest = EastLinks;
+    for (int32 Bits = 1; Bits < 64; Bits *= 2)
+    {
+      Row |= ToEast & (Row << Bits);
+      Row |= ToWest & (Row >> Bits);
+      ToEast &= ToEast << Bits;
+      ToWest &= ToWest >> Bits;
+    }
+    return Row;
+  }
+}
+
+const TCHAR* FDungeonBitboard::GetInstructionSet()
+{
+  return FRowOps::Name;
+}
+
+void FDungeonBitboard::Build(const FDungeonGrid& Grid, EDungeonBitboardEdges Edges, uint8 ExcludeFlags)
+{
+  check(Fits(Grid));
+  Width = Grid.GetWidth();
+  FirstRow = Grid.GetHeight() + 1;
+  LastRow = 0;
+  Cells.Reset();
+  East.Reset();
+  South.Reset();
+
+  const bool bAdjacency = Edges == EDungeonBitboardEdges::Adjacency;
+  for (const FIntPoint& Cell : Grid.GetCells())
+  {
+    const int32 Index = Grid.ToIndex(Cell);
+    if (Grid.HasFlag(Index, ExcludeFlags)) continue;
+
+    const int32 Row = Index / Width + 1;
+    const uint64 Bit = 1ull << (Index % Width);
+    const uint8 Doors = Grid.GetDoors(Index);
+    Cells[Row] |= Bit;
+    FirstRow = FMath::Min(FirstRow, Row);
+    LastRow = FMath::Max(LastRow, Row);
+    if (bAdjacency || (Doors & DungeonDoor::East)) East[Row] |= Bit;
+    if (bAdjacency || (Doors & DungeonDoor::South)) South[Row] |= Bit;
+  }
+
+  for (int32 Row = FirstRow; Row <= LastRow; Row++)
+  {
+    East[Row] &= Cells[Row] >> 1;
+    South[Row] &= Cells[Row + 1];
+  }
+}
+
+void FDungeonBitboard::RemoveDoor(int32 Index, uint8 Door)
+{
+  const int32 Row = Index / Width + 1;
+  const uint64 Bit = 1ull << (Index % Width);
+  switch (Door)
+  {
+  case DungeonDoor::North: South[Row - 1] &= ~Bit; break;
+  case DungeonDoor::East: East[Row] &= ~Bit; break;
+  case DungeonDoor::South: South[Row] &= ~Bit; break;
+  case DungeonDoor::West: East[Row] &= ~(Bit >> 1); break;
+  default: break;
+  }
+}
+
+bool FDungeonBitboard::Step(const FRows& Frontier, FRows& Visited, FRows& OutNext) const
+{
+  return StepRows<FRowOps>(Frontier.Rows, Visited.Rows, East.Rows, South.Rows, OutNext.Rows, FirstRow, LastRow);
+}
+
+void FDungeonBitboard::Fill(FRows& Reached) const
+{
+  // Each row depends on the one just updated, so a fill sweeps row by row in place
+  // rather than in vectors. Sweeps alternate down and up; every row gets a full
+  // east-west fill, so the sweep count follows the number of times paths turn back
+  // vertically, not their length.
+  bool bChanged = true;
+  for (int32 Sweep = 0; bChanged; Sweep++)
+  {
+    bChanged = false;
+    const bool bDown = (Sweep & 1) == 0;
+    for (int32 Step = 0; Step <= LastRow - FirstRow; Step++)
+    {
+      const int32 Row = bDown ? FirstRow + Step : LastRow - Step;
+      const uint64 Before = Reached[Row];
+      uint64 After = Before | (Reached[Row - 1] & South[Row - 1]) | (Reached[Row + 1] & South[Row]);
+      if (After == 0) continue;
+
+      After = FillAlongRow(After, East[Row]);
+      Reached[Row] = After;
+      bChanged |= After != Before;
+    }
+  }
+}
+
+bool FDungeonBitboard::ReachesAll(int32 Index) const
+{
+  if (!HasCell(Cells, Index)) return false;
+
+  FRows Reached;
+  Reached.Reset();
+  SetCell(Reached, Index);
+  Fill(Reached);
+
+  for (int32 Row = FirstRow; Row <= LastRow; Row++)
+  {
+    if (Reached[Row] != Cells[Row]) return false;
+  }
+  return true;
+}
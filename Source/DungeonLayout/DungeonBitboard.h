@@ -0,0 +1,82 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+
+// Which neighbouring cells a bitboard treats as joined
+enum class EDungeonBitboardEdges : uint8
+{
+  Doors,     // Through doors in the grid's door masks
+  Adjacency  // Through any shared side
+};
+
+// Connectivity kernel for grids up to 64x64. Each row of cells is one uint64 with
+// bit X for column X, and links are two more row sets: East (bit X joins X and X+1)
+// and South (bit X of row Y joins rows Y and Y+1). A breadth-first level or a whole
+// flood fill is then a few shifts and masks per row, several rows per instruction
+// with AVX2, SSE2 or NEON, and plain uint64 maths elsewhere. The generator picks it
+// over queue searches whenever FDungeonBitboard::Fits says the grid is small enough.
+class DUNGEONLAYOUT_API FDungeonBitboard
+{
+public:
+  static constexpr int32 MaxSize = 64;
+
+  // Rows live at 1..height with empty padding around them, so kernels read the rows
+  // above and below and whole vectors past the end without bounds checks. Kernels
+  // only look at rows FirstRow..LastRow, the ones holding loaded cells.
+  struct FRows
+  {
+    alignas(32) uint64 Rows[MaxSize + 8];
+
+    void Reset() { FMemory::Memzero(Rows, sizeof(Rows)); }
+    uint64& operator[](int32 Row) { return Rows[Row]; }
+    uint64 operator[](int32 Row) const { return Rows[Row]; }
+  };
+
+  static bool Fits(const FDungeonGrid& Grid) { return Grid.GetWidth() <= MaxSize && Grid.GetHeight() <= MaxSize; }
+
+  // Name of the instruction set the kernels were built for
+  static const TCHAR* GetInstructionSet();
+
+  // Loads the grid's occupied cells that carry none of ExcludeFlags, joined by Edges.
+  // A link only counts if both of its cells are loaded.
+  void Build(const FDungeonGrid& Grid, EDungeonBitboardEdges Edges, uint8 ExcludeFlags = DungeonCell::None);
+
+  // Drops one link, e.g. a door a search must not cross. Door is the bit on Index's side.
+  void RemoveDoor(int32 Index, uint8 Door);
+
+  const FRows& GetCells() const { return Cells; }
+
+  void SetCell(FRows& Rows, int32 Index) const { Rows[Index / Width + 1] |= 1ull << (Index % Width); }
+  bool HasCell(const FRows& Rows, int32 Index) const { return (Rows[Index / Width + 1] >> (Index % Width)) & 1; }
+
+  // One breadth-first level: cells linked to Frontier that are not in Visited yet.
+  // Adds them to Visited too. Returns false if there are none.
+  bool Step(const FRows& Frontier, FRows& Visited, FRows& OutNext) const;
+
+  // Grows Reached to every loaded cell linked to it
+  void Fill(FRows& Reached) const;
+
+  // True if every loaded cell is linked to the cell at Index
+  bool ReachesAll(int32 Index) const;
+
+  // Calls Function with the grid index of every cell in Rows, in index order
+  template <typename FunctionType>
+  void ForEachCell(const FRows& Rows, FunctionType&& Function) const
+  {
+    for (int32 Row = FirstRow; Row <= LastRow; Row++)
+    {
+      for (uint64 Bits = Rows[Row]; Bits; Bits &= Bits - 1)
+      {
+        Function((Row - 1) * Width + (int32)FMath::CountTrailingZeros64(Bits));
+      }
+    }
+  }
+
+private:
+  int32 Width = 0;
+  int32 FirstRow = 1;
+  int32 LastRow = 0;
+  FRows Cells;
+  FRows East;
+  FRows South;
+};
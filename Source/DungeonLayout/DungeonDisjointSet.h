@@ -0,0 +1,51 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonArena.h"
+
+// Union-find over grid indices. Union by size plus path halving keeps every Find and
+// Union at amortised O(alpha(N)), so a pass over all the doors of a floor is
+// effectively linear. Lives on an arena and must be Init'ed again after it is reset.
+class FDungeonDisjointSet
+{
+public:
+  // Every index below Num in a set of its own
+  void Init(FDungeonArena& Arena, int32 Num)
+  {
+    Parents.Init(Arena, -1, Num);
+  }
+
+  int32 Find(int32 Index)
+  {
+    // Path halving: every other node on the way up skips to its grandparent
+    for (int32 Parent = Parents[Index]; Parent >= 0; Parent = Parents[Index])
+    {
+      const int32 GrandParent = Parents[Parent];
+      if (GrandParent < 0) return Parent;
+
+      Parents[Index] = GrandParent;
+      Index = GrandParent;
+    }
+    return Index;
+  }
+
+  // Returns false if A and B were already in the same set
+  bool Union(int32 A, int32 B)
+  {
+    A = Find(A);
+    B = Find(B);
+    if (A == B) return false;
+
+    // Roots hold minus their set's size
+    if (Parents[A] > Parents[B])
+    {
+      Swap(A, B);
+    }
+    Parents[A] += Parents[B];
+    Parents[B] = A;
+    return true;
+  }
+
+private:
+  // Parent index, or for a root minus the size of its set
+  TDungeonArenaArray<int32> Parents;
+};
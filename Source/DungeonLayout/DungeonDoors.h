@@ -0,0 +1,38 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Door bits stored per cell. Grid +Y is south, matching SpawnRoom.
+namespace DungeonDoor
+{
+  constexpr uint8 None = 0;
+  constexpr uint8 North = 1 << 0;
+  constexpr uint8 East = 1 << 1;
+  constexpr uint8 South = 1 << 2;
+  constexpr uint8 West = 1 << 3;
+  constexpr uint8 All = North | East | South | West;
+
+  // Direction indices follow the bit order above
+  constexpr int32 NumDirections = 4;
+  inline const FIntPoint Offsets[NumDirections] = { FIntPoint(0, -1), FIntPoint(1, 0), FIntPoint(0, 1), FIntPoint(-1, 0) };
+
+  FORCEINLINE constexpr uint8 FromIndex(int32 Direction)
+  {
+    return uint8(1 << Direction);
+  }
+
+  FORCEINLINE constexpr uint8 Opposite(uint8 Doors)
+  {
+    return ((Doors << 2) | (Doors >> 2)) & All;
+  }
+
+  // Door bit on From that leads to To, or None if the cells are not orthogonal neighbours
+  FORCEINLINE uint8 Between(FIntPoint From, FIntPoint To)
+  {
+    const FIntPoint Delta = To - From;
+    if (Delta.X == 0 && Delta.Y == -1) return North;
+    if (Delta.X == 1 && Delta.Y == 0) return East;
+    if (Delta.X == 0 && Delta.Y == 1) return South;
+    if (Delta.X == -1 && Delta.Y == 0) return West;
+    return None;
+  }
+}
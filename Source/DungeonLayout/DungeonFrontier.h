@@ -0,0 +1,121 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonArena.h"
+
+// Set of candidate cells for random growth. Cells live in a dense array with a
+// cell-to-slot hash table beside it, so insert, remove and uniform random pick are all
+// O(1). Removal swaps the last cell into the freed slot, so slot order is not stable.
+// Both live on an arena and must be Init'ed again after it is reset.
+class FDungeonFrontier
+{
+public:
+  // Empty, sized for about MaxCells cells at once
+  void Init(FDungeonArena& InArena, int32 MaxCells)
+  {
+    Arena = &InArena;
+    Cells.Init(InArena, MaxCells);
+    InitBuckets(MaxCells);
+  }
+
+  int32 Num() const { return Cells.Num(); }
+  bool Contains(FIntPoint Cell) const { return Buckets[FindBucket(Cell)] != INDEX_NONE; }
+  FIntPoint operator[](int32 Slot) const { return Cells[Slot]; }
+
+  // Returns false if the cell was already in the frontier
+  bool Add(FIntPoint Cell)
+  {
+    uint32 Bucket = FindBucket(Cell);
+    if (Buckets[Bucket] != INDEX_NONE) return false;
+
+    // Keep the table at most half full so probe runs stay short
+    if ((uint32)(Cells.Num() + 1) * 2 > BucketMask + 1)
+    {
+      Rehash();
+      Bucket = FindBucket(Cell);
+    }
+    Buckets[Bucket] = Cells.Add(Cell);
+    return true;
+  }
+
+  bool Remove(FIntPoint Cell)
+  {
+    const int32 Slot = Buckets[FindBucket(Cell)];
+    if (Slot == INDEX_NONE) return false;
+
+    RemoveAt(Slot);
+    return true;
+  }
+
+  // Removes the cell in Slot and returns it
+  FIntPoint RemoveAt(int32 Slot)
+  {
+    const FIntPoint Cell = Cells[Slot];
+    const FIntPoint Moved = Cells.Last();
+
+    EraseBucket(FindBucket(Cell));
+    if (Moved != Cell)
+    {
+      Buckets[FindBucket(Moved)] = Slot;
+    }
+    Cells.RemoveAtSwap(Slot);
+    return Cell;
+  }
+
+private:
+  static uint32 HashCell(FIntPoint Cell)
+  {
+    uint32 Hash = (uint32)Cell.X * 0x9E3779B1u ^ (uint32)Cell.Y * 0x85EBCA77u;
+    return Hash ^ (Hash >> 15);
+  }
+
+  void InitBuckets(int32 MaxCells)
+  {
+    BucketMask = FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(MaxCells, 8) * 2) - 1;
+    Buckets = Arena->AllocateArray<int32>(BucketMask + 1);
+    for (uint32 Bucket = 0; Bucket <= BucketMask; Bucket++)
+    {
+      Buckets[Bucket] = INDEX_NONE;
+    }
+  }
+
+  void Rehash()
+  {
+    InitBuckets(Cells.Num() * 2);
+    for (int32 Slot = 0; Slot < Cells.Num(); Slot++)
+    {
+      Buckets[FindBucket(Cells[Slot])] = Slot;
+    }
+  }
+
+  // Bucket holding Cell, or the empty bucket where it would go
+  uint32 FindBucket(FIntPoint Cell) const
+  {
+    uint32 Bucket = HashCell(Cell) & BucketMask;
+    while (Buckets[Bucket] != INDEX_NONE && Cells[Buckets[Bucket]] != Cell)
+    {
+      Bucket = (Bucket + 1) & BucketMask;
+    }
+    return Bucket;
+  }
+
+  // Linear probing delete: shift later entries of the run back over the hole
+  // instead of leaving a tombstone
+  void EraseBucket(uint32 Hole)
+  {
+    for (uint32 Next = (Hole + 1) & BucketMask; Buckets[Next] != INDEX_NONE; Next = (Next + 1) & BucketMask)
+    {
+      const uint32 Home = HashCell(Cells[Buckets[Next]]) & BucketMask;
+      if (((Next - Home) & BucketMask) >= ((Next - Hole) & BucketMask))
+      {
+        Buckets[Hole] = Buckets[Next];
+        Hole = Next;
+      }
+    }
+    Buckets[Hole] = INDEX_NONE;
+  }
+
+  FDungeonArena* Arena = nullptr;
+  TDungeonArenaArray<FIntPoint> Cells;
+  int32* Buckets = nullptr;
+  uint32 BucketMask = 0;
+};
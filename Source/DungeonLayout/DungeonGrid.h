@@ -0,0 +1,199 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonDoors.h"
+
+// Per-cell state bits
+namespace DungeonCell
+{
+  constexpr uint8 None = 0;
+  constexpr uint8 Occupied = 1 << 0;
+  constexpr uint8 Locked = 1 << 1;
+  constexpr uint8 Accessible = 1 << 2;
+}
+
+// Dense bounded dungeon grid with a struct-of-arrays cell layout, grown on demand to
+// fit the layout's bounding box. Callers that attach their own per-cell data (spawned
+// rooms, distances) keep it in arrays indexed the same way.
+// Occupied cells always keep a free ring around them inside the bounds, so the
+// neighbours of an occupied cell are plain index arithmetic with no bounds checks.
+class FDungeonGrid
+{
+public:
+  // Clears every cell and places the grid's top-left corner at InMin
+  void Reset(FIntPoint InMin, int32 InitialWidth = 0, int32 InitialHeight = 0)
+  {
+    Min = InMin;
+    Width = FMath::Max(0, InitialWidth);
+    Height = FMath::Max(0, InitialHeight);
+
+    Flags.Init(DungeonCell::None, NumIndices());
+    DoorMasks.Init(DungeonDoor::None, NumIndices());
+    Cells.Reset();
+  }
+
+  int32 GetWidth() const { return Width; }
+  int32 GetHeight() const { return Height; }
+  FIntPoint GetMin() const { return Min; }
+
+  bool IsInside(FIntPoint Cell) const
+  {
+    return Cell.X >= Min.X && Cell.Y >= Min.Y && Cell.X < Min.X + GetWidth() && Cell.Y < Min.Y + GetHeight();
+  }
+
+  int32 ToIndex(FIntPoint Cell) const
+  {
+    return (Cell.Y - Min.Y) * GetWidth() + (Cell.X - Min.X);
+  }
+
+  FIntPoint ToCell(int32 Index) const
+  {
+    return FIntPoint(Min.X + Index % GetWidth(), Min.Y + Index / GetWidth());
+  }
+
+  // Index of the neighbour in a DungeonDoor direction. Only valid for occupied cells
+  // (or any cell not on the border ring).
+  int32 Neighbour(int32 Index, int32 Direction) const
+  {
+    const int32 Strides[DungeonDoor::NumDirections] = { -GetWidth(), 1, GetWidth(), -1 };
+    return Index + Strides[Direction];
+  }
+
+  // Marks a cell occupied, growing the grid to keep its border ring.
+  // Indices taken before this call are invalid if the grid grew.
+  void Occupy(FIntPoint Cell)
+  {
+    Include(Cell);
+
+    uint8& CellFlags = Flags[ToIndex(Cell)];
+    if (!(CellFlags & DungeonCell::Occupied))
+    {
+      CellFlags |= DungeonCell::Occupied;
+      Cells.Add(Cell);
+    }
+  }
+
+  bool IsOccupied(FIntPoint Cell) const
+  {
+    return IsInside(Cell) && (Flags[ToIndex(Cell)] & DungeonCell::Occupied);
+  }
+
+  bool IsOccupied(int32 Index) const { return (Flags[Index] & DungeonCell::Occupied) != 0; }
+
+  // Occupied cells in the order they were added
+  const TArray<FIntPoint>& GetCells() const { return Cells; }
+  int32 NumCells() const { return Cells.Num(); }
+
+  bool HasFlag(FIntPoint Cell, uint8 Flag) const
+  {
+    return IsInside(Cell) && (Flags[ToIndex(Cell)] & Flag);
+  }
+
+  bool HasFlag(int32 Index, uint8 Flag) const { return (Flags[Index] & Flag) != 0; }
+  void SetFlag(int32 Index, uint8 Flag) { Flags[Index] |= Flag; }
+  void ClearFlag(int32 Index, uint8 Flag) { Flags[Index] &= ~Flag; }
+
+  // Door graph. Both endpoints of a door carry the matching bit.
+  void Connect(FIntPoint A, FIntPoint B)
+  {
+    const uint8 Door = DungeonDoor::Between(A, B);
+    if (Door == DungeonDoor::None || !IsInside(A) || !IsInside(B)) return;
+
+    DoorMasks[ToIndex(A)] |= Door;
+    DoorMasks[ToIndex(B)] |= DungeonDoor::Opposite(Door);
+  }
+
+  void Disconnect(FIntPoint A, FIntPoint B)
+  {
+    const uint8 Door = DungeonDoor::Between(A, B);
+    if (Door == DungeonDoor::None || !IsInside(A) || !IsInside(B)) return;
+
+    DoorMasks[ToIndex(A)] &= ~Door;
+    DoorMasks[ToIndex(B)] &= ~DungeonDoor::Opposite(Door);
+  }
+
+  // Index form of Connect, for cells off the border ring
+  void ConnectNeighbour(int32 Index, int32 Direction)
+  {
+    const uint8 Door = DungeonDoor::FromIndex(Direction);
+    DoorMasks[Index] |= Door;
+    DoorMasks[Neighbour(Index, Direction)] |= DungeonDoor::Opposite(Door);
+  }
+
+  bool IsConnected(FIntPoint A, FIntPoint B) const
+  {
+    return (GetDoors(A) & DungeonDoor::Between(A, B)) != 0;
+  }
+
+  uint8 GetDoors(FIntPoint Cell) const
+  {
+    return IsInside(Cell) ? DoorMasks[ToIndex(Cell)] : DungeonDoor::None;
+  }
+
+  uint8 GetDoors(int32 Index) const { return DoorMasks[Index]; }
+
+  // Raw mask write for loaders. The caller keeps both endpoints of each door in step.
+  void SetDoors(int32 Index, uint8 Doors) { DoorMasks[Index] = Doors; }
+
+  // Number of cells in the bounding box, i.e. the length of every column
+  int32 NumIndices() const { return GetWidth() * GetHeight(); }
+
+private:
+  // Makes sure Cell and its four neighbours are inside the bounds
+  void Include(FIntPoint Cell)
+  {
+    const FIntPoint RingMin = Cell - FIntPoint(1, 1);
+    const FIntPoint RingMax = Cell + FIntPoint(1, 1);
+    if (IsInside(RingMin) && IsInside(RingMax)) return;
+
+    // Grow geometrically on the sides that overflow so repeated growth stays amortised O(1)
+    const int32 SlackX = FMath::Max(4, GetWidth() / 2);
+    const int32 SlackY = FMath::Max(4, GetHeight() / 2);
+
+    FIntPoint NewMin = Min;
+    FIntPoint NewMax = Min + FIntPoint(GetWidth() - 1, GetHeight() - 1);
+    if (GetWidth() == 0 || GetHeight() == 0)
+    {
+      NewMin = RingMin;
+      NewMax = RingMax;
+    }
+    if (RingMin.X < NewMin.X) NewMin.X = RingMin.X - SlackX;
+    if (RingMin.Y < NewMin.Y) NewMin.Y = RingMin.Y - SlackY;
+    if (RingMax.X > NewMax.X) NewMax.X = RingMax.X + SlackX;
+    if (RingMax.Y > NewMax.Y) NewMax.Y = RingMax.Y + SlackY;
+
+    const int32 NewWidth = NewMax.X - NewMin.X + 1;
+    const int32 NewHeight = NewMax.Y - NewMin.Y + 1;
+
+    RemapColumn(Flags, NewMin, NewWidth, NewHeight, DungeonCell::None);
+    RemapColumn(DoorMasks, NewMin, NewWidth, NewHeight, DungeonDoor::None);
+
+    Min = NewMin;
+    Width = NewWidth;
+    Height = NewHeight;
+  }
+
+  template <typename ElementType>
+  void RemapColumn(TArray<ElementType>& Column, FIntPoint NewMin, int32 NewWidth, int32 NewHeight, ElementType Value) const
+  {
+    TArray<ElementType> Remapped;
+    Remapped.Init(Value, NewWidth * NewHeight);
+
+    const int32 OffsetX = Min.X - NewMin.X;
+    const int32 OffsetY = Min.Y - NewMin.Y;
+    for (int32 Y = 0; Y < Height && Width > 0; Y++)
+    {
+      FMemory::Memcpy(&Remapped[(Y + OffsetY) * NewWidth + OffsetX], &Column[Y * Width], Width * sizeof(ElementType));
+    }
+    Column = MoveTemp(Remapped);
+  }
+
+  FIntPoint Min = FIntPoint::ZeroValue;
+  int32 Width = 0;
+  int32 Height = 0;
+
+  TArray<uint8> Flags;
+  TArray<uint8> DoorMasks;
+
+  TArray<FIntPoint> Cells;
+};
+
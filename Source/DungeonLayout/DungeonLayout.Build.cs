@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+
+// Engine-independent dungeon layout generation. Depends on Core only, so it can be
+// built and run without a world, renderer or cooked content.
+public class DungeonLayout : ModuleRules
+{
+	public DungeonLayout(ReadOnlyTargetRules Target) : base(Target)
+	{
+				PublicDependencyModuleNames.AddRange(new string[] {
+				"Core"
+		});
+				PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+				// Headers sit next to the sources, as in the game module
+				PublicIncludePaths.Add(ModuleDirectory);
+		}
+}
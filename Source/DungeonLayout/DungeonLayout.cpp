@@ -0,0 +1,1164 @@
+// DungeonLayout.cpp
+#include "DungeonLayout.h"
+#include "DungeonLayoutStats.h"
+#include "Misc/ScopeExit.h"
+
+DECLARE_CYCLE_STAT(TEXT("Generate Layout"), STAT_DungeonGenerateLayout, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Grow Rooms"), STAT_DungeonGrowRooms, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Wave Function Collapse"), STAT_DungeonCollapseRooms, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Minimal Connections"), STAT_DungeonMinimalConnections, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Locked Area"), STAT_DungeonLockedArea, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Extra Doors"), STAT_DungeonExtraDoors, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Accessible Area"), STAT_DungeonAccessibleArea, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Layout: Enemies"), STAT_DungeonPlaceEnemies, STATGROUP_Dungeon);
+
+namespace
+{
+  // A pair of adjacent rooms, held as the west or north room and the direction to the other
+  struct FDungeonEdge
+  {
+    int32 Index;
+    int32 Direction;
+  };
+
+  // East and south, so walking every room sees each adjacent pair once
+  constexpr int32 EdgeDirections[] = { 1, 2 };
+
+  // Weight of every tile of each EDungeonRoomShape when a collapsed cell picks one.
+  // Empty cells weigh double so floors open up into corridors instead of a solid
+  // block of rooms, and crossroads half so they stay rare.
+  constexpr float CollapseTileWeights[] = { 2.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.5f };
+  static_assert(UE_ARRAY_COUNT(CollapseTileWeights) == (int32)EDungeonRoomShape::Num, "One weight per room shape");
+
+  // Share of a collapsed field that ends up in the floor with those weights
+  constexpr float CollapseFieldFill = 0.5f;
+
+  // Rules for collapsed floors: no two crossroads touch, and a straight corridor runs
+  // on into another straight or a junction rather than stopping at a turn or dead end
+  FDungeonWaveRules MakeFloorRules()
+  {
+    FDungeonWaveRules Rules;
+    const uint16 Crossroads = FDungeonWaveRules::TilesOfShape(EDungeonRoomShape::Crossroad);
+    const uint16 Stops = FDungeonWaveRules::TilesOfShape(EDungeonRoomShape::DeadEnd) | FDungeonWaveRules::TilesOfShape(EDungeonRoomShape::Turn);
+    Rules.ForbidTouching(Crossroads, Crossroads);
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      const uint16 Straights = FDungeonWaveRules::TilesOfShape(EDungeonRoomShape::Straight) & FDungeonWaveRules::TilesWithDoor(DungeonDoor::FromIndex(Dir));
+      Rules.Forbid(Straights, Dir, Stops);
+    }
+
+    for (int32 Tile = 0; Tile < FDungeonWaveRules::NumTiles; Tile++)
+    {
+      Rules.Weights[Tile] = CollapseTileWeights[(int32)DungeonRoomShape::FromDoors((uint8)Tile).Shape];
+    }
+    return Rules;
+  }
+
+  const FDungeonWaveRules& GetFloorRules()
+  {
+    static const FDungeonWaveRules Rules = MakeFloorRules();
+    return Rules;
+  }
+
+#if DO_GUARD_SLOW
+  // Whether every room gets along with all four of its neighbours, empty cells included
+  bool FollowsFloorRules(const FDungeonGrid& Grid)
+  {
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+      {
+        if (!GetFloorRules().Allows(Grid.GetDoors(Cell), Dir, Grid.GetDoors(Cell + DungeonDoor::Offsets[Dir]))) return false;
+      }
+    }
+    return true;
+  }
+#endif
+
+  // Offset from the locked room to its neighbour per locked door facing, the order
+  // SpawnLockedDoor expects
+  const FIntPoint LockedDoorFacings[] = { FIntPoint(0, 1), FIntPoint(1, 0), FIntPoint(0, -1), FIntPoint(-1, 0) };
+
+  // Fenwick tree over positions 0 to Num - 1. Marks positions and counts the marked
+  // ones below a bound, both in O(log Num).
+  class FMarkedPositions
+  {
+  public:
+    void Init(FDungeonArena& Arena, int32 Num) { Counts.Init(Arena, 0, Num + 1); }
+
+    void Mark(int32 Position)
+    {
+      for (int32 i = Position + 1; i < Counts.Num(); i += i & -i)
+      {
+        Counts[i]++;
+      }
+    }
+
+    int32 CountBelow(int32 Bound) const
+    {
+      int32 Count = 0;
+      for (int32 i = Bound; i > 0; i -= i & -i)
+      {
+        Count += Counts[i];
+      }
+      return Count;
+    }
+
+  private:
+    TDungeonArenaArray<int32> Counts;
+  };
+}
+
+FDungeonLayout FDungeonLayoutGenerator::Generate(const FDungeonLayoutParams& InParams, const FDungeonLayoutCancellation* InCancellation)
+{
+  LLM_SCOPE_BYTAG(Dungeon);
+  SCOPE_CYCLE_COUNTER(STAT_DungeonGenerateLayout);
+
+  Params = InParams;
+  Params.CellCount = FMath::Min(Params.CellCount, MaxCellCount);
+  Cancellation = InCancellation;
+  Layout = FDungeonLayout();
+  Layout.Seed = Params.Seed;
+
+  // Everything from the previous floor is garbage now
+  Arena.Reset();
+  const int32 StartBlockAllocations = Arena.GetNumBlockAllocations();
+  ON_SCOPE_EXIT
+  {
+    LastScratchAllocations = Arena.GetNumBlockAllocations() - StartBlockAllocations;
+    INC_DWORD_STAT_BY(STAT_DungeonScratchAllocations, LastScratchAllocations);
+  };
+
+  GrowthStream = MakeStream(Params.Seed, EDungeonRandomStream::Growth);
+  LockedAreaStream = MakeStream(Params.Seed, EDungeonRandomStream::LockedArea);
+  LockedDoorStream = MakeStream(Params.Seed, EDungeonRandomStream::LockedDoor);
+  KeyRoomStream = MakeStream(Params.Seed, EDungeonRandomStream::KeyRoom);
+  ExtraDoorStream = MakeStream(Params.Seed, EDungeonRandomStream::ExtraDoors);
+  ConnectionStream = MakeStream(Params.Seed, EDungeonRandomStream::Connections);
+  WaveCollapseStream = MakeStream(Params.Seed, EDungeonRandomStream::WaveCollapse);
+
+  // A connected shape of N cells has at most 2N + 2 free neighbours, and N counts the
+  // safe and end rooms. Every search visits each room at most once, key room included.
+  // Collapsed floors may have up to twice CellCount rooms.
+  const int32 MaxCellCount = Params.Engine == EDungeonLayoutEngine::WaveFunctionCollapse ? Params.CellCount * 2 : Params.CellCount;
+  const int32 MaxRooms = FMath::Max(MaxCellCount, 2) + 3;
+  AvailablePositions.Init(Arena, MaxRooms * 2 + 2);
+  Queue.Init(Arena, MaxRooms);
+
+  Timings = FDungeonLayoutTimings();
+  PhaseStartTime = FPlatformTime::Seconds();
+
+  bCollapsedFloor = Params.Engine == EDungeonLayoutEngine::WaveFunctionCollapse && CollapseRooms();
+  if (!bCollapsedFloor && !IsCancelled())
+  {
+    GrowRooms();
+  }
+  if (IsCancelled()) return FDungeonLayout();
+  if (!bCollapsedFloor)
+  {
+    PlaceSafeAndEndRooms();
+  }
+  EndPhase(Timings.Growth);
+
+  // Create all connections first. Collapsed floors come with theirs, safe and end
+  // rooms included.
+  if (!bCollapsedFloor)
+  {
+    CreateMinimalConnections();
+  }
+  EndPhase(Timings.MinimalConnections);
+  if (IsCancelled()) return FDungeonLayout();
+  CreateLockedArea();
+  EndPhase(Timings.LockedArea);
+  if (IsCancelled()) return FDungeonLayout();
+  AddExtraDoors();
+  EndPhase(Timings.ExtraDoors);
+
+  // No phase after the collapse adds a door or room the floor rules forbid
+  checkSlow(!bCollapsedFloor || FollowsFloorRules(Layout.Grid));
+
+  CalculateAccessibleArea();
+  EndPhase(Timings.AccessibleArea);
+  PlaceEnemies();
+  EndPhase(Timings.Enemies);
+
+  return MoveTemp(Layout);
+}
+
+void FDungeonLayoutGenerator::EndPhase(double& OutSeconds)
+{
+  double Now = FPlatformTime::Seconds();
+  OutSeconds = Now - PhaseStartTime;
+  PhaseStartTime = Now;
+}
+
+int32 FDungeonLayoutGenerator::MixSeed(int32 Seed, uint32 Salt)
+{
+  // SplitMix64 finaliser over (seed, salt)
+  uint64 Mixed = ((uint64)(uint32)Seed << 32) | Salt;
+  Mixed += 0x9E3779B97F4A7C15ull;
+  Mixed = (Mixed ^ (Mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+  Mixed = (Mixed ^ (Mixed >> 27)) * 0x94D049BB133111EBull;
+  Mixed ^= Mixed >> 31;
+  return (int32)(uint32)Mixed;
+}
+
+FRandomStream FDungeonLayoutGenerator::MakeStream(int32 Seed, EDungeonRandomStream Stream)
+{
+  return FRandomStream(MixSeed(Seed, (uint32)Stream));
+}
+
+bool FDungeonLayoutGenerator::CollapseRooms()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonCollapseRooms);
+
+  // A square field whose largest door-joined piece comes to about CellCount rooms
+  const int32 Size = FMath::Max(3, FMath::CeilToInt(FMath::Sqrt(Params.CellCount / CollapseFieldFill)));
+  for (int32 Attempt = 0; Attempt < MaxCollapseAttempts; Attempt++)
+  {
+    if (IsCancelled()) return false;
+    if (WaveCollapse.Run(Arena, GetFloorRules(), Size, Size, MaxCollapseBacktracks, WaveCollapseStream, Cancellation) &&
+      TakeCollapsedPiece(Size) && AttachSafeAndEndRooms())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FDungeonLayoutGenerator::TakeCollapsedPiece(int32 Size)
+{
+  // The floor is the largest piece; rooms outside it have no way in
+  FDungeonDisjointSet Pieces;
+  Pieces.Init(Arena, Size * Size);
+  for (int32 Y = 0; Y < Size; Y++)
+  {
+    for (int32 X = 0; X < Size; X++)
+    {
+      const uint8 Doors = WaveCollapse.GetDoors(X, Y);
+      if (Doors & DungeonDoor::East) Pieces.Union(Y * Size + X, Y * Size + X + 1);
+      if (Doors & DungeonDoor::South) Pieces.Union(Y * Size + X, (Y + 1) * Size + X);
+    }
+  }
+
+  TDungeonArenaArray<int32> PieceSizes;
+  PieceSizes.Init(Arena, 0, Size * Size);
+  int32 LargestPiece = INDEX_NONE;
+  for (int32 Index = 0; Index < Size * Size; Index++)
+  {
+    if (WaveCollapse.GetDoors(Index % Size, Index / Size) == DungeonDoor::None) continue;
+
+    const int32 Piece = Pieces.Find(Index);
+    if (++PieceSizes[Piece] > (LargestPiece == INDEX_NONE ? 0 : PieceSizes[LargestPiece]))
+    {
+      LargestPiece = Piece;
+    }
+  }
+  if (LargestPiece == INDEX_NONE) return false;
+
+  const int32 NumRooms = PieceSizes[LargestPiece];
+  if (NumRooms * 2 < Params.CellCount || NumRooms > Params.CellCount * 2) return false;
+
+  // The origin is the piece's room in its top row nearest the middle, so as on grown
+  // floors no room sits above it
+  FIntPoint Origin(0, 0);
+  int32 OriginDistance = MAX_int32;
+  for (int32 Index = 0; Index < Size * Size; Index++)
+  {
+    if (WaveCollapse.GetDoors(Index % Size, Index / Size) == DungeonDoor::None || Pieces.Find(Index) != LargestPiece) continue;
+    if (OriginDistance != MAX_int32 && Index / Size != Origin.Y) break;
+
+    const int32 Distance = FMath::Abs(Index % Size * 2 - Size);
+    if (Distance < OriginDistance)
+    {
+      OriginDistance = Distance;
+      Origin = FIntPoint(Index % Size, Index / Size);
+    }
+  }
+
+  // Two spare cells on each side fit the safe, end and key rooms and their rings
+  FDungeonGrid& Grid = Layout.Grid;
+  Grid.Reset(FIntPoint(-Origin.X - 2, -Origin.Y - 2), Size + 4, Size + 4);
+  for (int32 Index = 0; Index < Size * Size; Index++)
+  {
+    const uint8 Doors = WaveCollapse.GetDoors(Index % Size, Index / Size);
+    if (Doors == DungeonDoor::None || Pieces.Find(Index) != LargestPiece) continue;
+
+    const FIntPoint Cell = FIntPoint(Index % Size, Index / Size) - Origin;
+    Grid.Occupy(Cell);
+    Grid.SetDoors(Grid.ToIndex(Cell), Doors);
+  }
+  return true;
+}
+
+bool FDungeonLayoutGenerator::AttachSafeAndEndRooms()
+{
+  FDungeonGrid& Grid = Layout.Grid;
+
+  // The safe room goes as far west as the rules let it, off a room with nothing to its
+  // west, and the end room as far east. A door may turn a dead end into a straight
+  // that now ends in the new room, or a junction into a crossroad next to another.
+  auto Attach = [this, &Grid](int32 Direction, FIntPoint& OutRoom)
+    {
+      const FIntPoint Offset = DungeonDoor::Offsets[Direction];
+      const FIntPoint* Best = nullptr;
+      for (const FIntPoint& Room : Grid.GetCells())
+      {
+        if ((Best && (Room.X - Best->X) * Offset.X <= 0) || Grid.IsOccupied(Room + Offset) || !CanAttachRoom(Room, Direction)) continue;
+
+        Best = &Room;
+      }
+      if (!Best) return false;
+
+      const FIntPoint From = *Best;
+      OutRoom = From + Offset;
+      Grid.Occupy(OutRoom);
+      Grid.Connect(From, OutRoom);
+      return true;
+    };
+  return Attach(3, Layout.SafeRoom) && Attach(1, Layout.EndRoom);
+}
+
+bool FDungeonLayoutGenerator::CanAttachRoom(FIntPoint Room, int32 Direction) const
+{
+  const FDungeonGrid& Grid = Layout.Grid;
+  const uint8 Door = DungeonDoor::FromIndex(Direction);
+  const FIntPoint NewRoom = Room + DungeonDoor::Offsets[Direction];
+  auto DoorsAfter = [&](FIntPoint Cell)
+    {
+      return Cell == Room ? (uint8)(Grid.GetDoors(Room) | Door) : Cell == NewRoom ? DungeonDoor::Opposite(Door) : Grid.GetDoors(Cell);
+    };
+
+  for (const FIntPoint& Cell : { Room, NewRoom })
+  {
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      if (!GetFloorRules().Allows(DoorsAfter(Cell), Dir, DoorsAfter(Cell + DungeonDoor::Offsets[Dir]))) return false;
+    }
+  }
+  return true;
+}
+
+void FDungeonLayoutGenerator::GrowRooms()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonGrowRooms);
+  FDungeonGrid& Grid = Layout.Grid;
+
+  // Rooms grow out from the origin with Y >= 0. Start with a box that fits a compact
+  // floor; the grid grows if the layout spreads further.
+  int32 InitialExtent = FMath::CeilToInt(FMath::Sqrt((float)Params.CellCount)) * 2 + 4;
+  Grid.Reset(FIntPoint(-InitialExtent / 2, -2), InitialExtent, InitialExtent);
+
+  // Generate room positions
+  FIntPoint StartPos(0, 0);
+  Grid.Occupy(StartPos);
+  AddAdjacentPositions(StartPos);
+
+  // Force room 1 to be a dead end by only adding one neighbor initially
+  if (AvailablePositions.Num() > 0)
+  {
+    int32 RandomIndex = GrowthStream.RandRange(0, AvailablePositions.Num() - 1);
+    FIntPoint FirstRoom = AvailablePositions.RemoveAt(RandomIndex);
+    Grid.Occupy(FirstRoom);
+    AddAdjacentPositions(FirstRoom);
+  }
+
+  for (int32 i = 2; i < Params.CellCount; i++)
+  {
+    if (AvailablePositions.Num() == 0)
+    {
+      UE_LOG(LogTemp, Warning, TEXT("No more available positions for rooms!"));
+      Layout.bRanOutOfPositions = true;
+      break;
+    }
+
+    if ((i & 1023) == 0 && IsCancelled()) return;
+
+    int32 RandomIndex = GrowthStream.RandRange(0, AvailablePositions.Num() - 1);
+    FIntPoint NewPos = AvailablePositions.RemoveAt(RandomIndex);
+
+    Grid.Occupy(NewPos);
+    AddAdjacentPositions(NewPos);
+  }
+}
+
+void FDungeonLayoutGenerator::PlaceSafeAndEndRooms()
+{
+  FDungeonGrid& Grid = Layout.Grid;
+
+  // Add SafeRoom at furthest west position
+  FIntPoint SafeRoomPos(0, 0);
+  int32 MinX = 0;
+  for (const FIntPoint& Pos : Grid.GetCells())
+  {
+    if (Pos.X < MinX)
+    {
+      MinX = Pos.X;
+      SafeRoomPos = Pos;
+    }
+  }
+  SafeRoomPos.X -= 1; // Place one cell west of current westernmost
+  Layout.SafeRoom = SafeRoomPos;
+  Grid.Occupy(SafeRoomPos);
+  AvailablePositions.Remove(SafeRoomPos);
+  AddAdjacentPositions(SafeRoomPos);
+
+  // Add EndRoom at furthest east position
+  FIntPoint EndRoomPos(0, 0);
+  int32 MaxX = 0;
+  for (const FIntPoint& Pos : Grid.GetCells())
+  {
+    if (Pos.X > MaxX)
+    {
+      MaxX = Pos.X;
+      EndRoomPos = Pos;
+    }
+  }
+  EndRoomPos.X += 1; // Place one cell east of current easternmost
+  Layout.EndRoom = EndRoomPos;
+  Grid.Occupy(EndRoomPos);
+  AvailablePositions.Remove(EndRoomPos);
+  AddAdjacentPositions(EndRoomPos);
+}
+
+void FDungeonLayoutGenerator::CreateMinimalConnections()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonMinimalConnections);
+  FDungeonGrid& Grid = Layout.Grid;
+
+  // A random spanning tree (Kruskal over shuffled edges), so corridors branch
+  // anywhere instead of radiating from the origin like a breadth-first tree
+  TDungeonArenaArray<FDungeonEdge> Edges;
+  Edges.Init(Arena, Grid.NumCells() * 2);
+  for (const FIntPoint& Pos : Grid.GetCells())
+  {
+    const int32 Index = Grid.ToIndex(Pos);
+    for (int32 Dir : EdgeDirections)
+    {
+      if (Grid.IsOccupied(Grid.Neighbour(Index, Dir)))
+      {
+        Edges.Add({ Index, Dir });
+      }
+    }
+  }
+  for (int32 i = Edges.Num() - 1; i > 0; i--)
+  {
+    Edges.Swap(i, ConnectionStream.RandRange(0, i));
+  }
+
+  FDungeonDisjointSet Joined;
+  Joined.Init(Arena, Grid.NumIndices());
+  int32 TreeDoors = 0;
+  for (const FDungeonEdge& Edge : Edges)
+  {
+    if (TreeDoors == Grid.NumCells() - 1) break;
+
+    if (Joined.Union(Edge.Index, Grid.Neighbour(Edge.Index, Edge.Direction)))
+    {
+      Grid.ConnectNeighbour(Edge.Index, Edge.Direction);
+      TreeDoors++;
+    }
+  }
+}
+
+void FDungeonLayoutGenerator::CreateLockedArea()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonLockedArea);
+  FDungeonGrid& Grid = Layout.Grid;
+  if (Grid.NumCells() < 5) return;
+
+  // Taking doors away would break a collapsed floor's rules
+  if (bCollapsedFloor)
+  {
+    LockBeyondBridge();
+    PlaceKeyRoom();
+    return;
+  }
+
+  // The locked area grows from the room farthest from the safe room by path
+  CalculateAccessibleArea();
+  FIntPoint FarthestRoom(0, 0);
+  int32 MaxDistance = 0;
+  for (const FIntPoint& Pos : Grid.GetCells())
+  {
+    int32 Distance = Layout.SafeRoomDistances[Grid.ToIndex(Pos)];
+    if (Distance > MaxDistance)
+    {
+      MaxDistance = Distance;
+      FarthestRoom = Pos;
+    }
+  }
+
+  int32 TargetLockedRooms = FMath::Max(2, FMath::CeilToInt(Grid.NumCells() * Params.LockedAreaSizePercent));
+
+  // Minimal connections leave a tree of doors, so a room the tracker won't lock on its
+  // own is one with unlocked rooms below it, seen from the safe room. Such a room is
+  // locked together with those rooms when they all fit in what is left of the target.
+  // Preorder lays every subtree out as one run of SubtreeSizes rooms, and LockedRuns
+  // counts the rooms of a run that are locked already. A room's parent is the door
+  // neighbour one step nearer the safe room.
+  const TArray<int32>& Distances = Layout.SafeRoomDistances;
+  const int32 SafeRoom = Grid.ToIndex(Layout.SafeRoom);
+  TDungeonArenaArray<int32> Preorder;
+  Preorder.Init(Arena, Grid.NumCells());
+  TDungeonArenaArray<int32> Positions;
+  Positions.Init(Arena, INDEX_NONE, Grid.NumIndices());
+
+  Queue.Reset();
+  Queue.Add(SafeRoom);
+  while (Queue.Num() > 0)
+  {
+    const int32 Room = Queue.Pop();
+    Positions[Room] = Preorder.Add(Room);
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      const int32 Next = Grid.Neighbour(Room, Dir);
+      if ((Grid.GetDoors(Room) & DungeonDoor::FromIndex(Dir)) && Distances[Next] == Distances[Room] + 1)
+      {
+        Queue.Add(Next);
+      }
+    }
+  }
+
+  TDungeonArenaArray<int32> SubtreeSizes;
+  SubtreeSizes.Init(Arena, 1, Preorder.Num());
+  for (int32 Position = Preorder.Num() - 1; Position > 0; Position--)
+  {
+    const int32 Room = Preorder[Position];
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      const int32 Parent = Grid.Neighbour(Room, Dir);
+      if ((Grid.GetDoors(Room) & DungeonDoor::FromIndex(Dir)) && Distances[Parent] == Distances[Room] - 1)
+      {
+        SubtreeSizes[Positions[Parent]] += SubtreeSizes[Position];
+        break;
+      }
+    }
+  }
+
+  FMarkedPositions LockedRuns;
+  LockedRuns.Init(Arena, Preorder.Num());
+
+  const int32 FirstLocked = Grid.ToIndex(FarthestRoom);
+  Grid.SetFlag(FirstLocked, DungeonCell::Locked);
+  Layout.LockedRoomCount = 1;
+  if (Positions[FirstLocked] != INDEX_NONE)
+  {
+    LockedRuns.Mark(Positions[FirstLocked]);
+  }
+  Queue.Add(FirstLocked);
+
+  // Every unlocked room must stay reachable from the safe room without crossing locked
+  // rooms. The tracker answers that per candidate without a fresh BFS.
+  LockTracker.Build(Arena, Grid, Layout.SafeRoom);
+
+  auto LockRoom = [&](int32 Room)
+    {
+      Grid.SetFlag(Room, DungeonCell::Locked);
+      LockTracker.OnLocked(Room);
+      LockedRuns.Mark(Positions[Room]);
+      Layout.LockedRoomCount++;
+    };
+
+  for (int32 i = 0; i < Queue.Num() && Layout.LockedRoomCount < TargetLockedRooms; i++)
+  {
+    int32 Directions[DungeonDoor::NumDirections] = { 0, 1, 2, 3 };
+
+    // Shuffle neighbors for randomness
+    for (int32 j = DungeonDoor::NumDirections - 1; j > 0; j--)
+      Swap(Directions[j], Directions[LockedAreaStream.RandRange(0, j)]);
+
+    for (int32 Direction : Directions)
+    {
+      if (Layout.LockedRoomCount >= TargetLockedRooms) break;
+
+      const int32 Neighbor = Grid.Neighbour(Queue[i], Direction);
+      if (!Grid.IsOccupied(Neighbor) || Grid.HasFlag(Neighbor, DungeonCell::Locked)) continue;
+
+      if (LockTracker.CanLock(Neighbor))
+      {
+        // Keep this room in locked area and add to queue for expansion
+        LockRoom(Neighbor);
+        Queue.Add(Neighbor);
+        continue;
+      }
+
+      // The safe room is the root, and an unreached room has no run
+      const int32 First = Positions[Neighbor];
+      if (Neighbor == SafeRoom || First == INDEX_NONE) continue;
+
+      const int32 End = First + SubtreeSizes[First];
+      const int32 Unlocked = End - First - (LockedRuns.CountBelow(End) - LockedRuns.CountBelow(First));
+      if (Unlocked > TargetLockedRooms - Layout.LockedRoomCount) continue;
+
+      // Locked rooms have everything below them locked too, so each is skipped with its
+      // run. The rest go deepest first, each a leaf of the unlocked tree by its turn.
+      const int32 FirstNew = Queue.Num();
+      for (int32 Position = First; Position < End;)
+      {
+        const int32 Room = Preorder[Position];
+        if (Grid.HasFlag(Room, DungeonCell::Locked))
+        {
+          Position += SubtreeSizes[Position];
+          continue;
+        }
+        Queue.Add(Room);
+        Position++;
+      }
+      for (int32 j = Queue.Num() - 1; j >= FirstNew; j--)
+      {
+        checkSlow(LockTracker.CanLock(Queue[j]));
+        LockRoom(Queue[j]);
+      }
+    }
+  }
+
+  // The tracker never lets a lock cut an unlocked room off from the safe room. Slow
+  // guard builds confirm that on floors small enough for the bitboard.
+#if DO_GUARD_SLOW
+  if (FDungeonBitboard::Fits(Grid))
+  {
+    Bitboard.Build(Grid, EDungeonBitboardEdges::Doors, DungeonCell::Locked);
+    checkSlow(Bitboard.ReachesAll(SafeRoom));
+  }
+#endif
+
+  RemoveLockedAreaConnections();
+  CreateSingleLockedConnection();
+  PlaceKeyRoom();
+}
+
+void FDungeonLayoutGenerator::LockBeyondBridge()
+{
+  FDungeonGrid& Grid = Layout.Grid;
+  const int32 TargetLockedRooms = FMath::Max(2, FMath::CeilToInt(Grid.NumCells() * Params.LockedAreaSizePercent));
+
+  // Depth-first search over doors from the safe room. The door down to a room is a
+  // bridge when nothing below that room links back above it, and everything below it
+  // is then sealed off by that one door: the rooms discovered from its discovery time
+  // for as many as its subtree holds.
+  struct FFrame
+  {
+    int32 Index;
+    int32 InDirection;
+    int32 NextDirection;
+  };
+  TDungeonArenaArray<FFrame> Frames;
+  Frames.Init(Arena, Grid.NumCells());
+  TDungeonArenaArray<int32> Discovery;
+  Discovery.Init(Arena, 0, Grid.NumIndices());
+  TDungeonArenaArray<int32> Low;
+  Low.Init(Arena, 0, Grid.NumIndices());
+  TDungeonArenaArray<int32> SubtreeSizes;
+  SubtreeSizes.Init(Arena, 1, Grid.NumIndices());
+  TDungeonArenaArray<int32> InDiscoveryOrder;
+  InDiscoveryOrder.Init(Arena, Grid.NumCells() + 1);
+  InDiscoveryOrder.Add(INDEX_NONE);
+
+  // The bridge whose far side comes closest to the target, ties broken at random
+  int32 BestRoom = INDEX_NONE;
+  int32 BestDirection = 0;
+  int32 BestScore = MAX_int32;
+  int32 NumBest = 0;
+
+  const int32 SafeRoom = Grid.ToIndex(Layout.SafeRoom);
+  Discovery[SafeRoom] = Low[SafeRoom] = InDiscoveryOrder.Add(SafeRoom);
+  Frames.Add({ SafeRoom, INDEX_NONE, 0 });
+  while (Frames.Num() > 0)
+  {
+    FFrame& Frame = Frames.Last();
+    const int32 Current = Frame.Index;
+    if (Frame.NextDirection < DungeonDoor::NumDirections)
+    {
+      const int32 Dir = Frame.NextDirection++;
+      if (!(Grid.GetDoors(Current) & DungeonDoor::FromIndex(Dir))) continue;
+      if (Frame.InDirection != INDEX_NONE && Dir == (Frame.InDirection + 2) % DungeonDoor::NumDirections) continue;
+
+      const int32 Next = Grid.Neighbour(Current, Dir);
+      if (Discovery[Next] == 0)
+      {
+        Discovery[Next] = Low[Next] = InDiscoveryOrder.Add(Next);
+        Frames.Add({ Next, Dir, 0 });
+      }
+      else
+      {
+        Low[Current] = FMath::Min(Low[Current], Discovery[Next]);
+      }
+      continue;
+    }
+
+    const FFrame Done = Frames.Pop();
+    if (Frames.Num() == 0) break;
+
+    const int32 Parent = Frames.Last().Index;
+    Low[Parent] = FMath::Min(Low[Parent], Low[Done.Index]);
+    SubtreeSizes[Parent] += SubtreeSizes[Done.Index];
+    if (Low[Done.Index] <= Discovery[Parent]) continue;
+
+    const int32 Score = FMath::Abs(SubtreeSizes[Done.Index] - TargetLockedRooms);
+    if (Score < BestScore)
+    {
+      BestScore = Score;
+      NumBest = 0;
+    }
+    if (Score == BestScore && LockedAreaStream.RandRange(0, NumBest++) == 0)
+    {
+      BestRoom = Done.Index;
+      BestDirection = (Done.InDirection + 2) % DungeonDoor::NumDirections;
+    }
+  }
+
+  // The end room always hangs off a bridge, so there is one
+  if (BestRoom == INDEX_NONE) return;
+
+  const int32 FirstLocked = Discovery[BestRoom];
+  for (int32 Time = FirstLocked; Time < FirstLocked + SubtreeSizes[BestRoom]; Time++)
+  {
+    Grid.SetFlag(InDiscoveryOrder[Time], DungeonCell::Locked);
+  }
+  Layout.LockedRoomCount = SubtreeSizes[BestRoom];
+
+  Layout.bHasLockedDoor = true;
+  Layout.LockedDoorRoom = Grid.ToCell(BestRoom);
+  Layout.LockedDoorNeighbour = Layout.LockedDoorRoom + DungeonDoor::Offsets[BestDirection];
+  for (int32 Facing = 0; Facing < DungeonDoor::NumDirections; Facing++)
+  {
+    if (LockedDoorFacings[Facing] == DungeonDoor::Offsets[BestDirection])
+    {
+      Layout.LockedDoorFacing = Facing;
+    }
+  }
+}
+
+void FDungeonLayoutGenerator::RemoveLockedAreaConnections()
+{
+  FDungeonGrid& Grid = Layout.Grid;
+
+  for (const FIntPoint& LockedRoom : Grid.GetCells())
+  {
+    if (!Grid.HasFlag(LockedRoom, DungeonCell::Locked)) continue;
+
+    for (const FIntPoint& Offset : DungeonDoor::Offsets)
+    {
+      FIntPoint Neighbor = LockedRoom + Offset;
+      if (Grid.IsOccupied(Neighbor) && !Grid.HasFlag(Neighbor, DungeonCell::Locked))
+      {
+        Grid.Disconnect(LockedRoom, Neighbor);
+      }
+    }
+  }
+}
+
+void FDungeonLayoutGenerator::CreateSingleLockedConnection()
+{
+  FDungeonGrid& Grid = Layout.Grid;
+
+  struct FConnection
+  {
+    FIntPoint Locked;
+    FIntPoint Unlocked;
+    int32 Facing;
+  };
+
+  // Every locked room has at most four unlocked neighbours
+  TDungeonArenaArray<FConnection> PossibleConnections;
+  PossibleConnections.Init(Arena, Layout.LockedRoomCount * DungeonDoor::NumDirections);
+
+  for (const FIntPoint& LockedRoom : Grid.GetCells())
+  {
+    if (!Grid.HasFlag(LockedRoom, DungeonCell::Locked)) continue;
+
+    for (int32 i = 0; i < DungeonDoor::NumDirections; i++)
+    {
+      FIntPoint Neighbor = LockedRoom + LockedDoorFacings[i];
+      if (Grid.IsOccupied(Neighbor) && !Grid.HasFlag(Neighbor, DungeonCell::Locked))
+      {
+        PossibleConnections.Add({ LockedRoom, Neighbor, i });
+      }
+    }
+  }
+
+  if (PossibleConnections.Num() > 0)
+  {
+    FConnection ChosenConnection = PossibleConnections[LockedDoorStream.RandRange(0, PossibleConnections.Num() - 1)];
+    Layout.bHasLockedDoor = true;
+    Layout.LockedDoorRoom = ChosenConnection.Locked;
+    Layout.LockedDoorNeighbour = ChosenConnection.Unlocked;
+    Layout.LockedDoorFacing = ChosenConnection.Facing;
+
+    Grid.Connect(ChosenConnection.Locked, ChosenConnection.Unlocked);
+  }
+}
+
+void FDungeonLayoutGenerator::PlaceKeyRoom()
+{
+  FDungeonGrid& Grid = Layout.Grid;
+  MarkAccessibleArea();
+
+  // Shuffle accessible rooms for randomness
+  TDungeonArenaArray<FIntPoint> ShuffledRooms;
+  ShuffledRooms.Init(Arena, Layout.AccessibleRoomCount);
+  for (const FIntPoint& Room : Grid.GetCells())
+  {
+    if (Grid.HasFlag(Room, DungeonCell::Accessible))
+    {
+      ShuffledRooms.Add(Room);
+    }
+  }
+  for (int32 i = ShuffledRooms.Num() - 1; i > 0; i--)
+  {
+    ShuffledRooms.Swap(i, KeyRoomStream.RandRange(0, i));
+  }
+
+  const FIntPoint SafeRoomGridPos = Layout.SafeRoom;
+  const FIntPoint EndRoomGridPos = Layout.EndRoom;
+
+  // Try each accessible room until we find an empty adjacent spot
+  for (const FIntPoint& Room : ShuffledRooms)
+  {
+    if (Room == SafeRoomGridPos || Room == EndRoomGridPos) continue;
+
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      FIntPoint Candidate = Room + DungeonDoor::Offsets[Dir];
+
+      if (!Grid.IsOccupied(Candidate) &&
+        FMath::Abs(Candidate.X - SafeRoomGridPos.X) + FMath::Abs(Candidate.Y - SafeRoomGridPos.Y) > 1 &&
+        FMath::Abs(Candidate.X - EndRoomGridPos.X) + FMath::Abs(Candidate.Y - EndRoomGridPos.Y) > 1 &&
+        (!bCollapsedFloor || CanAttachRoom(Room, Dir)))
+      {
+        Layout.bHasKeyRoom = true;
+        Layout.KeyRoom = Candidate;
+        Grid.Occupy(Candidate);
+        Grid.Connect(Room, Candidate);
+        return; // Done!
+      }
+    }
+  }
+}
+
+void FDungeonLayoutGenerator::AddExtraDoors()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonExtraDoors);
+  FDungeonGrid& Grid = Layout.Grid;
+
+  FDungeonDisjointSet Joined;
+  Joined.Init(Arena, Grid.NumIndices());
+  for (const FIntPoint& Pos : Grid.GetCells())
+  {
+    const int32 Index = Grid.ToIndex(Pos);
+    for (int32 Dir : EdgeDirections)
+    {
+      if (Grid.GetDoors(Index) & DungeonDoor::FromIndex(Dir))
+      {
+        Joined.Union(Index, Grid.Neighbour(Index, Dir));
+      }
+    }
+  }
+
+  // Adjacent pairs without a door, on the same side of the locked boundary
+  TDungeonArenaArray<FDungeonEdge> Candidates;
+  Candidates.Init(Arena, Grid.NumCells() * 2);
+  for (const FIntPoint& Pos : Grid.GetCells())
+  {
+    const int32 Index = Grid.ToIndex(Pos);
+    const bool bIsLocked = Grid.HasFlag(Index, DungeonCell::Locked);
+    for (int32 Dir : EdgeDirections)
+    {
+      const int32 Neighbor = Grid.Neighbour(Index, Dir);
+      if (Grid.IsOccupied(Neighbor) && !(Grid.GetDoors(Index) & DungeonDoor::FromIndex(Dir)) &&
+        bIsLocked == Grid.HasFlag(Neighbor, DungeonCell::Locked))
+      {
+        Candidates.Add({ Index, Dir });
+      }
+    }
+  }
+  for (int32 i = Candidates.Num() - 1; i > 0; i--)
+  {
+    Candidates.Swap(i, ExtraDoorStream.RandRange(0, i));
+  }
+
+  // Cutting the locked area out of the tree can split it into pieces the locked door
+  // doesn't reach. Pairs that join two pieces get their door first; that closes no
+  // loop. Every pair left is already joined, so each door among them closes exactly one.
+  int32 NumLoopCandidates = 0;
+  for (const FDungeonEdge& Edge : Candidates)
+  {
+    if (Joined.Union(Edge.Index, Grid.Neighbour(Edge.Index, Edge.Direction)))
+    {
+      Grid.ConnectNeighbour(Edge.Index, Edge.Direction);
+    }
+    else
+    {
+      Candidates[NumLoopCandidates++] = Edge;
+    }
+  }
+
+  // Collapsed floors already have the loops their rules allow, and a new door would
+  // change the shape of both of its rooms
+  const float LoopFraction = bCollapsedFloor ? 0.0f : Params.LoopFraction;
+  const int32 LoopCount = FMath::Clamp(FMath::RoundToInt(LoopFraction * NumLoopCandidates), 0, NumLoopCandidates);
+  if (LoopCount == 0) return;
+
+  // A shortcut scores the doors it saves on the walk from the safe room to the farther
+  // of its two rooms. Scores are not refreshed as doors go in; that would take a
+  // search per door.
+  CalculateAccessibleArea();
+  const TArray<int32>& Distances = Layout.SafeRoomDistances;
+  TDungeonArenaArray<int32> Scores;
+  Scores.Init(Arena, NumLoopCandidates);
+  int32 MaxScore = 0;
+  for (int32 i = 0; i < NumLoopCandidates; i++)
+  {
+    const int32 Index = Candidates[i].Index;
+    const int32 Neighbor = Grid.Neighbour(Index, Candidates[i].Direction);
+    Scores.Add(FMath::Max(0, FMath::Abs(Distances[Index] - Distances[Neighbor]) - 1));
+    MaxScore = FMath::Max(MaxScore, Scores.Last());
+  }
+
+  // Counting sort by descending score. The shuffle above leaves equal shortcuts in
+  // random order.
+  TDungeonArenaArray<int32> FirstSlots;
+  FirstSlots.Init(Arena, 0, MaxScore + 2);
+  for (int32 Score : Scores)
+  {
+    FirstSlots[MaxScore - Score + 1]++;
+  }
+  for (int32 Bucket = 1; Bucket < FirstSlots.Num(); Bucket++)
+  {
+    FirstSlots[Bucket] += FirstSlots[Bucket - 1];
+  }
+
+  TDungeonArenaArray<FDungeonEdge> Ranked;
+  Ranked.Init(Arena, FDungeonEdge{ INDEX_NONE, 0 }, NumLoopCandidates);
+  for (int32 i = 0; i < NumLoopCandidates; i++)
+  {
+    Ranked[FirstSlots[MaxScore - Scores[i]]++] = Candidates[i];
+  }
+
+  for (int32 i = 0; i < LoopCount; i++)
+  {
+    Grid.ConnectNeighbour(Ranked[i].Index, Ranked[i].Direction);
+  }
+}
+
+void FDungeonLayoutGenerator::CalculateAccessibleArea()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonAccessibleArea);
+  FDungeonGrid& Grid = Layout.Grid;
+
+  for (const FIntPoint& Room : Grid.GetCells())
+  {
+    Grid.ClearFlag(Grid.ToIndex(Room), DungeonCell::Accessible);
+  }
+  Layout.AccessibleRoomCount = 0;
+
+  // The same search fills the distance field, so it always matches the current doors.
+  // The grid may have grown since the last pass, hence the full reset.
+  Layout.SafeRoomDistances.Init(INDEX_NONE, Grid.NumIndices());
+  Layout.MaxSafeRoomDistance = 0;
+
+  if (!Grid.IsOccupied(Layout.SafeRoom)) return;
+
+  bBitboardSearch = FDungeonBitboard::Fits(Grid) && Grid.NumCells() >= MinBitboardSearchCells;
+  if (bBitboardSearch)
+  {
+    BuildDoorBitboard();
+    BitboardVisited.Reset();
+  }
+  Queue.Reset();
+
+  int32 Start = Grid.ToIndex(Layout.SafeRoom);
+  Layout.SafeRoomDistances[Start] = 0;
+  Layout.MaxSafeRoomDistance = SpreadSafeRoomDistances(Start, true, Layout.AccessibleRoomCount);
+
+  // The locked area is only joined through the locked door, so carrying on from its
+  // far side gives the rest of the field without changing any distance found so far
+  if (Layout.bHasLockedDoor)
+  {
+    const int32 LockedDoorA = Grid.ToIndex(Layout.LockedDoorRoom);
+    const int32 LockedDoorB = Grid.ToIndex(Layout.LockedDoorNeighbour);
+    int32& DistanceA = Layout.SafeRoomDistances[LockedDoorA];
+    int32& DistanceB = Layout.SafeRoomDistances[LockedDoorB];
+    if ((DistanceA == INDEX_NONE) != (DistanceB == INDEX_NONE))
+    {
+      const int32 FarSide = DistanceA == INDEX_NONE ? LockedDoorA : LockedDoorB;
+      Layout.SafeRoomDistances[FarSide] = FMath::Max(DistanceA, DistanceB) + 1;
+      int32 LockedSideRooms = 0;
+      Layout.MaxSafeRoomDistance = FMath::Max(Layout.MaxSafeRoomDistance, SpreadSafeRoomDistances(FarSide, false, LockedSideRooms));
+    }
+  }
+}
+
+void FDungeonLayoutGenerator::MarkAccessibleArea()
+{
+  // The key room only needs to know which rooms are reachable, which the bitboard
+  // answers in one fill. The distances are redone once the floor is finished anyway.
+  FDungeonGrid& Grid = Layout.Grid;
+  if (!FDungeonBitboard::Fits(Grid) || !Grid.IsOccupied(Layout.SafeRoom))
+  {
+    CalculateAccessibleArea();
+    return;
+  }
+
+  SCOPE_CYCLE_COUNTER(STAT_DungeonAccessibleArea);
+  for (const FIntPoint& Room : Grid.GetCells())
+  {
+    Grid.ClearFlag(Grid.ToIndex(Room), DungeonCell::Accessible);
+  }
+
+  BuildDoorBitboard();
+  FDungeonBitboard::FRows Reached;
+  Reached.Reset();
+  Bitboard.SetCell(Reached, Grid.ToIndex(Layout.SafeRoom));
+  Bitboard.Fill(Reached);
+
+  Layout.AccessibleRoomCount = 0;
+  Bitboard.ForEachCell(Reached, [this, &Grid](int32 Index)
+    {
+      Grid.SetFlag(Index, DungeonCell::Accessible);
+      Layout.AccessibleRoomCount++;
+    });
+}
+
+void FDungeonLayoutGenerator::BuildDoorBitboard()
+{
+  // The bitboard can't tell the locked door from any other, so it leaves that door out
+  const FDungeonGrid& Grid = Layout.Grid;
+  Bitboard.Build(Grid, EDungeonBitboardEdges::Doors);
+  if (Layout.bHasLockedDoor)
+  {
+    Bitboard.RemoveDoor(Grid.ToIndex(Layout.LockedDoorRoom), DungeonDoor::Between(Layout.LockedDoorRoom, Layout.LockedDoorNeighbour));
+  }
+}
+
+int32 FDungeonLayoutGenerator::SpreadSafeRoomDistances(int32 Start, bool bMarkAccessible, int32& OutReached)
+{
+  FDungeonGrid& Grid = Layout.Grid;
+  TArray<int32>& Distances = Layout.SafeRoomDistances;
+
+  if (bBitboardSearch)
+  {
+    // Consecutive levels take turns in the two row sets, by the parity of their distance
+    int32 Distance = Distances[Start];
+    FDungeonBitboard::FRows Levels[2];
+    Levels[0].Reset();
+    Levels[1].Reset();
+    Bitboard.SetCell(Levels[Distance & 1], Start);
+    Bitboard.SetCell(BitboardVisited, Start);
+    if (bMarkAccessible)
+    {
+      Grid.SetFlag(Start, DungeonCell::Accessible);
+    }
+
+    OutReached = 1;
+    while (Bitboard.Step(Levels[Distance & 1], BitboardVisited, Levels[(Distance + 1) & 1]))
+    {
+      Distance++;
+      Bitboard.ForEachCell(Levels[Distance & 1], [&](int32 Index)
+        {
+          Distances[Index] = Distance;
+          if (bMarkAccessible)
+          {
+            Grid.SetFlag(Index, DungeonCell::Accessible);
+          }
+          OutReached++;
+        });
+    }
+    INC_DWORD_STAT_BY(STAT_DungeonBFSVisits, OutReached);
+    return Distance;
+  }
+
+  const int32 FromHead = Queue.Num();
+  Queue.Add(Start);
+
+  const int32 LockedDoorA = Layout.bHasLockedDoor ? Grid.ToIndex(Layout.LockedDoorRoom) : INDEX_NONE;
+  const int32 LockedDoorB = Layout.bHasLockedDoor ? Grid.ToIndex(Layout.LockedDoorNeighbour) : INDEX_NONE;
+
+  for (int32 Head = FromHead; Head < Queue.Num(); Head++)
+  {
+    int32 Current = Queue[Head];
+    uint8 Doors = Grid.GetDoors(Current);
+    if (bMarkAccessible)
+    {
+      Grid.SetFlag(Current, DungeonCell::Accessible);
+    }
+
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      if (!(Doors & DungeonDoor::FromIndex(Dir))) continue;
+
+      int32 Neighbor = Grid.Neighbour(Current, Dir);
+      if (Distances[Neighbor] != INDEX_NONE) continue;
+
+      bool bIsLockedDoor = (Current == LockedDoorA && Neighbor == LockedDoorB) ||
+        (Current == LockedDoorB && Neighbor == LockedDoorA);
+
+      if (bIsLockedDoor)
+        continue;
+
+      Distances[Neighbor] = Distances[Current] + 1;
+      Queue.Add(Neighbor);
+    }
+  }
+  OutReached = Queue.Num() - FromHead;
+  INC_DWORD_STAT_BY(STAT_DungeonBFSVisits, OutReached);
+  return Distances[Queue.Last()];
+}
+
+void FDungeonLayoutGenerator::PlaceEnemies()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonPlaceEnemies);
+  const FDungeonGrid& Grid = Layout.Grid;
+  if (Grid.NumCells() == 0) return;
+
+  const int32 SlotCount = FMath::Min(Params.EnemyCount, Grid.NumCells());
+  if (SlotCount <= 0) return;
+
+  // Only the farthest SlotCount rooms are needed, so count rooms per distance and
+  // find the cutoff instead of sorting them all. Unreachable rooms come last.
+  const TArray<int32>& Distances = Layout.SafeRoomDistances;
+  TDungeonArenaArray<int32> RoomsAtDistance;
+  RoomsAtDistance.Init(Arena, 0, Layout.MaxSafeRoomDistance + 2);
+  for (const FIntPoint& Room : Grid.GetCells())
+  {
+    RoomsAtDistance[Distances[Grid.ToIndex(Room)] + 1]++;
+  }
+
+  int32 Cutoff = RoomsAtDistance.Num() - 1;
+  int32 Farther = 0;
+  while (Farther + RoomsAtDistance[Cutoff] < SlotCount)
+  {
+    Farther += RoomsAtDistance[Cutoff--];
+  }
+  int32 TakenAtCutoff = SlotCount - Farther;
+
+  // Rooms at the cutoff distance are taken in cell order
+  TArray<FIntPoint>& Slots = Layout.EnemySlots;
+  Slots.Reserve(SlotCount);
+  for (const FIntPoint& Room : Grid.GetCells())
+  {
+    const int32 Bucket = Distances[Grid.ToIndex(Room)] + 1;
+    if (Bucket > Cutoff || (Bucket == Cutoff && TakenAtCutoff-- > 0))
+    {
+      Slots.Add(Room);
+    }
+  }
+
+  Slots.StableSort([&Grid, &Distances](const FIntPoint& A, const FIntPoint& B) {
+    return Distances[Grid.ToIndex(A)] > Distances[Grid.ToIndex(B)];
+    });
+}
+
+void FDungeonLayoutGenerator::AddAdjacentPositions(FIntPoint Pos)
+{
+  for (const FIntPoint& Dir : DungeonDoor::Offsets)
+  {
+    FIntPoint AdjacentPos = Pos + Dir;
+
+    if (AdjacentPos.Y >= 0 && !Layout.Grid.IsOccupied(AdjacentPos))
+    {
+      AvailablePositions.Add(AdjacentPos);
+    }
+  }
+}
@@ -0,0 +1,264 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+#include "DungeonArena.h"
+#include "DungeonFrontier.h"
+#include "DungeonArticulation.h"
+#include "DungeonDisjointSet.h"
+#include "DungeonBitboard.h"
+#include "DungeonWaveCollapse.h"
+#include <atomic>
+
+// Independent random streams, one per consumer. Adding draws to one phase never
+// shifts the numbers another phase sees.
+enum class EDungeonRandomStream : uint32
+{
+  Growth,
+  LockedArea,
+  LockedDoor,
+  KeyRoom,
+  ExtraDoors,
+  RoomSelection,
+  Connections,
+  WaveCollapse
+};
+
+// How a floor's rooms and doors are laid out
+enum class EDungeonLayoutEngine : uint8
+{
+  // Rooms grow one at a time from the origin, then a random spanning tree joins them
+  Growth,
+  // Wave function collapse over the 16 door masks, with adjacency rules between
+  // them. Rooms and doors come out together, so CellCount is only approximate: a
+  // floor has between CellCount / 2 and CellCount * 2 rooms besides the safe, end and
+  // key rooms. The later phases keep to the rules too, and a floor that can't falls
+  // back to growth. No room but the key room sits above Y = 0, as with growth.
+  WaveFunctionCollapse
+};
+
+// Inputs for one floor layout. The same params always produce the same layout.
+struct FDungeonLayoutParams
+{
+  int32 Seed = 0;
+  int32 CellCount = 15;
+  int32 EnemyCount = 3;
+  // Fraction of the extra doors a floor could take that it gets. Each one closes
+  // exactly one loop, and the shortcuts that save the longest walk go in first.
+  float LoopFraction = 0.3f;
+  // Share of the rooms, key room aside, behind the locked door. Grown floors lock up to
+  // exactly that many; collapsed floors lock beyond the door that comes closest.
+  float LockedAreaSizePercent = 0.3f;
+  EDungeonLayoutEngine Engine = EDungeonLayoutEngine::Growth;
+
+  bool operator==(const FDungeonLayoutParams& Other) const
+  {
+    return Seed == Other.Seed && CellCount == Other.CellCount && EnemyCount == Other.EnemyCount &&
+      LoopFraction == Other.LoopFraction && LockedAreaSizePercent == Other.LockedAreaSizePercent &&
+      Engine == Other.Engine;
+  }
+};
+
+// Lets the requester stop a generation running on another thread. Shared by
+// pointer between both sides; the generator only reads it.
+class FDungeonLayoutCancellation
+{
+public:
+  void Cancel() { bCancelled.store(true, std::memory_order_relaxed); }
+  bool IsCancelled() const { return bCancelled.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<bool> bCancelled{ false };
+};
+
+// Wall time spent in each phase of one Generate call, in seconds. Growth includes
+// placing the safe and end rooms, and is the collapse itself on collapsed floors;
+// LockedArea includes the locked door and key room.
+struct FDungeonLayoutTimings
+{
+  double Growth = 0.0;
+  double MinimalConnections = 0.0;
+  double LockedArea = 0.0;
+  double ExtraDoors = 0.0;
+  double AccessibleArea = 0.0;
+  double Enemies = 0.0;
+
+  double GetTotal() const
+  {
+    return Growth + MinimalConnections + LockedArea + ExtraDoors + AccessibleArea + Enemies;
+  }
+};
+
+// A finished floor: occupied cells, door graph, locked area and special rooms.
+// Produced by FDungeonLayoutGenerator and read-only afterwards.
+class FDungeonLayout
+{
+public:
+  const FDungeonGrid& GetGrid() const { return Grid; }
+
+  int32 GetSeed() const { return Seed; }
+
+  FIntPoint GetSafeRoom() const { return SafeRoom; }
+  FIntPoint GetEndRoom() const { return EndRoom; }
+
+  bool HasKeyRoom() const { return bHasKeyRoom; }
+  FIntPoint GetKeyRoom() const { return KeyRoom; }
+
+  // The locked door joins LockedDoorRoom (inside the locked area) and LockedDoorNeighbour.
+  // Facing indexes North/East/South/West in the order SpawnLockedDoor expects.
+  bool HasLockedDoor() const { return bHasLockedDoor; }
+  FIntPoint GetLockedDoorRoom() const { return LockedDoorRoom; }
+  FIntPoint GetLockedDoorNeighbour() const { return LockedDoorNeighbour; }
+  int32 GetLockedDoorFacing() const { return LockedDoorFacing; }
+
+  int32 GetLockedRoomCount() const { return LockedRoomCount; }
+  int32 GetAccessibleRoomCount() const { return AccessibleRoomCount; }
+
+  // Doors between a room and the safe room, with the locked door counted as open.
+  // INDEX_NONE for cells the door graph doesn't reach.
+  int32 GetSafeRoomDistance(FIntPoint Cell) const
+  {
+    return Grid.IsOccupied(Cell) ? SafeRoomDistances[Grid.ToIndex(Cell)] : INDEX_NONE;
+  }
+
+  int32 GetMaxSafeRoomDistance() const { return MaxSafeRoomDistance; }
+
+  // Cells that receive an enemy, farthest from the safe room by path first
+  const TArray<FIntPoint>& GetEnemySlots() const { return EnemySlots; }
+
+  // Growth stopped before CellCount because no free position was left
+  bool RanOutOfPositions() const { return bRanOutOfPositions; }
+
+  bool IsEmpty() const { return Grid.NumCells() == 0; }
+
+private:
+  friend class FDungeonLayoutGenerator;
+  friend class FDungeonLayoutFormat;
+
+  FDungeonGrid Grid;
+  int32 Seed = 0;
+  FIntPoint SafeRoom = FIntPoint::ZeroValue;
+  FIntPoint EndRoom = FIntPoint::ZeroValue;
+  FIntPoint KeyRoom = FIntPoint::ZeroValue;
+  FIntPoint LockedDoorRoom = FIntPoint::ZeroValue;
+  FIntPoint LockedDoorNeighbour = FIntPoint::ZeroValue;
+  int32 LockedDoorFacing = 0;
+  int32 LockedRoomCount = 0;
+  int32 AccessibleRoomCount = 0;
+  TArray<int32> SafeRoomDistances; // Per grid index
+  int32 MaxSafeRoomDistance = 0;
+  TArray<FIntPoint> EnemySlots;
+  bool bHasKeyRoom = false;
+  bool bHasLockedDoor = false;
+  bool bRanOutOfPositions = false;
+};
+
+// Builds floor layouts without touching the engine. All scratch data lives on an
+// arena that is rewound at the start of each call, so once an instance has built a
+// floor of a given size, later floors up to that size make no scratch allocations.
+// Only the returned layout's own arrays come from the heap. One instance must not be
+// used from two threads at once.
+class DUNGEONLAYOUT_API FDungeonLayoutGenerator
+{
+public:
+  // Bump whenever a change makes a seed produce a different layout. Cached floors
+  // are keyed on it, so old ones stop matching.
+  static constexpr uint32 AlgorithmVersion = 4;
+
+  // Larger CellCounts are clamped to this, so a floor never has more than MaxRooms
+  // rooms whatever the engine
+  static constexpr int32 MaxCellCount = 100000;
+  static constexpr int32 MaxRooms = MaxCellCount * 2 + 3;
+
+  // Returns an empty layout if Cancellation fires before the layout is finished
+  FDungeonLayout Generate(const FDungeonLayoutParams& InParams, const FDungeonLayoutCancellation* InCancellation = nullptr);
+
+  // Derives a child seed. Uses a fixed integer mix rather than engine hashing so
+  // results match across platforms and engine versions.
+  static int32 MixSeed(int32 Seed, uint32 Salt);
+
+  // Substream for one consumer of a layout seed
+  static FRandomStream MakeStream(int32 Seed, EDungeonRandomStream Stream);
+
+  // Phase timings of the most recent Generate call
+  const FDungeonLayoutTimings& GetLastTimings() const { return Timings; }
+
+  // Scratch blocks the most recent Generate call took from the global allocator.
+  // Zero in steady state; non-zero only while the arena grows to a new largest floor.
+  int32 GetLastScratchAllocations() const { return LastScratchAllocations; }
+
+  // Whether the most recent Generate call kept a collapsed floor, as opposed to growing
+  // one, by choice or because the collapse fell back
+  bool WasLastFloorCollapsed() const { return bCollapsedFloor; }
+
+private:
+  // Phases, in the order Generate runs them. CollapseRooms replaces GrowRooms,
+  // PlaceSafeAndEndRooms and CreateMinimalConnections for the wave function collapse
+  // engine, and returns false if no field worked out within MaxCollapseAttempts.
+  // LockBeyondBridge replaces the growth of the locked area on collapsed floors.
+  bool CollapseRooms();
+  void GrowRooms();
+  void PlaceSafeAndEndRooms();
+  void CreateMinimalConnections();
+  void CreateLockedArea();
+  void LockBeyondBridge();
+  void RemoveLockedAreaConnections();
+  void CreateSingleLockedConnection();
+  void PlaceKeyRoom();
+  void AddExtraDoors();
+  void CalculateAccessibleArea();
+  void MarkAccessibleArea();
+  void PlaceEnemies();
+
+  // Collapsed floor helpers. TakeCollapsedPiece writes the field's largest piece to
+  // the grid if its size is in bounds; AttachSafeAndEndRooms fails if no side of the
+  // floor takes them within the rules. CanAttachRoom checks that a new dead end
+  // beyond the Direction side of Room, with a door to it, keeps both to the rules.
+  bool TakeCollapsedPiece(int32 Size);
+  bool AttachSafeAndEndRooms();
+  bool CanAttachRoom(FIntPoint Room, int32 Direction) const;
+
+  // Breadth-first distances from Start, which already has its own. Returns the
+  // farthest distance found and the number of rooms reached, Start included.
+  int32 SpreadSafeRoomDistances(int32 Start, bool bMarkAccessible, int32& OutReached);
+  void AddAdjacentPositions(FIntPoint Pos);
+  bool IsCancelled() const { return Cancellation && Cancellation->IsCancelled(); }
+  void EndPhase(double& OutSeconds);
+
+  FDungeonLayoutParams Params;
+  const FDungeonLayoutCancellation* Cancellation = nullptr;
+  FDungeonLayout Layout;
+  FDungeonLayoutTimings Timings;
+  double PhaseStartTime = 0.0;
+
+  FRandomStream GrowthStream;
+  FRandomStream LockedAreaStream;
+  FRandomStream LockedDoorStream;
+  FRandomStream KeyRoomStream;
+  FRandomStream ExtraDoorStream;
+  FRandomStream ConnectionStream;
+  FRandomStream WaveCollapseStream;
+
+  FDungeonArena Arena;
+  int32 LastScratchAllocations = 0;
+
+  FDungeonFrontier AvailablePositions;
+  FDungeonArticulationTracker LockTracker;
+  TDungeonArenaArray<int32> Queue;
+
+  // Floors that fit answer reachability with the bitboard kernel instead of Queue.
+  // Distance searches only switch over from MinBitboardSearchCells rooms, below
+  // which a level-by-level bitboard search is no faster than the queue.
+  static constexpr int32 MinBitboardSearchCells = 128;
+  void BuildDoorBitboard();
+  FDungeonBitboard Bitboard;
+  FDungeonBitboard::FRows BitboardVisited;
+  bool bBitboardSearch = false;
+
+  // A collapse that runs out of backtracks, or whose floor has too few or too many
+  // rooms or no place for the safe and end rooms, starts over on a fresh field; after
+  // MaxCollapseAttempts of those the floor grows rooms instead
+  static constexpr int32 MaxCollapseAttempts = 3;
+  static constexpr int32 MaxCollapseBacktracks = 256;
+  FDungeonWaveCollapse WaveCollapse;
+  bool bCollapsedFloor = false;
+};
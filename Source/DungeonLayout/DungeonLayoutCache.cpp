@@ -0,0 +1,93 @@
+// DungeonLayoutCache.cpp
+#include "DungeonLayoutCache.h"
+#include "DungeonLayoutFormat.h"
+#include "DungeonLayoutStats.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Load Cached Layout"), STAT_DungeonLoadCachedLayout, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Store Cached Layout"), STAT_DungeonStoreCachedLayout, STATGROUP_Dungeon);
+
+FString FDungeonLayoutCache::GetFileName(const FDungeonLayoutParams& Params)
+{
+  return FString::Printf(TEXT("%08x-%08x.dlay"), (uint32)Params.Seed, FDungeonLayoutFormat::HashParams(Params));
+}
+
+bool FDungeonLayoutCache::Load(const FDungeonLayoutParams& Params, FDungeonLayout& OutLayout) const
+{
+  LLM_SCOPE_BYTAG(Dungeon);
+  SCOPE_CYCLE_COUNTER(STAT_DungeonLoadCachedLayout);
+  const FString FileName = GetFileName(Params);
+  for (const FString& Directory : ReadDirectories)
+  {
+    if (LoadFile(Directory / FileName, Params, OutLayout)) return true;
+  }
+  return !WriteDirectory.IsEmpty() && LoadFile(WriteDirectory / FileName, Params, OutLayout);
+}
+
+bool FDungeonLayoutCache::LoadFile(const FString& Path, const FDungeonLayoutParams& Params, FDungeonLayout& OutLayout)
+{
+  IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+  if (!PlatformFile.FileExists(*Path)) return false;
+
+  bool bRead = false;
+  uint32 ParamsHash = 0;
+
+  // The region must go before the handle, hence the scope
+  {
+    TUniquePtr<IMappedFileHandle> Handle(PlatformFile.OpenMapped(*Path));
+    TUniquePtr<IMappedFileRegion> Region(Handle ? Handle->MapRegion(0, Handle->GetFileSize()) : nullptr);
+    if (Region)
+    {
+      bRead = FDungeonLayoutFormat::Read(Region->GetMappedPtr(), Region->GetMappedSize(), OutLayout, &ParamsHash);
+    }
+    else
+    {
+      // Compressed pak entries and some platforms can't be mapped
+      TArray<uint8> Data;
+      bRead = FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent) &&
+        FDungeonLayoutFormat::Read(Data.GetData(), Data.Num(), OutLayout, &ParamsHash);
+    }
+  }
+
+  if (!bRead || ParamsHash != FDungeonLayoutFormat::HashParams(Params) || OutLayout.GetSeed() != Params.Seed)
+  {
+    UE_LOG(LogTemp, Warning, TEXT("Ignoring stale or corrupt cached floor %s"), *Path);
+    OutLayout = FDungeonLayout();
+    return false;
+  }
+  return true;
+}
+
+bool FDungeonLayoutCache::Store(const FDungeonLayoutParams& Params, const FDungeonLayout& Layout) const
+{
+  if (WriteDirectory.IsEmpty() || Layout.IsEmpty()) return false;
+  SCOPE_CYCLE_COUNTER(STAT_DungeonStoreCachedLayout);
+
+  TArray<uint8> Data;
+  FDungeonLayoutFormat::Write(Layout, FDungeonLayoutFormat::HashParams(Params), Data);
+
+  // Written under a per-thread name and moved into place, so a reader or a second
+  // writer of the same floor never sees half a file
+  const FString Path = WriteDirectory / GetFileName(Params);
+  const FString TempPath = FString::Printf(TEXT("%s.%u.tmp"), *Path, FPlatformTLS::GetCurrentThreadId());
+  if (!FFileHelper::SaveArrayToFile(Data, *TempPath)) return false;
+  return IFileManager::Get().Move(*Path, *TempPath, true, true);
+}
+
+FDungeonLayout FDungeonLayoutCache::LoadOrGenerate(FDungeonLayoutGenerator& Generator, const FDungeonLayoutParams& Params,
+  const FDungeonLayoutCancellation* Cancellation) const
+{
+  FDungeonLayout Layout;
+  if (IsEnabled() && Load(Params, Layout)) return Layout;
+
+  Layout = Generator.Generate(Params, Cancellation);
+  if (IsEnabled() && !Layout.IsEmpty())
+  {
+    Store(Params, Layout);
+  }
+  return Layout;
+}
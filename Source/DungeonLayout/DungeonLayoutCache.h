@@ -0,0 +1,33 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonLayout.h"
+
+// Finished floors on disk, one FDungeonLayoutFormat file per floor named after its
+// seed and params hash. Lookups try the read directories in order (curated floors
+// shipped in the pak, say) and then the write directory, where newly generated
+// floors are stored. Files are memory mapped where the platform allows it.
+//
+// Holds nothing but the directory names, so a copy can be handed to a worker thread.
+class DUNGEONLAYOUT_API FDungeonLayoutCache
+{
+public:
+  void SetWriteDirectory(const FString& Directory) { WriteDirectory = Directory; }
+  void AddReadDirectory(const FString& Directory) { ReadDirectories.AddUnique(Directory); }
+  bool IsEnabled() const { return !WriteDirectory.IsEmpty() || ReadDirectories.Num() > 0; }
+
+  bool Load(const FDungeonLayoutParams& Params, FDungeonLayout& OutLayout) const;
+  bool Store(const FDungeonLayoutParams& Params, const FDungeonLayout& Layout) const;
+
+  // Loads the floor if it is cached, otherwise generates and stores it. A cancelled
+  // generation returns an empty layout and stores nothing.
+  FDungeonLayout LoadOrGenerate(FDungeonLayoutGenerator& Generator, const FDungeonLayoutParams& Params,
+    const FDungeonLayoutCancellation* Cancellation = nullptr) const;
+
+  static FString GetFileName(const FDungeonLayoutParams& Params);
+
+private:
+  static bool LoadFile(const FString& Path, const FDungeonLayoutParams& Params, FDungeonLayout& OutLayout);
+
+  FString WriteDirectory;
+  TArray<FString> ReadDirectories;
+};
@@ -0,0 +1,257 @@
+// DungeonLayoutFormat.cpp
+#include "DungeonLayoutFormat.h"
+
+static_assert(sizeof(FIntPoint) == 2 * sizeof(int32), "Layout files store cells as two int32");
+static_assert(sizeof(FDungeonLayoutFileHeader) == 100 && sizeof(FDungeonLayoutFileHeader) % 4 == 0, "Layout file header layout changed; bump the version");
+
+namespace
+{
+  // Bounding boxes past this are rejected as corrupt rather than allocated
+  constexpr int64 MaxGridIndices = 1 << 26;
+
+  uint32 MixHash(uint32 Hash, uint32 Value, uint32 Salt)
+  {
+    return (uint32)FDungeonLayoutGenerator::MixSeed((int32)(Hash ^ Value), Salt);
+  }
+
+  // Layouts sit well inside 16 bits of coordinate either way from the origin
+  uint32 PackCell(const FIntPoint& Cell)
+  {
+    return ((uint32)Cell.X & 0xFFFF) | ((uint32)Cell.Y << 16);
+  }
+
+  uint32 FloatBits(float Value)
+  {
+    uint32 Bits;
+    FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+    return Bits;
+  }
+}
+
+uint32 FDungeonLayoutFormat::HashParams(const FDungeonLayoutParams& Params)
+{
+  uint32 Hash = FDungeonLayoutGenerator::AlgorithmVersion;
+  Hash = MixHash(Hash, (uint32)Params.CellCount, 1);
+  Hash = MixHash(Hash, (uint32)Params.EnemyCount, 2);
+  Hash = MixHash(Hash, FloatBits(Params.LoopFraction), 3);
+  Hash = MixHash(Hash, FloatBits(Params.LockedAreaSizePercent), 4);
+
+  // Growth floors keep the keys they had before the engine was selectable
+  if (Params.Engine != EDungeonLayoutEngine::Growth)
+  {
+    Hash = MixHash(Hash, (uint32)Params.Engine, 5);
+  }
+  return Hash;
+}
+
+uint32 FDungeonLayoutFormat::Checksum(const FDungeonLayout& Layout)
+{
+  const FDungeonGrid& Grid = Layout.Grid;
+  const TArray<FIntPoint>& Cells = Grid.GetCells();
+
+  uint32 Hash = MixHash((uint32)Layout.Seed, (uint32)Cells.Num(), 1);
+  Hash = MixHash(Hash, PackCell(Layout.SafeRoom), 2);
+  Hash = MixHash(Hash, PackCell(Layout.EndRoom), 3);
+  Hash = MixHash(Hash, Layout.bHasKeyRoom ? PackCell(Layout.KeyRoom) : 0, 4);
+  Hash = MixHash(Hash, Layout.bHasLockedDoor ? PackCell(Layout.LockedDoorRoom) : 0, 5);
+  Hash = MixHash(Hash, Layout.bHasLockedDoor ? PackCell(Layout.LockedDoorNeighbour) : 0, 6);
+
+  // Doors plus the locked and accessible bits, six bits per cell packed into words
+  // in cell order, so the cell contents cost a fraction of a mix each
+  uint64 Word = 0;
+  int32 WordBits = 0;
+  for (const FIntPoint& Cell : Cells)
+  {
+    const int32 Index = Grid.ToIndex(Cell);
+    const uint64 Bits = Grid.GetDoors(Index) |
+      (Grid.HasFlag(Index, DungeonCell::Locked) ? 1 << 4 : 0) |
+      (Grid.HasFlag(Index, DungeonCell::Accessible) ? 1 << 5 : 0);
+
+    Hash = MixHash(Hash, PackCell(Cell), 7);
+    Word |= Bits << WordBits;
+    WordBits += 6;
+    if (WordBits > 64 - 6)
+    {
+      Hash = MixHash(Hash, (uint32)Word, 8);
+      Hash = MixHash(Hash, (uint32)(Word >> 32), 9);
+      Word = 0;
+      WordBits = 0;
+    }
+  }
+  Hash = MixHash(Hash, (uint32)Word, 8);
+  Hash = MixHash(Hash, (uint32)(Word >> 32), 9);
+
+  for (const FIntPoint& Slot : Layout.EnemySlots)
+  {
+    Hash = MixHash(Hash, PackCell(Slot), 10);
+  }
+  return Hash;
+}
+
+void FDungeonLayoutFormat::Write(const FDungeonLayout& Layout, uint32 ParamsHash, TArray<uint8>& OutData)
+{
+  const FDungeonGrid& Grid = Layout.Grid;
+  const TArray<FIntPoint>& Cells = Grid.GetCells();
+  const int32 NumCells = Cells.Num();
+  const int32 NumEnemySlots = Layout.EnemySlots.Num();
+
+  FDungeonLayoutFileHeader Header{};
+  Header.Magic = Magic;
+  Header.Version = Version;
+  Header.HeaderSize = sizeof(FDungeonLayoutFileHeader);
+  Header.ParamsHash = ParamsHash;
+  Header.Seed = Layout.Seed;
+  Header.MinX = Grid.GetMin().X;
+  Header.MinY = Grid.GetMin().Y;
+  Header.Width = Grid.GetWidth();
+  Header.Height = Grid.GetHeight();
+  Header.SafeRoom = Layout.SafeRoom;
+  Header.EndRoom = Layout.EndRoom;
+  Header.KeyRoom = Layout.KeyRoom;
+  Header.LockedDoorRoom = Layout.LockedDoorRoom;
+  Header.LockedDoorNeighbour = Layout.LockedDoorNeighbour;
+  Header.LockedDoorFacing = Layout.LockedDoorFacing;
+  Header.LockedRoomCount = Layout.LockedRoomCount;
+  Header.AccessibleRoomCount = Layout.AccessibleRoomCount;
+  Header.MaxSafeRoomDistance = Layout.MaxSafeRoomDistance;
+  Header.LayoutFlags = (Layout.bHasKeyRoom ? HasKeyRoom : 0) | (Layout.bHasLockedDoor ? HasLockedDoor : 0) |
+    (Layout.bRanOutOfPositions ? RanOutOfPositions : 0);
+  Header.NumCells = NumCells;
+  Header.NumEnemySlots = NumEnemySlots;
+
+  OutData.Reset();
+  OutData.AddZeroed(DungeonLayoutFile::GetSize(NumCells, NumEnemySlots));
+  uint8* Out = OutData.GetData();
+
+  FMemory::Memcpy(Out, &Header, sizeof(Header));
+  Out += sizeof(Header);
+  FMemory::Memcpy(Out, Cells.GetData(), NumCells * sizeof(FIntPoint));
+  Out += NumCells * sizeof(FIntPoint);
+  FMemory::Memcpy(Out, Layout.EnemySlots.GetData(), NumEnemySlots * sizeof(FIntPoint));
+  Out += NumEnemySlots * sizeof(FIntPoint);
+
+  int32* DistancesOut = reinterpret_cast<int32*>(Out);
+  uint8* DoorsOut = Out + NumCells * sizeof(int32);
+  uint8* FlagsOut = DoorsOut + NumCells;
+  for (int32 i = 0; i < NumCells; i++)
+  {
+    const int32 Index = Grid.ToIndex(Cells[i]);
+    const int32 Distance = Layout.SafeRoomDistances.IsValidIndex(Index) ? Layout.SafeRoomDistances[Index] : INDEX_NONE;
+    FMemory::Memcpy(&DistancesOut[i], &Distance, sizeof(Distance));
+    DoorsOut[i] = Grid.GetDoors(Index);
+    FlagsOut[i] = DungeonCell::Occupied |
+      (Grid.HasFlag(Index, DungeonCell::Locked) ? DungeonCell::Locked : 0) |
+      (Grid.HasFlag(Index, DungeonCell::Accessible) ? DungeonCell::Accessible : 0);
+  }
+}
+
+bool FDungeonLayoutFormat::Read(const uint8* Data, int64 Size, FDungeonLayout& OutLayout, uint32* OutParamsHash)
+{
+  OutLayout = FDungeonLayout();
+
+  FDungeonLayoutFileHeader Header;
+  if (!Data || Size < (int64)sizeof(Header)) return false;
+  FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+  if (Header.Magic != Magic || Header.Version != Version || Header.HeaderSize != sizeof(Header)) return false;
+  if (Header.NumCells <= 0 || Header.NumCells > FDungeonLayoutGenerator::MaxRooms) return false;
+  if (Header.NumEnemySlots < 0 || Header.NumEnemySlots > Header.NumCells || Header.Width < 3 || Header.Height < 3) return false;
+  if ((int64)Header.Width * Header.Height > MaxGridIndices) return false;
+  if (Size < DungeonLayoutFile::GetSize(Header.NumCells, Header.NumEnemySlots)) return false;
+
+  const int32 NumCells = Header.NumCells;
+  const uint8* CellsIn = Data + sizeof(Header);
+  const uint8* SlotsIn = CellsIn + NumCells * sizeof(FIntPoint);
+  const uint8* DistancesIn = SlotsIn + Header.NumEnemySlots * sizeof(FIntPoint);
+  const uint8* DoorsIn = DistancesIn + NumCells * sizeof(int32);
+  const uint8* FlagsIn = DoorsIn + NumCells;
+
+  FDungeonLayout Layout;
+  FDungeonGrid& Grid = Layout.Grid;
+  const FIntPoint Min(Header.MinX, Header.MinY);
+  Grid.Reset(Min, Header.Width, Header.Height);
+
+  // Cells must keep their border ring inside the stored bounds so the grid never
+  // grows here and neighbour lookups stay in range
+  const int64 MaxX = (int64)Min.X + Header.Width - 1;
+  const int64 MaxY = (int64)Min.Y + Header.Height - 1;
+  for (int32 i = 0; i < NumCells; i++)
+  {
+    FIntPoint Cell;
+    FMemory::Memcpy(&Cell, CellsIn + i * sizeof(FIntPoint), sizeof(Cell));
+    if (Cell.X <= Min.X || Cell.Y <= Min.Y || Cell.X >= MaxX || Cell.Y >= MaxY || Grid.IsOccupied(Cell)) return false;
+    Grid.Occupy(Cell);
+  }
+
+  // Distances index per-distance buckets when enemies are placed, so each one must be
+  // unreached or within the stored maximum, and that maximum must be the real one
+  Layout.SafeRoomDistances.Init(INDEX_NONE, Grid.NumIndices());
+  const TArray<FIntPoint>& Cells = Grid.GetCells();
+  int32 MaxDistance = 0;
+  for (int32 i = 0; i < NumCells; i++)
+  {
+    const int32 Index = Grid.ToIndex(Cells[i]);
+    int32& Distance = Layout.SafeRoomDistances[Index];
+    FMemory::Memcpy(&Distance, DistancesIn + i * sizeof(int32), sizeof(int32));
+    if (Distance < INDEX_NONE || Distance > Header.MaxSafeRoomDistance) return false;
+    MaxDistance = FMath::Max(MaxDistance, Distance);
+    Grid.SetDoors(Index, DoorsIn[i] & DungeonDoor::All);
+    if (FlagsIn[i] & DungeonCell::Locked) Grid.SetFlag(Index, DungeonCell::Locked);
+    if (FlagsIn[i] & DungeonCell::Accessible) Grid.SetFlag(Index, DungeonCell::Accessible);
+  }
+
+  if (MaxDistance != Header.MaxSafeRoomDistance) return false;
+
+  // Every door needs its other half on an occupied neighbour
+  for (const FIntPoint& Cell : Cells)
+  {
+    const int32 Index = Grid.ToIndex(Cell);
+    const uint8 Doors = Grid.GetDoors(Index);
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      const uint8 Door = DungeonDoor::FromIndex(Dir);
+      if (!(Doors & Door)) continue;
+
+      const int32 Neighbour = Grid.Neighbour(Index, Dir);
+      if (!Grid.IsOccupied(Neighbour) || !(Grid.GetDoors(Neighbour) & DungeonDoor::Opposite(Door))) return false;
+    }
+  }
+
+  Layout.Seed = Header.Seed;
+  Layout.SafeRoom = Header.SafeRoom;
+  Layout.EndRoom = Header.EndRoom;
+  Layout.KeyRoom = Header.KeyRoom;
+  Layout.LockedDoorRoom = Header.LockedDoorRoom;
+  Layout.LockedDoorNeighbour = Header.LockedDoorNeighbour;
+  Layout.LockedDoorFacing = Header.LockedDoorFacing;
+  Layout.LockedRoomCount = Header.LockedRoomCount;
+  Layout.AccessibleRoomCount = Header.AccessibleRoomCount;
+  Layout.MaxSafeRoomDistance = Header.MaxSafeRoomDistance;
+  Layout.bHasKeyRoom = (Header.LayoutFlags & HasKeyRoom) != 0;
+  Layout.bHasLockedDoor = (Header.LayoutFlags & HasLockedDoor) != 0;
+  Layout.bRanOutOfPositions = (Header.LayoutFlags & RanOutOfPositions) != 0;
+
+  if (!Grid.IsOccupied(Layout.SafeRoom) || !Grid.IsOccupied(Layout.EndRoom)) return false;
+  if (Layout.SafeRoomDistances[Grid.ToIndex(Layout.SafeRoom)] != 0) return false;
+  if (Layout.bHasKeyRoom && !Grid.IsOccupied(Layout.KeyRoom)) return false;
+  if (Layout.bHasLockedDoor && (!Grid.IsOccupied(Layout.LockedDoorRoom) || !Grid.IsOccupied(Layout.LockedDoorNeighbour) ||
+    DungeonDoor::Between(Layout.LockedDoorRoom, Layout.LockedDoorNeighbour) == DungeonDoor::None ||
+    Layout.LockedDoorFacing < 0 || Layout.LockedDoorFacing >= DungeonDoor::NumDirections))
+  {
+    return false;
+  }
+
+  Layout.EnemySlots.SetNumUninitialized(Header.NumEnemySlots);
+  FMemory::Memcpy(Layout.EnemySlots.GetData(), SlotsIn, Header.NumEnemySlots * sizeof(FIntPoint));
+  for (const FIntPoint& Slot : Layout.EnemySlots)
+  {
+    if (!Grid.IsOccupied(Slot)) return false;
+  }
+
+  if (OutParamsHash)
+  {
+    *OutParamsHash = Header.ParamsHash;
+  }
+  OutLayout = MoveTemp(Layout);
+  return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonLayout.h"
+
+// Binary form of a finished layout. A fixed header followed by flat per-cell arrays,
+// all little endian and 4-byte aligned, so a loader copies rather than parses:
+//
+//   FDungeonLayoutFileHeader
+//   FIntPoint Cells[NumCells]           in generation order
+//   FIntPoint EnemySlots[NumEnemySlots]
+//   int32     Distances[NumCells]       safe room distance per cell
+//   uint8     Doors[NumCells]
+//   uint8     Flags[NumCells]           DungeonCell bits
+//
+// Everything is validated on read, so files from a pak or another build can't
+// produce a layout the rest of the game would index out of bounds with.
+struct FDungeonLayoutFileHeader
+{
+  uint32 Magic;
+  uint16 Version;
+  uint16 HeaderSize;
+  uint32 ParamsHash;
+  int32 Seed;
+
+  // Grid bounds, border ring included
+  int32 MinX;
+  int32 MinY;
+  int32 Width;
+  int32 Height;
+
+  FIntPoint SafeRoom;
+  FIntPoint EndRoom;
+  FIntPoint KeyRoom;
+  FIntPoint LockedDoorRoom;
+  FIntPoint LockedDoorNeighbour;
+  int32 LockedDoorFacing;
+  int32 LockedRoomCount;
+  int32 AccessibleRoomCount;
+  int32 MaxSafeRoomDistance;
+
+  uint32 LayoutFlags; // FDungeonLayoutFormat::Has* bits
+  int32 NumCells;
+  int32 NumEnemySlots;
+};
+
+namespace DungeonLayoutFile
+{
+  // Bytes in a file of NumCells rooms and NumEnemySlots slots, padding included
+  constexpr int64 GetSize(int32 NumCells, int32 NumEnemySlots)
+  {
+    const int64 Size = sizeof(FDungeonLayoutFileHeader) + ((int64)NumCells + NumEnemySlots) * sizeof(FIntPoint) +
+      (int64)NumCells * (sizeof(int32) + sizeof(uint8) * 2);
+    return (Size + 3) & ~(int64)3;
+  }
+}
+
+class DUNGEONLAYOUT_API FDungeonLayoutFormat
+{
+public:
+  static constexpr uint32 Magic = 0x594C4744; // "DGLY"
+  static constexpr uint16 Version = 1;
+
+  static constexpr uint32 HasKeyRoom = 1 << 0;
+  static constexpr uint32 HasLockedDoor = 1 << 1;
+  static constexpr uint32 RanOutOfPositions = 1 << 2;
+
+  // Largest file Write produces: every room the generator allows, each with an enemy.
+  // Read rejects files claiming more.
+  static constexpr int64 MaxFileSize = DungeonLayoutFile::GetSize(FDungeonLayoutGenerator::MaxRooms, FDungeonLayoutGenerator::MaxRooms);
+
+  // Hash of everything in Params except Seed, plus the generator's AlgorithmVersion.
+  // Fixed integer mixing, so it is the same on every platform.
+  static uint32 HashParams(const FDungeonLayoutParams& Params);
+
+  // Cheap fingerprint of a finished layout: cells, doors, areas, special rooms and
+  // enemy slots. Two machines that built the same floor get the same value, so it
+  // can stand in for the layout itself when checking that they agree.
+  static uint32 Checksum(const FDungeonLayout& Layout);
+
+  static void Write(const FDungeonLayout& Layout, uint32 ParamsHash, TArray<uint8>& OutData);
+
+  // Returns false and leaves OutLayout empty if Data is not a valid layout
+  static bool Read(const uint8* Data, int64 Size, FDungeonLayout& OutLayout, uint32* OutParamsHash = nullptr);
+};
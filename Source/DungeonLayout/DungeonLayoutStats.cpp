@@ -0,0 +1,11 @@
+// DungeonLayoutStats.cpp
+#include "DungeonLayoutStats.h"
+
+LLM_DEFINE_TAG(Dungeon);
+
+DEFINE_STAT(STAT_DungeonCells);
+DEFINE_STAT(STAT_DungeonDoors);
+DEFINE_STAT(STAT_DungeonScratchAllocations);
+DEFINE_STAT(STAT_DungeonBFSVisits);
+DEFINE_STAT(STAT_DungeonActorsSpawned);
+DEFINE_STAT(STAT_DungeonActorsDestroyed);
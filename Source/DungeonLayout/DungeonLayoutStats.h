@@ -0,0 +1,22 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Dungeon generation and spawning stats, shared by the layout module and the game.
+// "stat Dungeon" shows them live, cycle stats also appear as CPU scopes in Insights
+// captures, and "stat LLM" / the Insights memory view attribute heap use to the
+// Dungeon tag. Stats and LLM are compiled out of shipping builds, and so is all of this.
+DECLARE_STATS_GROUP(TEXT("Dungeon"), STATGROUP_Dungeon, STATCAT_Advanced);
+
+LLM_DECLARE_TAG_API(Dungeon, DUNGEONLAYOUT_API);
+
+// Current floor
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Cells"), STAT_DungeonCells, STATGROUP_Dungeon, DUNGEONLAYOUT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Doors"), STAT_DungeonDoors, STATGROUP_Dungeon, DUNGEONLAYOUT_API);
+
+// Per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Layout Scratch Allocations"), STAT_DungeonScratchAllocations, STATGROUP_Dungeon, DUNGEONLAYOUT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("BFS Node Visits"), STAT_DungeonBFSVisits, STATGROUP_Dungeon, DUNGEONLAYOUT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Actors Spawned"), STAT_DungeonActorsSpawned, STATGROUP_Dungeon, DUNGEONLAYOUT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Actors Destroyed"), STAT_DungeonActorsDestroyed, STATGROUP_Dungeon, DUNGEONLAYOUT_API);
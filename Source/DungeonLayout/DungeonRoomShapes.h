@@ -0,0 +1,62 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonDoors.h"
+
+// Room category a cell's doors call for
+enum class EDungeonRoomShape : uint8
+{
+  None,
+  DeadEnd,
+  Straight,
+  Turn,
+  TJunction,
+  Crossroad,
+  Num
+};
+
+// Shape and placement for one door mask. Quarters are clockwise quarter turns of
+// yaw from the authored orientation: dead ends open north, straights run north to
+// south, turns open north and east, T-junctions are closed to the south.
+struct FDungeonRoomShape
+{
+  EDungeonRoomShape Shape;
+  uint8 Quarter;
+
+  // Quarter that points a single doorway at the first open side, checked south,
+  // east, north, west. Special rooms use this whatever their doors.
+  uint8 FacingQuarter;
+};
+
+namespace DungeonRoomShape
+{
+  // Indexed by the 4-bit door mask (N = 1, E = 2, S = 4, W = 8)
+  inline constexpr FDungeonRoomShape Table[16] =
+  {
+    { EDungeonRoomShape::None,      0, 0 }, // ----
+    { EDungeonRoomShape::DeadEnd,   0, 0 }, // N---
+    { EDungeonRoomShape::DeadEnd,   1, 1 }, // -E--
+    { EDungeonRoomShape::Turn,      0, 1 }, // NE--
+    { EDungeonRoomShape::DeadEnd,   2, 2 }, // --S-
+    { EDungeonRoomShape::Straight,  0, 2 }, // N-S-
+    { EDungeonRoomShape::Turn,      1, 2 }, // -ES-
+    { EDungeonRoomShape::TJunction, 1, 2 }, // NES-
+    { EDungeonRoomShape::DeadEnd,   3, 3 }, // ---W
+    { EDungeonRoomShape::Turn,      3, 0 }, // N--W
+    { EDungeonRoomShape::Straight,  1, 1 }, // -E-W
+    { EDungeonRoomShape::TJunction, 0, 1 }, // NE-W
+    { EDungeonRoomShape::Turn,      2, 2 }, // --SW
+    { EDungeonRoomShape::TJunction, 3, 2 }, // N-SW
+    { EDungeonRoomShape::TJunction, 2, 2 }, // -ESW
+    { EDungeonRoomShape::Crossroad, 0, 2 }, // NESW
+  };
+
+  FORCEINLINE constexpr const FDungeonRoomShape& FromDoors(uint8 Doors)
+  {
+    return Table[Doors & DungeonDoor::All];
+  }
+
+  FORCEINLINE constexpr float QuarterToYaw(uint8 Quarter)
+  {
+    return Quarter * 90.0f;
+  }
+}
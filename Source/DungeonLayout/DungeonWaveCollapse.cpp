@@ -0,0 +1,267 @@
+// DungeonWaveCollapse.cpp
+#include "DungeonWaveCollapse.h"
+#include "DungeonLayout.h"
+
+FDungeonWaveRules::FDungeonWaveRules()
+{
+  for (int32 Direction = 0; Direction < DungeonDoor::NumDirections; Direction++)
+  {
+    const uint8 Door = DungeonDoor::FromIndex(Direction);
+    const uint16 Open = TilesWithDoor(DungeonDoor::Opposite(Door));
+    for (int32 Tile = 0; Tile < NumTiles; Tile++)
+    {
+      Allowed[Direction][Tile] = (Tile & Door) ? Open : (uint16)~Open;
+    }
+    BuildSupport(Direction);
+  }
+
+  for (float& Weight : Weights)
+  {
+    Weight = 1.0f;
+  }
+}
+
+uint16 FDungeonWaveRules::TilesWithDoor(uint8 Door)
+{
+  uint16 Tiles = 0;
+  for (int32 Tile = 0; Tile < NumTiles; Tile++)
+  {
+    if (Tile & Door) Tiles |= 1 << Tile;
+  }
+  return Tiles;
+}
+
+uint16 FDungeonWaveRules::TilesOfShape(EDungeonRoomShape Shape)
+{
+  uint16 Tiles = 0;
+  for (int32 Tile = 0; Tile < NumTiles; Tile++)
+  {
+    if (DungeonRoomShape::FromDoors((uint8)Tile).Shape == Shape) Tiles |= 1 << Tile;
+  }
+  return Tiles;
+}
+
+void FDungeonWaveRules::Forbid(uint16 A, int32 Direction, uint16 B)
+{
+  const int32 Back = (Direction + 2) % DungeonDoor::NumDirections;
+  for (int32 Tile = 0; Tile < NumTiles; Tile++)
+  {
+    if (A & (1 << Tile)) Allowed[Direction][Tile] &= ~B;
+    if (B & (1 << Tile)) Allowed[Back][Tile] &= ~A;
+  }
+  BuildSupport(Direction);
+  BuildSupport(Back);
+}
+
+void FDungeonWaveRules::ForbidTouching(uint16 A, uint16 B)
+{
+  for (int32 Direction = 0; Direction < DungeonDoor::NumDirections; Direction++)
+  {
+    Forbid(A, Direction, B);
+  }
+}
+
+void FDungeonWaveRules::BuildSupport(int32 Direction)
+{
+  for (int32 Nibble = 0; Nibble < 4; Nibble++)
+  {
+    for (int32 Bits = 0; Bits < 16; Bits++)
+    {
+      uint16 Tiles = 0;
+      for (int32 Bit = 0; Bit < 4; Bit++)
+      {
+        if (Bits & (1 << Bit)) Tiles |= Allowed[Direction][Nibble * 4 + Bit];
+      }
+      Support[Direction][Nibble][Bits] = Tiles;
+    }
+  }
+}
+
+bool FDungeonWaveCollapse::Run(FDungeonArena& Arena, const FDungeonWaveRules& InRules, int32 InWidth, int32 InHeight, int32 MaxBacktracks,
+  FRandomStream& Stream, const FDungeonLayoutCancellation* Cancellation)
+{
+  Rules = &InRules;
+  Width = FMath::Max(InWidth, 0);
+  Height = FMath::Max(InHeight, 0);
+  Stride = Width + 2;
+  Strides[0] = -Stride;
+  Strides[1] = 1;
+  Strides[2] = Stride;
+  Strides[3] = -1;
+  NumBacktracks = 0;
+
+  // The ring holds the empty tile and never changes, so no side needs a bounds check
+  const int32 NumPadded = Stride * (Height + 2);
+  const int32 NumCells = Width * Height;
+  Tiles.Init(Arena, (uint16)1, NumPadded);
+  Positions.Init(Arena, INDEX_NONE, NumPadded);
+  Order.Init(Arena, NumCells);
+  Pending.Init(Arena, NumCells);
+  Trail.Init(Arena, NumCells * 4);
+  Decisions.Init(Arena, NumCells);
+
+  // Every cell starts with all tiles, i.e. in the last bucket
+  for (int32 Y = 0; Y < Height; Y++)
+  {
+    for (int32 X = 0; X < Width; X++)
+    {
+      const int32 Index = ToIndex(X, Y);
+      Tiles[Index] = FDungeonWaveRules::AllTiles;
+      Positions[Index] = Order.Add(Index);
+    }
+  }
+  for (int32 Count = 0; Count <= FDungeonWaveRules::NumTiles; Count++)
+  {
+    BucketStarts[Count] = 0;
+  }
+  BucketStarts[FDungeonWaveRules::NumTiles + 1] = NumCells;
+
+  // Cells along the edge can't open onto the ring
+  for (int32 Y = 0; Y < Height; Y++)
+  {
+    for (int32 X = 0; X < Width; X++)
+    {
+      if (X > 0 && Y > 0 && X < Width - 1 && Y < Height - 1) continue;
+
+      const int32 Index = ToIndex(X, Y);
+      uint16 Options = Tiles[Index];
+      for (int32 Direction = 0; Direction < DungeonDoor::NumDirections; Direction++)
+      {
+        const int32 Neighbour = Index + Strides[Direction];
+        if (Positions[Neighbour] == INDEX_NONE)
+        {
+          Options &= Rules->GetSupport(Tiles[Neighbour], (Direction + 2) % DungeonDoor::NumDirections);
+        }
+      }
+      if (Options == 0) return false;
+      if (Options != Tiles[Index]) Narrow(Index, Options);
+    }
+  }
+  if (!Propagate()) return false;
+  Trail.Reset();
+
+  for (int32 Collapses = 1;; Collapses++)
+  {
+    if ((Collapses & 1023) == 0 && Cancellation && Cancellation->IsCancelled()) return false;
+
+    // Fewest tiles left first, so contradictions show up while they are cheap to undo.
+    // Among those, the last to arrive: it is next to the latest collapse, so the field
+    // fills in as one front and the cells being worked on stay in cache.
+    int32 Count = 2;
+    while (Count <= FDungeonWaveRules::NumTiles && BucketStarts[Count] == BucketStarts[Count + 1])
+    {
+      Count++;
+    }
+    if (Count > FDungeonWaveRules::NumTiles) return true;
+
+    const int32 Index = Order[BucketStarts[Count + 1] - 1];
+    const uint16 Tile = (uint16)(1 << PickTile(Tiles[Index], Stream));
+    Decisions.Add({ Index, Tile, Trail.Num() });
+    Narrow(Index, Tile);
+
+    // Undo choices newest first until one can be ruled out without a contradiction
+    bool bConsistent = Propagate();
+    while (!bConsistent)
+    {
+      if (Decisions.IsEmpty() || NumBacktracks >= MaxBacktracks) return false;
+
+      NumBacktracks++;
+      const FDecision Last = Decisions.Pop();
+      Undo(Last.TrailStart);
+      const uint16 Left = Tiles[Last.Index] & ~Last.Tile;
+      if (Left != 0)
+      {
+        Narrow(Last.Index, Left);
+        bConsistent = Propagate();
+      }
+    }
+  }
+}
+
+void FDungeonWaveCollapse::Narrow(int32 Index, uint16 NewTiles)
+{
+  const uint16 OldTiles = Tiles[Index];
+  Trail.Add({ Index, OldTiles });
+  Rebucket(Index, FMath::CountBits(OldTiles), FMath::CountBits(NewTiles));
+  Tiles[Index] = NewTiles;
+  Pending.Add(Index);
+}
+
+bool FDungeonWaveCollapse::Propagate()
+{
+  while (!Pending.IsEmpty())
+  {
+    const int32 Index = Pending.Pop();
+    const uint16 Here = Tiles[Index];
+    for (int32 Direction = 0; Direction < DungeonDoor::NumDirections; Direction++)
+    {
+      // Ring cells only ever hold the empty tile, so they either still fit or contradict
+      const int32 Neighbour = Index + Strides[Direction];
+      const uint16 Before = Tiles[Neighbour];
+      const uint16 After = Before & Rules->GetSupport(Here, Direction);
+      if (After == Before) continue;
+      if (After == 0)
+      {
+        Pending.Reset();
+        return false;
+      }
+      Narrow(Neighbour, After);
+    }
+  }
+  return true;
+}
+
+void FDungeonWaveCollapse::Undo(int32 Start)
+{
+  while (Trail.Num() > Start)
+  {
+    const FTrailEntry Entry = Trail.Pop();
+    Rebucket(Entry.Index, FMath::CountBits(Tiles[Entry.Index]), FMath::CountBits(Entry.Tiles));
+    Tiles[Entry.Index] = Entry.Tiles;
+  }
+  Pending.Reset();
+}
+
+void FDungeonWaveCollapse::Rebucket(int32 Index, int32 From, int32 To)
+{
+  // Crossing a bucket boundary swaps the cell with the bucket's first or last cell
+  // and moves the boundary past it, so a move costs one swap per bucket crossed
+  int32 Position = Positions[Index];
+  auto SwapTo = [this, Index, &Position](int32 Edge)
+    {
+      const int32 Other = Order[Edge];
+      Order[Position] = Other;
+      Positions[Other] = Position;
+      Order[Edge] = Index;
+      Position = Edge;
+    };
+
+  for (; From > To; From--)
+  {
+    SwapTo(BucketStarts[From]++);
+  }
+  for (; From < To; From++)
+  {
+    SwapTo(--BucketStarts[From + 1]);
+  }
+  Positions[Index] = Position;
+}
+
+int32 FDungeonWaveCollapse::PickTile(uint16 Options, FRandomStream& Stream) const
+{
+  float Total = 0.0f;
+  for (uint32 Bits = Options; Bits; Bits &= Bits - 1)
+  {
+    Total += Rules->Weights[FMath::CountTrailingZeros(Bits)];
+  }
+
+  float Roll = Stream.FRand() * Total;
+  int32 Tile = (int32)FMath::CountTrailingZeros((uint32)Options);
+  for (uint32 Bits = Options; Bits; Bits &= Bits - 1)
+  {
+    Tile = (int32)FMath::CountTrailingZeros(Bits);
+    Roll -= Rules->Weights[Tile];
+    if (Roll < 0.0f) break;
+  }
+  return Tile;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonDoors.h"
+#include "DungeonRoomShapes.h"
+#include "DungeonArena.h"
+
+class FDungeonLayoutCancellation;
+
+// Adjacency rules for wave function collapse over the 16 door-mask tiles. Tile T is
+// the room whose doors are T (0 is no room), and a set of tiles is a uint16 with bit
+// T for tile T. Doors always have to match across every side; Forbid adds rules on
+// top of that.
+struct DUNGEONLAYOUT_API FDungeonWaveRules
+{
+  static constexpr int32 NumTiles = 16;
+  static constexpr uint16 AllTiles = 0xFFFF;
+
+  // Doors that match and nothing else, every tile weighted 1
+  FDungeonWaveRules();
+
+  // Tiles with Door open, as a set
+  static uint16 TilesWithDoor(uint8 Door);
+
+  // Tiles whose door mask is in Shape's category, as a set
+  static uint16 TilesOfShape(EDungeonRoomShape Shape);
+
+  // Stops any tile in A having any tile in B beyond its Direction side. The mirrored
+  // rule is added too, so the rules stay symmetric.
+  void Forbid(uint16 A, int32 Direction, uint16 B);
+
+  // Stops any tile in A sharing any side with any tile in B
+  void ForbidTouching(uint16 A, uint16 B);
+
+  // Whether tile Beyond may sit beyond the Direction side of tile Tile
+  bool Allows(uint8 Tile, int32 Direction, uint8 Beyond) const
+  {
+    return (Allowed[Direction][Tile] & (1 << Beyond)) != 0;
+  }
+
+  // Tiles allowed beyond the Direction side of a cell that may hold any of Tiles
+  uint16 GetSupport(uint16 Tiles, int32 Direction) const
+  {
+    const uint16(&Table)[4][16] = Support[Direction];
+    return Table[0][Tiles & 15] | Table[1][(Tiles >> 4) & 15] | Table[2][(Tiles >> 8) & 15] | Table[3][Tiles >> 12];
+  }
+
+  // Relative chance of each tile when a cell collapses
+  float Weights[NumTiles];
+
+private:
+  void BuildSupport(int32 Direction);
+
+  // Per direction and tile: the tiles allowed beyond that side
+  uint16 Allowed[DungeonDoor::NumDirections][NumTiles];
+
+  // Allowed folded per nibble of a tile set, so a set's support is four lookups
+  // into 128 bytes per direction instead of a walk over its tiles
+  uint16 Support[DungeonDoor::NumDirections][4][16];
+};
+
+// Wave function collapse over a Width x Height field of door-mask tiles. Each cell
+// keeps a uint16 of the tiles it may still become, in one flat array with a fixed
+// ring of empty cells around it, so propagation is index arithmetic plus a support
+// lookup per side. The next cell to collapse is one of those with the fewest tiles
+// left, found in O(1) from an order array kept partitioned by tile count; the tile
+// it takes is a weighted random pick. A contradiction undoes the last choice from a
+// trail of changed cells and bans that tile there; Run gives up after MaxBacktracks
+// of those.
+class DUNGEONLAYOUT_API FDungeonWaveCollapse
+{
+public:
+  // Collapses the whole field. All scratch arrays live on Arena until its next reset.
+  // Returns false if the backtracking budget ran out or Cancellation fired.
+  bool Run(FDungeonArena& Arena, const FDungeonWaveRules& Rules, int32 InWidth, int32 InHeight, int32 MaxBacktracks,
+    FRandomStream& Stream, const FDungeonLayoutCancellation* Cancellation = nullptr);
+
+  int32 GetWidth() const { return Width; }
+  int32 GetHeight() const { return Height; }
+
+  // Door mask the cell collapsed to. Only valid after a successful Run.
+  uint8 GetDoors(int32 X, int32 Y) const
+  {
+    return (uint8)FMath::CountTrailingZeros((uint32)Tiles[ToIndex(X, Y)]);
+  }
+
+  // Choices undone by the last Run
+  int32 GetNumBacktracks() const { return NumBacktracks; }
+
+private:
+  struct FTrailEntry
+  {
+    int32 Index;
+    uint16 Tiles;
+  };
+
+  struct FDecision
+  {
+    int32 Index;
+    uint16 Tile;
+    int32 TrailStart;
+  };
+
+  int32 ToIndex(int32 X, int32 Y) const { return (Y + 1) * Stride + X + 1; }
+
+  // Narrows a cell and files it under its new tile count, remembering the old set
+  void Narrow(int32 Index, uint16 NewTiles);
+
+  // Runs every pending change out to its neighbours. False on a contradiction.
+  bool Propagate();
+
+  // Rolls cells back to how they were when the trail was Start long
+  void Undo(int32 Start);
+
+  // Moves a cell within Order from one tile-count bucket to another
+  void Rebucket(int32 Index, int32 From, int32 To);
+
+  int32 PickTile(uint16 Options, FRandomStream& Stream) const;
+
+  const FDungeonWaveRules* Rules = nullptr;
+  int32 Width = 0;
+  int32 Height = 0;
+  int32 Stride = 0;
+  int32 Strides[DungeonDoor::NumDirections] = {};
+  int32 NumBacktracks = 0;
+
+  // Per padded cell: tiles still possible and position in Order
+  TDungeonArenaArray<uint16> Tiles;
+  TDungeonArenaArray<int32> Positions;
+
+  // Field cells sorted by tile count; bucket N is Order[BucketStarts[N]] up to BucketStarts[N + 1]
+  TDungeonArenaArray<int32> Order;
+  int32 BucketStarts[FDungeonWaveRules::NumTiles + 2] = {};
+
+  TDungeonArenaArray<int32> Pending;
+  TDungeonArenaArray<FTrailEntry> Trail;
+  TDungeonArenaArray<FDecision> Decisions;
+};
@@ -0,0 +1,47 @@
+// AsyncGenerateDungeon.cpp
+#include "AsyncGenerateDungeon.h"
+#include "DungeonGenerator.h"
+
+UAsyncGenerateDungeon* UAsyncGenerateDungeon::GenerateDungeonAsync(ADungeonGenerator* Generator)
+{
+  UAsyncGenerateDungeon* Action = NewObject<UAsyncGenerateDungeon>();
+  Action->Generator = Generator;
+  if (Generator)
+  {
+    Action->RegisterWithGameInstance(Generator);
+  }
+  return Action;
+}
+
+void UAsyncGenerateDungeon::Activate()
+{
+  ADungeonGenerator* DungeonGenerator = Generator.Get();
+  if (!DungeonGenerator)
+  {
+    UE_LOG(LogTemp, Warning, TEXT("GenerateDungeonAsync called without a dungeon generator"));
+    Finish(false);
+    return;
+  }
+
+  TWeakObjectPtr<UAsyncGenerateDungeon> WeakThis(this);
+  DungeonGenerator->GenerateDungeonAsync([WeakThis](bool bCompleted)
+    {
+      if (UAsyncGenerateDungeon* Action = WeakThis.Get())
+      {
+        Action->Finish(bCompleted);
+      }
+    });
+}
+
+void UAsyncGenerateDungeon::Finish(bool bCompleted)
+{
+  if (bCompleted)
+  {
+    OnCompleted.Broadcast();
+  }
+  else
+  {
+    OnCancelled.Broadcast();
+  }
+  SetReadyToDestroy();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "AsyncGenerateDungeon.generated.h"
+
+class ADungeonGenerator;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FAsyncGenerateDungeonPin);
+
+// Blueprint node that generates the next floor off the game thread
+UCLASS()
+class HORRORCITY_API UAsyncGenerateDungeon : public UBlueprintAsyncActionBase
+{
+  GENERATED_BODY()
+
+public:
+  UFUNCTION(BlueprintCallable, Category = "Dungeon Generation", meta = (BlueprintInternalUseOnly = "true"))
+  static UAsyncGenerateDungeon* GenerateDungeonAsync(ADungeonGenerator* Generator);
+
+  // The new floor's safe room is up; the rest keeps spawning until the generator's OnDungeonReady
+  UPROPERTY(BlueprintAssignable)
+  FAsyncGenerateDungeonPin OnCompleted;
+
+  // The request was replaced, cancelled or the generator went away
+  UPROPERTY(BlueprintAssignable)
+  FAsyncGenerateDungeonPin OnCancelled;
+
+  virtual void Activate() override;
+
+private:
+  void Finish(bool bCompleted);
+
+  TWeakObjectPtr<ADungeonGenerator> Generator;
+};
@@ -0,0 +1,171 @@
+// DungeonBenchmarkCommandlet.cpp
+#include "DungeonBenchmarkCommandlet.h"
+#include "DungeonCommandletHelpers.h"
+#include "DungeonLayout.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+  // Samples for one phase of one configuration, in milliseconds
+  struct FPhaseSamples
+  {
+    const TCHAR* Name;
+    TArray<double> Ms;
+  };
+
+  struct FPhaseSummary
+  {
+    double Min = 0.0;
+    double Mean = 0.0;
+    double P50 = 0.0;
+    double P90 = 0.0;
+    double P99 = 0.0;
+    double Max = 0.0;
+  };
+
+  // Nearest-rank percentile of an ascending array
+  double Percentile(const TArray<double>& Sorted, double Percent)
+  {
+    int32 Rank = FMath::CeilToInt(Percent / 100.0 * Sorted.Num());
+    return Sorted[FMath::Clamp(Rank - 1, 0, Sorted.Num() - 1)];
+  }
+
+  FPhaseSummary Summarise(TArray<double> Samples)
+  {
+    FPhaseSummary Summary;
+    if (Samples.Num() == 0) return Summary;
+
+    Samples.Sort();
+    double Sum = 0.0;
+    for (double Sample : Samples)
+    {
+      Sum += Sample;
+    }
+    Summary.Min = Samples[0];
+    Summary.Mean = Sum / Samples.Num();
+    Summary.P50 = Percentile(Samples, 50.0);
+    Summary.P90 = Percentile(Samples, 90.0);
+    Summary.P99 = Percentile(Samples, 99.0);
+    Summary.Max = Samples.Last();
+    return Summary;
+  }
+}
+
+UDungeonBenchmarkCommandlet::UDungeonBenchmarkCommandlet()
+{
+  IsClient = false;
+  IsServer = false;
+  IsEditor = false;
+  LogToConsole = true;
+}
+
+int32 UDungeonBenchmarkCommandlet::Main(const FString& Params)
+{
+  const TArray<int32> CellCounts = DungeonCommandlet::ParseList<int32>(Params, TEXT("CellCounts="), { 5, 15, 50, 100, 500, 1000, 5000, 10000, 50000, 100000 });
+  const TArray<float> LoopFractions = DungeonCommandlet::ParseList<float>(Params, TEXT("LoopFractions="), { 0.0f, 0.3f, 0.6f });
+  const TArray<float> LockedAreaSizes = DungeonCommandlet::ParseList<float>(Params, TEXT("LockedAreaSizes="), { 0.1f, 0.3f, 0.5f });
+
+  int32 SeedCount = 20;
+  int32 Runs = 3;
+  FParse::Value(*Params, TEXT("Seeds="), SeedCount);
+  FParse::Value(*Params, TEXT("Runs="), Runs);
+  SeedCount = FMath::Max(SeedCount, 1);
+  Runs = FMath::Max(Runs, 1);
+  const bool bWaveCollapse = FParse::Param(*Params, TEXT("WaveCollapse"));
+
+  FString OutputBase;
+  if (!FParse::Value(*Params, TEXT("Output="), OutputBase))
+  {
+    OutputBase = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("DungeonLayout-%s"), *FDateTime::Now().ToString());
+  }
+
+  FString Csv = TEXT("cell_count,loop_fraction,locked_area_size,samples,mean_cells,phase,min_ms,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n");
+  TArray<FString> JsonRows;
+
+  FDungeonLayoutGenerator Generator;
+  for (int32 CellCount : CellCounts)
+  {
+    for (float LoopFraction : LoopFractions)
+    {
+      for (float LockedAreaSize : LockedAreaSizes)
+      {
+        FPhaseSamples Phases[] = {
+          { TEXT("growth"), {} },
+          { TEXT("minimal_connections"), {} },
+          { TEXT("locked_area"), {} },
+          { TEXT("extra_doors"), {} },
+          { TEXT("accessible_area"), {} },
+          { TEXT("enemies"), {} },
+          { TEXT("total"), {} }
+        };
+        int64 TotalCells = 0;
+        int32 ScratchAllocations = 0;
+
+        FDungeonLayoutParams LayoutParams;
+        LayoutParams.CellCount = CellCount;
+        LayoutParams.LoopFraction = LoopFraction;
+        LayoutParams.LockedAreaSizePercent = LockedAreaSize;
+        LayoutParams.Engine = bWaveCollapse ? EDungeonLayoutEngine::WaveFunctionCollapse : EDungeonLayoutEngine::Growth;
+
+        // Fixed seeds so two runs of the suite time the same layouts. The first
+        // generation warms the generator's arena and is not counted.
+        LayoutParams.Seed = 0;
+        Generator.Generate(LayoutParams);
+
+        for (int32 SeedIndex = 1; SeedIndex <= SeedCount; SeedIndex++)
+        {
+          LayoutParams.Seed = FDungeonLayoutGenerator::MixSeed(SeedIndex, (uint32)CellCount);
+          for (int32 Run = 0; Run < Runs; Run++)
+          {
+            FDungeonLayout Layout = Generator.Generate(LayoutParams);
+            TotalCells += Layout.GetGrid().NumCells();
+            ScratchAllocations += Generator.GetLastScratchAllocations();
+
+            const FDungeonLayoutTimings& Timings = Generator.GetLastTimings();
+            Phases[0].Ms.Add(Timings.Growth * 1000.0);
+            Phases[1].Ms.Add(Timings.MinimalConnections * 1000.0);
+            Phases[2].Ms.Add(Timings.LockedArea * 1000.0);
+            Phases[3].Ms.Add(Timings.ExtraDoors * 1000.0);
+            Phases[4].Ms.Add(Timings.AccessibleArea * 1000.0);
+            Phases[5].Ms.Add(Timings.Enemies * 1000.0);
+            Phases[6].Ms.Add(Timings.GetTotal() * 1000.0);
+          }
+        }
+
+        const int32 Samples = SeedCount * Runs;
+        const double MeanCells = (double)TotalCells / Samples;
+        TArray<FString> JsonPhases;
+        for (const FPhaseSamples& Phase : Phases)
+        {
+          const FPhaseSummary Summary = Summarise(Phase.Ms);
+          Csv += FString::Printf(TEXT("%d,%.3f,%.3f,%d,%.1f,%s,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n"),
+            CellCount, LoopFraction, LockedAreaSize, Samples, MeanCells, Phase.Name,
+            Summary.Min, Summary.Mean, Summary.P50, Summary.P90, Summary.P99, Summary.Max);
+          JsonPhases.Add(FString::Printf(TEXT("\"%s\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}"),
+            Phase.Name, Summary.Min, Summary.Mean, Summary.P50, Summary.P90, Summary.P99, Summary.Max));
+        }
+        JsonRows.Add(FString::Printf(TEXT("    {\"cell_count\": %d, \"loop_fraction\": %.3f, \"locked_area_size\": %.3f, \"samples\": %d, \"mean_cells\": %.1f, \"scratch_allocations\": %d, \"phases_ms\": {%s}}"),
+          CellCount, LoopFraction, LockedAreaSize, Samples, MeanCells, ScratchAllocations, *FString::Join(JsonPhases, TEXT(", "))));
+
+        const FPhaseSummary Total = Summarise(Phases[6].Ms);
+        UE_LOG(LogTemp, Display, TEXT("CellCount %d, LoopFraction %.2f, LockedAreaSize %.2f: total p50 %.3f ms, p99 %.3f ms, %d scratch allocations"),
+          CellCount, LoopFraction, LockedAreaSize, Total.P50, Total.P99, ScratchAllocations);
+      }
+    }
+  }
+
+  const FString Json = FString::Printf(TEXT("{\n  \"seeds\": %d,\n  \"runs\": %d,\n  \"engine\": \"%s\",\n  \"bitboard_instruction_set\": \"%s\",\n  \"results\": [\n%s\n  ]\n}\n"),
+    SeedCount, Runs, bWaveCollapse ? TEXT("wave_function_collapse") : TEXT("growth"), FDungeonBitboard::GetInstructionSet(), *FString::Join(JsonRows, TEXT(",\n")));
+
+  const FString CsvPath = OutputBase + TEXT(".csv");
+  const FString JsonPath = OutputBase + TEXT(".json");
+  if (!FFileHelper::SaveStringToFile(Csv, *CsvPath) || !FFileHelper::SaveStringToFile(Json, *JsonPath))
+  {
+    UE_LOG(LogTemp, Error, TEXT("Failed to write benchmark results to %s"), *OutputBase);
+    return 1;
+  }
+
+  UE_LOG(LogTemp, Display, TEXT("Wrote %s and %s"), *CsvPath, *JsonPath);
+  return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonBenchmarkCommandlet.generated.h"
+
+// Times every layout phase over a sweep of floor sizes and parameters and writes
+// the percentiles as CSV and JSON, so runs can be diffed for regressions. Only
+// FDungeonLayoutGenerator::Generate is timed; no world is loaded.
+//
+//   UnrealEditor-Cmd HorrorCity.uproject -run=DungeonBenchmark
+//     [-CellCounts=5,100,1000] [-LoopFractions=0,0.3] [-LockedAreaSizes=0.3]
+//     [-Seeds=20] [-Runs=3] [-WaveCollapse] [-Output=Path/Without/Extension]
+//
+// -WaveCollapse times the wave function collapse engine instead of room growth.
+//
+// Spawning rooms and rebuilding navigation are not covered. They need a loaded map
+// with an ADungeonGenerator, which logs "Floor N spawned in X ms, navigation ready
+// Y ms later" for every floor it builds; "stat Dungeon" breaks those down live.
+UCLASS()
+class HORRORCITY_API UDungeonBenchmarkCommandlet : public UCommandlet
+{
+  GENERATED_BODY()
+
+public:
+  UDungeonBenchmarkCommandlet();
+
+  virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Command line parsing shared by the dungeon commandlets
+namespace DungeonCommandlet
+{
+  // Reads a comma separated list such as -CellCounts=5,15,50. Returns Default when
+  // the switch is missing or empty.
+  template<typename T>
+  TArray<T> ParseList(const FString& Params, const TCHAR* Key, TArray<T> Default)
+  {
+    FString Value;
+    if (!FParse::Value(*Params, Key, Value, false)) return Default;
+
+    TArray<FString> Parts;
+    Value.ParseIntoArray(Parts, TEXT(","));
+    TArray<T> Result;
+    for (const FString& Part : Parts)
+    {
+      T Parsed{};
+      LexFromString(Parsed, *Part.TrimStartAndEnd());
+      Result.Add(Parsed);
+    }
+    return Result.Num() > 0 ? Result : Default;
+  }
+}
@@ -3,699 +3,1205 @@
 #include "Kismet/GameplayStatics.h"
 #include "NavigationSystem.h"
 #include "DrawDebugHelpers.h"
+#include "Async/Async.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "TimerManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/Paths.h"
+#include "Net/UnrealNetwork.h"
+#include "GameFramework/GameModeBase.h"
+#include "DungeonLayoutFormat.h"
+#include "DungeonLayoutSyncComponent.h"
+#include "DungeonLayoutStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Generate Dungeon"), STAT_DungeonGenerateDungeon, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Resolve Rooms"), STAT_DungeonResolveRooms, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Apply Layout"), STAT_DungeonApplyLayout, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Build Spawn Queue"), STAT_DungeonBuildSpawnQueue, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Spawn Slice"), STAT_DungeonSpawnSlice, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Spawn Room"), STAT_DungeonSpawnRoom, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Spawn Enemy"), STAT_DungeonSpawnEnemy, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Spawn Locked Door"), STAT_DungeonSpawnLockedDoor, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Clear Dungeon"), STAT_DungeonClearDungeon, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Update Streaming"), STAT_DungeonUpdateStreaming, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Rebuild Navigation"), STAT_DungeonRebuildNavigation, STATGROUP_Dungeon);
+DECLARE_CYCLE_STAT(TEXT("Stitch Nav Cell"), STAT_DungeonStitchNavCell, STATGROUP_Dungeon);
 
 ADungeonGenerator::ADungeonGenerator()
 {
-  PrimaryActorTick.bCanEverTick = false;
+  // Ticks only while a floor is being spawned
+  PrimaryActorTick.bCanEverTick = true;
+  PrimaryActorTick.bStartWithTickEnabled = false;
   RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
+
+  // Only the floor state replicates; every machine spawns the rooms itself
+  bReplicates = true;
+  bAlwaysRelevant = true;
+}
+
+void ADungeonGenerator::PostLoad()
+{
+  Super::PostLoad();
+
+  // Levels saved before LoopFraction keep the number they had. It now places that
+  // share of the loops exactly, fewer than the old per-pair rolls did; see LoopFraction.
+  if (ExtraDoorChance_DEPRECATED >= 0.0f)
+  {
+    LoopFraction = ExtraDoorChance_DEPRECATED;
+    ExtraDoorChance_DEPRECATED = -1.0f;
+  }
+}
+
+void ADungeonGenerator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+  Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+  DOREPLIFETIME(ADungeonGenerator, FloorState);
+  DOREPLIFETIME(ADungeonGenerator, FloorDelta);
+}
+
+bool FDungeonFloorNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+  // Counts and the engine are small and never negative, so they go packed
+  uint32 PackedFloor = Floor;
+  uint32 PackedCellCount = CellCount;
+  uint32 PackedEnemyCount = EnemyCount;
+  uint8 bPackedBossFloor = bBossFloor;
+  uint32 PackedLayoutEngine = (uint32)LayoutEngine;
+
+  Ar << Revision;
+  Ar << Seed;
+  Ar.SerializeIntPacked(PackedFloor);
+  Ar.SerializeIntPacked(PackedCellCount);
+  Ar.SerializeIntPacked(PackedEnemyCount);
+  Ar.SerializeIntPacked(PackedLayoutEngine);
+  Ar << LoopFraction;
+  Ar << LockedAreaSizePercent;
+  Ar.SerializeBits(&bPackedBossFloor, 1);
+  Ar << Checksum;
+
+  if (Ar.IsLoading())
+  {
+    Floor = PackedFloor;
+    CellCount = PackedCellCount;
+    EnemyCount = PackedEnemyCount;
+    bBossFloor = bPackedBossFloor != 0;
+    LayoutEngine = (ERoomLayoutEngine)PackedLayoutEngine;
+  }
+
+  bOutSuccess = true;
+  return true;
 }
 
 void ADungeonGenerator::BeginPlay()
 {
   Super::BeginPlay();
-  GenerateDungeon();
 
+  if (bPoolRooms && RoomPoolWarmUpCount > 0)
+  {
+    WarmUpRoomPool(RoomPoolWarmUpCount);
+  }
+
+  if (bRandomizeSeed)
+  {
+    Seed = FMath::Rand();
+  }
+
+  if (bCacheFloors)
+  {
+    FloorCache.AddReadDirectory(FPaths::ProjectContentDir() / TEXT("DungeonFloors"));
+    FloorCache.SetWriteDirectory(FPaths::ProjectSavedDir() / TEXT("DungeonFloors"));
+  }
+
+  // Clients wait for the server's floor state instead of picking their own
+  if (!HasAuthority()) return;
+
+  if (GetNetMode() != NM_Standalone)
+  {
+    PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &ADungeonGenerator::AddLayoutSyncComponent);
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+      AddLayoutSyncComponent(nullptr, It->Get());
+    }
+  }
+
+  GenerateDungeonAsync([this](bool bCompleted)
+    {
+      if (bCompleted)
+      {
+        MovePlayerToSafeRoom();
+      }
+    });
+}
+
+void ADungeonGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+  CancelDungeonGeneration();
+  CancelPrefetch();
+  RoomPool.Empty();
+  FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+  Super::EndPlay(EndPlayReason);
+}
+
+void ADungeonGenerator::MovePlayerToSafeRoom()
+{
   APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
   if (PlayerPawn)
   {
     float offset = CellSize / 2;
-    FVector SafeRoomCenter(SafeRoomGridPos.X * CellSize + offset, SafeRoomGridPos.Y * CellSize + offset, 100.0f);
+    FVector SafeRoomCenter(Layout.GetSafeRoom().X * CellSize + offset, Layout.GetSafeRoom().Y * CellSize + offset, 100.0f);
     PlayerPawn->SetActorLocation(SafeRoomCenter);
   }
 }
 
 void ADungeonGenerator::NextLevel()
 {
-  Floor++;
-  CellCount += 3;
-  EnemyCount = CellCount * EnemiesPerRoom;
+  // Clients follow the server's floor state
+  if (!HasAuthority()) return;
 
-  if (BossFloorClass && FloorsPerBoss > 0 && Floor % FloorsPerBoss == 0)
+  AdvanceFloor(Floor, CellCount, EnemyCount);
+
+  if (IsBossFloor(Floor))
   {
     SpawnBossFloor();
   }
   else {
-    GenerateDungeon();
-
-    APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
-    if (PlayerPawn)
+    // Use the prefetched floor if it was built for exactly these params
+    const FDungeonLayoutParams Params = MakeLayoutParams(Floor, CellCount, EnemyCount);
+    if (bHasPrefetchedLayout && PrefetchParams == Params)
+    {
+      CancelDungeonGeneration();
+      bHasPrefetchedLayout = false;
+      ApplyLayout(MoveTemp(PrefetchedLayout), MoveTemp(PrefetchedRooms));
+    }
+    else
     {
-      float offset = CellSize / 2;
-      FVector SafeRoomCenter(SafeRoomGridPos.X * CellSize + offset, SafeRoomGridPos.Y * CellSize + offset, 100.0f);
-      PlayerPawn->SetActorLocation(SafeRoomCenter);
+      UE_LOG(LogTemp, Log, TEXT("No prefetched layout for floor %d, generating now"), Floor);
+      GenerateDungeon();
     }
+
+    MovePlayerToSafeRoom();
   }
 }
 
+void ADungeonGenerator::AdvanceFloor(int32& InOutFloor, int32& InOutCellCount, int32& InOutEnemyCount) const
+{
+  InOutFloor++;
+  InOutCellCount += 3;
+  InOutEnemyCount = InOutCellCount * EnemiesPerRoom;
+}
+
+bool ADungeonGenerator::IsBossFloor(int32 ForFloor) const
+{
+  return BossFloorClass && FloorsPerBoss > 0 && ForFloor % FloorsPerBoss == 0;
+}
+
 void ADungeonGenerator::SpawnBossFloor() 
 {
   //Clear old floor and spawn prebuilt Boss Floor
+  CancelDungeonGeneration();
   ClearDungeon();
 
-  OccupiedCells.Empty();
-  AvailablePositions.Empty();
-  RoomMap.Empty();
-  ConnectedDoors.Empty();
-  SpawnedObjects.Empty();
-  LockedArea.Empty();
-  AccessibleArea.Empty();
-
-  FActorSpawnParameters SpawnParams;
-  SpawnParams.Owner = this;
-
-  AActor* RoomInstance = GetWorld()->SpawnActor<AActor>(BossFloorClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+  AActor* RoomInstance = SpawnRoomActor(BossFloorClass, FVector::ZeroVector, FRotator::ZeroRotator);
 
   if (RoomInstance)
   {
     ActiveDungeonRooms.Add(RoomInstance);
   }
+  PublishFloorState(true);
 
   APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
-  if (PlayerPawn)
+  if (PlayerPawn && HasAuthority())
   {
     PlayerPawn->SetActorLocation(FVector::ZeroVector);
   }
+
+  StartPrefetch();
 }
 
 void ADungeonGenerator::GenerateDungeon()
 {
-  ClearDungeon();
+  LLM_SCOPE_BYTAG(Dungeon);
+  SCOPE_CYCLE_COUNTER(STAT_DungeonGenerateDungeon);
 
-  OccupiedCells.Empty();
-  AvailablePositions.Empty();
-  RoomMap.Empty();
-  ConnectedDoors.Empty();
-  SpawnedObjects.Empty();
-  LockedArea.Empty();
-  AccessibleArea.Empty();
-
-  // Generate room positions (but don't spawn yet)
-  FIntPoint StartPos(0, 0);
-  OccupiedCells.Add(StartPos);
-  AddAdjacentPositions(StartPos);
+  CancelDungeonGeneration();
 
-  // Force room 1 to be a dead end by only adding one neighbor initially
-  if (AvailablePositions.Num() > 0)
-  {
-    int32 RandomIndex = FMath::RandRange(0, AvailablePositions.Num() - 1);
-    FIntPoint FirstRoom = AvailablePositions[RandomIndex];
-    OccupiedCells.Add(FirstRoom);
-    AvailablePositions.RemoveAt(RandomIndex);
-    AddAdjacentPositions(FirstRoom);
-  }
+  // Build the layout first, then turn it into actors
+  const FDungeonLayoutParams Params = MakeLayoutParams(Floor, CellCount, EnemyCount);
+  UE_LOG(LogTemp, Log, TEXT("Generating floor %d (run seed %d, floor seed %d)"), Floor, Seed, Params.Seed);
 
-  for (int32 i = 2; i < CellCount; i++)
-  {
-    if (AvailablePositions.Num() == 0)
-    {
-      UE_LOG(LogTemp, Warning, TEXT("No more available positions for rooms!"));
-      break;
-    }
+  FDungeonLayout NewLayout = FloorCache.LoadOrGenerate(LayoutGenerator, Params);
+  TArray<FResolvedRoom> NewResolvedRooms;
+  ResolveRooms(NewLayout, NewResolvedRooms);
+  ApplyLayout(MoveTemp(NewLayout), MoveTemp(NewResolvedRooms));
+}
 
-    int32 RandomIndex = FMath::RandRange(0, AvailablePositions.Num() - 1);
-    FIntPoint NewPos = AvailablePositions[RandomIndex];
+void ADungeonGenerator::GenerateDungeonAsync(TFunction<void(bool bCompleted)> OnComplete)
+{
+  CancelDungeonGeneration();
 
-    OccupiedCells.Add(NewPos);
-    AvailablePositions.RemoveAt(RandomIndex);
-    AddAdjacentPositions(NewPos);
-  }
+  const FDungeonLayoutParams Params = MakeLayoutParams(Floor, CellCount, EnemyCount);
+  UE_LOG(LogTemp, Log, TEXT("Generating floor %d async (run seed %d, floor seed %d)"), Floor, Seed, Params.Seed);
 
-  // Add SafeRoom at furthest west position
-  FIntPoint SafeRoomPos(0, 0);
-  int32 MinX = 0;
-  for (const FIntPoint& Pos : OccupiedCells)
-  {
-    if (Pos.X < MinX)
-    {
-      MinX = Pos.X;
-      SafeRoomPos = Pos;
-    }
-  }
-  SafeRoomPos.X -= 1; // Place one cell west of current westernmost
-	SafeRoomGridPos = SafeRoomPos;
-  OccupiedCells.Add(SafeRoomPos);
-  AddAdjacentPositions(SafeRoomPos);
+  TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe> Cancellation = MakeShared<FDungeonLayoutCancellation, ESPMode::ThreadSafe>();
+  PendingCancellation = Cancellation;
+  PendingCallback = MoveTemp(OnComplete);
 
-  // Add EndRoom at furthest east position
-  FIntPoint EndRoomPos(0, 0);
-  int32 MaxX = 0;
-  for (const FIntPoint& Pos : OccupiedCells)
-  {
-    if (Pos.X > MaxX)
+  LaunchLayoutTask(Params, Cancellation, [Cancellation](ADungeonGenerator& Generator, FDungeonLayout&& NewLayout)
     {
-      MaxX = Pos.X;
-      EndRoomPos = Pos;
-    }
-  }
-  EndRoomPos.X += 1; // Place one cell east of current easternmost
-	EndRoomGridPos = EndRoomPos;
-  OccupiedCells.Add(EndRoomPos);
-  AddAdjacentPositions(EndRoomPos);
-
-  // Create all connections first
-  CreateMinimalConnections();
-  CreateLockedArea();
-  AddExtraDoors();
-  CalculateAccessibleArea();
+      if (Generator.PendingCancellation != Cancellation) return;
 
-  // NOW spawn rooms based on connectivity
-  SpawnAllRooms();
+      Generator.PendingCancellation.Reset();
+      TFunction<void(bool)> Callback = MoveTemp(Generator.PendingCallback);
+      Generator.PendingCallback = nullptr;
 
-  // Setup doors and spawn objects
-  SpawnLockedDoor();
-  SpawnObjectsInFarRooms();
-  RebuildNavigation();
+      TArray<FResolvedRoom> NewResolvedRooms;
+      Generator.ResolveRooms(NewLayout, NewResolvedRooms);
+      Generator.ApplyLayout(MoveTemp(NewLayout), MoveTemp(NewResolvedRooms));
+      if (Callback)
+      {
+        Callback(true);
+      }
+    });
 }
 
-void ADungeonGenerator::SpawnAllRooms()
+void ADungeonGenerator::LaunchLayoutTask(const FDungeonLayoutParams& Params, const TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe>& Cancellation,
+  TFunction<void(ADungeonGenerator&, FDungeonLayout&&)> OnFinished)
 {
+  // The worker only touches a generator no other task holds, the copied params and a copy of the
+  // cache; everything that involves actors or room classes waits for the game thread.
+  TWeakObjectPtr<ADungeonGenerator> WeakThis(this);
+  AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Params, Cache = FloorCache, WorkerGenerator = AcquireWorkerGenerator(), Cancellation,
+    OnFinished = MoveTemp(OnFinished)]() mutable
+    {
+      FDungeonLayout NewLayout = Cache.LoadOrGenerate(*WorkerGenerator, Params, Cancellation.Get());
+      WorkerGenerator.Reset(); // Free for the next task before the game thread hears about this one
+      if (Cancellation->IsCancelled()) return;
 
-  if (OccupiedCells.Contains(SafeRoomGridPos))
-  {
-    SpawnSpecialRoom(SafeRoom, SafeRoomGridPos);
-  }
+      AsyncTask(ENamedThreads::GameThread, [WeakThis, Cancellation, OnFinished = MoveTemp(OnFinished), NewLayout = MoveTemp(NewLayout)]() mutable
+        {
+          ADungeonGenerator* Generator = WeakThis.Get();
+          if (Generator && !Cancellation->IsCancelled())
+          {
+            OnFinished(*Generator, MoveTemp(NewLayout));
+          }
+        });
+    });
+}
 
-  if (OccupiedCells.Contains(EndRoomGridPos))
+TSharedPtr<FDungeonLayoutGenerator, ESPMode::ThreadSafe> ADungeonGenerator::AcquireWorkerGenerator()
+{
+  // A cancelled task may still be finishing, so that generator stays busy until it lets go
+  for (const TSharedPtr<FDungeonLayoutGenerator, ESPMode::ThreadSafe>& WorkerGenerator : WorkerGenerators)
   {
-    SpawnSpecialRoom(EndRoomClass, EndRoomGridPos);
+    if (WorkerGenerator.IsUnique())
+    {
+      return WorkerGenerator;
+    }
   }
+  return WorkerGenerators.Add_GetRef(MakeShared<FDungeonLayoutGenerator, ESPMode::ThreadSafe>());
+}
 
-  if (OccupiedCells.Contains(KeyRoomGridPos) && KeyRoomClass)
-  {
-    SpawnSpecialRoom(KeyRoomClass, KeyRoomGridPos);
-  }
+void ADungeonGenerator::CancelDungeonGeneration()
+{
+  if (!PendingCancellation) return;
 
-  // Spawn origin room
-  FIntPoint Origin(0, 0);
-  if (OccupiedCells.Contains(Origin))
-  {
-    SpawnRoom(Origin);
-  }
+  PendingCancellation->Cancel();
+  PendingCancellation.Reset();
 
-  // Spawn remaining rooms
-  for (const FIntPoint& GridPos : OccupiedCells)
+  TFunction<void(bool)> Callback = MoveTemp(PendingCallback);
+  PendingCallback = nullptr;
+  if (Callback)
   {
-    if (GridPos != Origin && GridPos != SafeRoomGridPos && GridPos != EndRoomGridPos && !RoomMap.Contains(GridPos))
-    {
-      SpawnRoom(GridPos);
-    }
+    Callback(false);
   }
 }
 
-void ADungeonGenerator::SpawnSpecialRoom(TSubclassOf<AActor> RoomClass, FIntPoint GridPos)
+void ADungeonGenerator::StartPrefetch()
 {
-  if (!RoomClass)
+  int32 NextFloor = Floor;
+  int32 NextCellCount = CellCount;
+  int32 NextEnemyCount = EnemyCount;
+  AdvanceFloor(NextFloor, NextCellCount, NextEnemyCount);
+
+  if (!bPrefetchNextFloor || IsBossFloor(NextFloor))
   {
-    UE_LOG(LogTemp, Error, TEXT("No room class provided for position (%d, %d)"), GridPos.X, GridPos.Y);
+    CancelPrefetch();
     return;
   }
 
-  // Determine which direction the room opens (should have exactly 1 connection)
-  TArray<ERoomDirection> OpenDirections;
+  // Already built or building this exact floor
+  const FDungeonLayoutParams Params = MakeLayoutParams(NextFloor, NextCellCount, NextEnemyCount);
+  if ((bHasPrefetchedLayout || PrefetchCancellation) && PrefetchParams == Params) return;
 
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(0, 1)))
-    OpenDirections.Add(ERoomDirection::SOUTH);
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(1, 0)))
-    OpenDirections.Add(ERoomDirection::EAST);
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(0, -1)))
-    OpenDirections.Add(ERoomDirection::NORTH);
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(-1, 0)))
-    OpenDirections.Add(ERoomDirection::WEST);
+  CancelPrefetch();
 
-  FRotator SpawnRotation = FRotator::ZeroRotator;
-  if (OpenDirections.Num() > 0)
-  {
-    SpawnRotation = GetDeadendRotation(OpenDirections[0]);
-  }
+  TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe> Cancellation = MakeShared<FDungeonLayoutCancellation, ESPMode::ThreadSafe>();
+  PrefetchCancellation = Cancellation;
+  PrefetchParams = Params;
 
-  FVector SpawnLocation(GridPos.X * CellSize + CellSize / 2.0f, GridPos.Y * CellSize + CellSize / 2.0f, 0.0f);
-  FActorSpawnParameters SpawnParams;
-  SpawnParams.Owner = this;
+  LaunchLayoutTask(Params, Cancellation, [Cancellation](ADungeonGenerator& Generator, FDungeonLayout&& NewLayout)
+    {
+      if (Generator.PrefetchCancellation != Cancellation) return;
 
-  AActor* RoomInstance = GetWorld()->SpawnActor<AActor>(RoomClass, SpawnLocation, SpawnRotation, SpawnParams);
+      Generator.PrefetchCancellation.Reset();
+      Generator.PrefetchedLayout = MoveTemp(NewLayout);
+      Generator.ResolveRooms(Generator.PrefetchedLayout, Generator.PrefetchedRooms);
+      Generator.bHasPrefetchedLayout = true;
+    });
+}
 
-  if (RoomInstance)
+void ADungeonGenerator::CancelPrefetch()
+{
+  if (PrefetchCancellation)
   {
-    ActiveDungeonRooms.Add(RoomInstance);
-    RoomMap.Add(GridPos, RoomInstance);
+    PrefetchCancellation->Cancel();
+    PrefetchCancellation.Reset();
   }
+
+  bHasPrefetchedLayout = false;
+  PrefetchedLayout = FDungeonLayout();
+  PrefetchedRooms.Empty();
 }
 
-void ADungeonGenerator::SpawnRoom(FIntPoint GridPos)
+void ADungeonGenerator::ApplyLayout(FDungeonLayout&& NewLayout, TArray<FResolvedRoom>&& NewResolvedRooms)
 {
-  // Determine which directions have connections
-  TArray<ERoomDirection> OpenDirections;
+  LLM_SCOPE_BYTAG(Dungeon);
+  SCOPE_CYCLE_COUNTER(STAT_DungeonApplyLayout);
 
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(0, 1)))
-    OpenDirections.Add(ERoomDirection::SOUTH);
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(1, 0)))
-    OpenDirections.Add(ERoomDirection::EAST);
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(0, -1)))
-    OpenDirections.Add(ERoomDirection::NORTH);
-  if (HasDoorConnection(GridPos, GridPos + FIntPoint(-1, 0)))
-    OpenDirections.Add(ERoomDirection::WEST);
+  // Rooms that come back unchanged keep their actor, so neither their spawn nor
+  // their navmesh tiles have to be redone. Everything else is released below.
+  TMap<FIntPoint, AActor*> NewKeptRooms;
+  NavDirtyCells.Reset();
+  CollectKeptRooms(NewLayout, NewResolvedRooms, NewKeptRooms);
 
-  // Select appropriate room class and rotation
-  TSubclassOf<AActor> SelectedClass = nullptr;
-  FRotator SpawnRotation = FRotator::ZeroRotator;
-
-  int32 ConnectionCount = OpenDirections.Num();
+  ClearDungeon();
 
-  if (ConnectionCount == 1)
+  Layout = MoveTemp(NewLayout);
+  ResolvedRooms = MoveTemp(NewResolvedRooms);
+  RoomActors.Init(nullptr, Layout.GetGrid().NumIndices());
+  KeptRooms = MoveTemp(NewKeptRooms);
+  bNavigationReady = false;
+  bFloorSpawned = false;
+  SpawnStartTime = FPlatformTime::Seconds();
+
+  const FDungeonGrid& Grid = Layout.GetGrid();
+#if STATS
+  int32 DoorSides = 0;
+  for (const FIntPoint& Cell : Grid.GetCells())
   {
-    SelectedClass = GetRandomClass(DeadendRooms);
-    SpawnRotation = GetDeadendRotation(OpenDirections[0]);
+    DoorSides += FMath::CountBits(Grid.GetDoors(Cell));
   }
-  else if (ConnectionCount == 2)
+  SET_DWORD_STAT(STAT_DungeonCells, Grid.NumCells());
+  SET_DWORD_STAT(STAT_DungeonDoors, DoorSides / 2);
+#endif
+  if (bStreamRooms)
   {
-    if (IsOpposite(OpenDirections[0], OpenDirections[1]))
+    // Start with the chunks around the safe room, where the player arrives
+    TArray<int32> Loaded, Unloaded;
+    const FIntPoint Start[] = { Layout.GetSafeRoom() };
+    RoomStreamer.Reset(Grid, StreamChunkSize);
+    RoomStreamer.Update(Grid, Start, StreamLoadHops, GetStreamUnloadHops(), Loaded, Unloaded);
+
+    // Carried-over rooms outside them go now rather than waiting for a spawn step
+    for (auto It = KeptRooms.CreateIterator(); It; ++It)
     {
-      SelectedClass = GetRandomClass(StraightRooms);
-      SpawnRotation = GetStraightRotation(OpenDirections[0]);
+      if (!RoomStreamer.IsResident(Grid.ToIndex(It.Key())))
+      {
+        ReleaseRoomActor(It.Value());
+        AddNavDirtyCell(It.Key());
+        It.RemoveCurrent();
+      }
     }
-    else
+  }
+
+  for (const FIntPoint& Cell : Grid.GetCells())
+  {
+    if (!KeptRooms.Contains(Cell) && RoomStreamer.IsResident(Grid.ToIndex(Cell)))
     {
-      SelectedClass = GetRandomClass(TurnRooms);
-      SpawnRotation = GetTurnRotation(OpenDirections[0], OpenDirections[1]);
+      AddNavDirtyCell(Cell);
     }
   }
-  else if (ConnectionCount == 3)
+  if (Layout.HasLockedDoor())
   {
-    SelectedClass = GetRandomClass(TJunctionRooms);
-    SpawnRotation = GetTJunctionRotation(OpenDirections);
+    AddNavDirtyCell(Layout.GetLockedDoorRoom());
+    AddNavDirtyCell(Layout.GetLockedDoorNeighbour());
   }
-  else if (ConnectionCount == 4)
+
+  // Clients apply kills that arrived while the floor was being built before
+  // queueing, so those enemies never spawn
+  PublishFloorState(false);
+  LayoutRevision = FloorState.Revision;
+  ApplyFloorDelta();
+
+  // The first slice runs now so the safe room exists before anyone moves the player
+  BuildSpawnQueue();
+  ProcessSpawnQueue();
+
+  if (bStreamRooms)
   {
-    SelectedClass = GetRandomClass(CrossroadRooms);
+    GetWorldTimerManager().SetTimer(StreamTimer, this, &ADungeonGenerator::UpdateStreaming, FMath::Max(StreamUpdateInterval, 0.05f), true);
   }
+}
+
+void ADungeonGenerator::PublishFloorState(bool bBossFloor)
+{
+  if (!HasAuthority()) return;
+
+  FloorState.Revision++;
+  FloorState.Seed = Seed;
+  FloorState.Floor = Floor;
+  FloorState.CellCount = CellCount;
+  FloorState.EnemyCount = EnemyCount;
+  FloorState.LoopFraction = LoopFraction;
+  FloorState.LockedAreaSizePercent = LockedAreaSizePercent;
+  FloorState.bBossFloor = bBossFloor;
+  FloorState.LayoutEngine = LayoutEngine;
+  FloorState.Checksum = GetNetMode() != NM_Standalone ? FDungeonLayoutFormat::Checksum(Layout) : 0;
+
+  FloorDelta = FDungeonFloorNetDelta();
+  FloorDelta.Revision = FloorState.Revision;
+  FloorDelta.KilledEnemies.Init(0, (Layout.GetEnemySlots().Num() + 7) / 8);
+}
 
-  if (!SelectedClass)
+void ADungeonGenerator::OnRep_FloorState()
+{
+  if (HasAuthority()) return;
+
+  // Mirror the server so MakeLayoutParams, prefetching and the floor log agree with it
+  Seed = FloorState.Seed;
+  Floor = FloorState.Floor;
+  CellCount = FloorState.CellCount;
+  EnemyCount = FloorState.EnemyCount;
+  LoopFraction = FloorState.LoopFraction;
+  LockedAreaSizePercent = FloorState.LockedAreaSizePercent;
+  LayoutEngine = FloorState.LayoutEngine;
+
+  CancelDungeonGeneration();
+  if (FloorState.bBossFloor)
   {
-    UE_LOG(LogTemp, Error, TEXT("No room class available for position (%d, %d) with %d connections"),
-      GridPos.X, GridPos.Y, ConnectionCount);
+    SpawnBossFloor();
     return;
   }
 
-  // Offset to center the room (pivot is at northwest corner)
-  FVector SpawnLocation(GridPos.X * CellSize + CellSize / 2.0f, GridPos.Y * CellSize + CellSize / 2.0f, 0.0f);
-  FActorSpawnParameters SpawnParams;
-  SpawnParams.Owner = this;
+  const FDungeonLayoutParams Params = MakeLayoutParams(Floor, CellCount, EnemyCount);
+  if (bHasPrefetchedLayout && PrefetchParams == Params)
+  {
+    bHasPrefetchedLayout = false;
+    ApplyReplicatedLayout(MoveTemp(PrefetchedLayout), MoveTemp(PrefetchedRooms));
+    return;
+  }
 
-  AActor* RoomInstance = GetWorld()->SpawnActor<AActor>(SelectedClass, SpawnLocation, SpawnRotation, SpawnParams);
+  UE_LOG(LogTemp, Log, TEXT("Building replicated floor %d (run seed %d, floor seed %d)"), Floor, Seed, Params.Seed);
 
-  if (RoomInstance)
+  TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe> Cancellation = MakeShared<FDungeonLayoutCancellation, ESPMode::ThreadSafe>();
+  PendingCancellation = Cancellation;
+
+  LaunchLayoutTask(Params, Cancellation, [Cancellation](ADungeonGenerator& Generator, FDungeonLayout&& NewLayout)
+    {
+      if (Generator.PendingCancellation != Cancellation) return;
+
+      Generator.PendingCancellation.Reset();
+      TArray<FResolvedRoom> NewResolvedRooms;
+      Generator.ResolveRooms(NewLayout, NewResolvedRooms);
+      Generator.ApplyReplicatedLayout(MoveTemp(NewLayout), MoveTemp(NewResolvedRooms));
+    });
+}
+
+void ADungeonGenerator::ApplyReplicatedLayout(FDungeonLayout&& NewLayout, TArray<FResolvedRoom>&& NewResolvedRooms)
+{
+  if (FDungeonLayoutFormat::Checksum(NewLayout) == FloorState.Checksum)
   {
-    ActiveDungeonRooms.Add(RoomInstance);
-    RoomMap.Add(GridPos, RoomInstance);
+    ApplyLayout(MoveTemp(NewLayout), MoveTemp(NewResolvedRooms));
+    return;
+  }
+
+  // A different generator build or a stale cached file; only the server's copy will do
+  UE_LOG(LogTemp, Warning, TEXT("Floor %d built locally does not match the server, requesting the full layout"), Floor);
+
+  APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+  UDungeonLayoutSyncComponent* Channel = PlayerController ? PlayerController->FindComponentByClass<UDungeonLayoutSyncComponent>() : nullptr;
+  if (!Channel)
+  {
+    UE_LOG(LogTemp, Error, TEXT("No layout sync component on the local player controller, floor %d can't be built"), Floor);
+    return;
   }
+  Channel->RequestLayout(this, FloorState.Revision);
 }
 
-TSubclassOf<AActor> ADungeonGenerator::GetRandomClass(const TArray<TSubclassOf<AActor>>& ClassArray)
+void ADungeonGenerator::SendFullLayout(UDungeonLayoutSyncComponent* Channel, uint16 Revision)
 {
-  if (ClassArray.Num() == 0) return nullptr;
-  return ClassArray[FMath::RandRange(0, ClassArray.Num() - 1)];
+  // Only the floor that is up now; a client asking for an older one has moved on
+  if (!HasAuthority() || !Channel || Revision != FloorState.Revision || Layout.IsEmpty()) return;
+  if (Channel->IsSendingLayout(Revision)) return;
+
+  TArray<uint8> Data;
+  FDungeonLayoutFormat::Write(Layout, FDungeonLayoutFormat::HashParams(MakeLayoutParams(Floor, CellCount, EnemyCount)), Data);
+  UE_LOG(LogTemp, Log, TEXT("Sending floor %d layout (%d bytes) to %s"), Floor, Data.Num(), *GetNameSafe(Channel->GetOwner()));
+  Channel->SendLayout(this, Revision, MoveTemp(Data));
 }
 
-FRotator ADungeonGenerator::GetDeadendRotation(ERoomDirection OpenDir)
+void ADungeonGenerator::ReceiveFullLayout(uint16 Revision, const TArray<uint8>& Data)
 {
-  switch (OpenDir)
+  if (HasAuthority() || Revision != FloorState.Revision) return;
+
+  FDungeonLayout NewLayout;
+  if (!FDungeonLayoutFormat::Read(Data.GetData(), Data.Num(), NewLayout) || FDungeonLayoutFormat::Checksum(NewLayout) != FloorState.Checksum)
   {
-  case ERoomDirection::NORTH: return FRotator(0, 0, 0);
-  case ERoomDirection::EAST:  return FRotator(0, 90, 0);
-  case ERoomDirection::SOUTH: return FRotator(0, 180, 0);
-  case ERoomDirection::WEST:  return FRotator(0, 270, 0);
+    UE_LOG(LogTemp, Error, TEXT("Full layout for floor %d from the server is invalid"), Floor);
+    return;
   }
-  return FRotator::ZeroRotator;
+
+  TArray<FResolvedRoom> NewResolvedRooms;
+  ResolveRooms(NewLayout, NewResolvedRooms);
+  ApplyLayout(MoveTemp(NewLayout), MoveTemp(NewResolvedRooms));
 }
 
-FRotator ADungeonGenerator::GetStraightRotation(ERoomDirection FirstDir)
+void ADungeonGenerator::OpenLockedDoor()
 {
-  if (FirstDir == ERoomDirection::NORTH || FirstDir == ERoomDirection::SOUTH)
-    return FRotator(0, 0, 0);  // North-South
-  else
-    return FRotator(0, 90, 0); // East-West
+  if (!HasAuthority() || !Layout.HasLockedDoor() || FloorDelta.bLockedDoorOpen) return;
+
+  FloorDelta.bLockedDoorOpen = true;
+  ApplyFloorDelta();
 }
 
-FRotator ADungeonGenerator::GetTurnRotation(ERoomDirection Dir1, ERoomDirection Dir2)
+void ADungeonGenerator::NotifyEnemyKilled(AActor* Enemy)
 {
-  // Assuming turn rooms are designed with openings at North and East by default
-  bool bHasNorth = (Dir1 == ERoomDirection::NORTH || Dir2 == ERoomDirection::NORTH);
-  bool bHasEast = (Dir1 == ERoomDirection::EAST || Dir2 == ERoomDirection::EAST);
-  bool bHasSouth = (Dir1 == ERoomDirection::SOUTH || Dir2 == ERoomDirection::SOUTH);
-  bool bHasWest = (Dir1 == ERoomDirection::WEST || Dir2 == ERoomDirection::WEST);
+  if (!HasAuthority() || !Enemy) return;
 
-  if (bHasNorth && bHasEast)  return FRotator(0, 0, 0);
-  if (bHasEast && bHasSouth)  return FRotator(0, 90, 0);
-  if (bHasSouth && bHasWest)  return FRotator(0, 180, 0);
-  if (bHasWest && bHasNorth)  return FRotator(0, 270, 0);
+  const int32* Index = SlotEnemies.FindKey(Enemy);
+  const int32 Slot = Index ? Layout.GetEnemySlots().IndexOfByKey(Layout.GetGrid().ToCell(*Index)) : INDEX_NONE;
+  if (Slot == INDEX_NONE || !FloorDelta.KilledEnemies.IsValidIndex(Slot / 8)) return;
 
-  return FRotator::ZeroRotator;
+  FloorDelta.KilledEnemies[Slot / 8] |= 1 << (Slot % 8);
+  ApplyFloorDelta();
+}
+
+void ADungeonGenerator::OnRep_FloorDelta()
+{
+  ApplyFloorDelta();
 }
 
-FRotator ADungeonGenerator::GetTJunctionRotation(const TArray<ERoomDirection>& OpenDirs)
+void ADungeonGenerator::ApplyFloorDelta()
 {
-  // Assuming T-junction rooms are designed with opening at North, East, and West by default (missing South)
-  bool bHasNorth = OpenDirs.Contains(ERoomDirection::NORTH);
-  bool bHasEast = OpenDirs.Contains(ERoomDirection::EAST);
-  bool bHasSouth = OpenDirs.Contains(ERoomDirection::SOUTH);
-  bool bHasWest = OpenDirs.Contains(ERoomDirection::WEST);
+  // Changes for a floor this machine hasn't built yet wait for ApplyLayout
+  if (Layout.IsEmpty() || FloorDelta.Revision != LayoutRevision) return;
 
-  if (!bHasSouth) return FRotator(0, 0, 0);    // Missing South
-  if (!bHasWest)  return FRotator(0, 90, 0);   // Missing West
-  if (!bHasNorth) return FRotator(0, 180, 0);  // Missing North
-  if (!bHasEast)  return FRotator(0, 270, 0);  // Missing East
+  const FDungeonGrid& Grid = Layout.GetGrid();
+  const TArray<FIntPoint>& Slots = Layout.GetEnemySlots();
+  for (int32 Slot = 0; Slot < Slots.Num(); Slot++)
+  {
+    if (!FloorDelta.KilledEnemies.IsValidIndex(Slot / 8) || !(FloorDelta.KilledEnemies[Slot / 8] & (1 << (Slot % 8)))) continue;
+
+    // The null entry keeps the slot from ever being refilled. A client's own copy
+    // of the enemy goes; the server's and replicated ones are the game's to remove.
+    const int32 Index = Grid.ToIndex(Slots[Slot]);
+    AActor* Enemy = SlotEnemies.FindRef(Index).Get();
+    if (Enemy && !HasAuthority() && !Enemy->GetIsReplicated())
+    {
+      SpawnedObjects.RemoveSwap(Enemy, EAllowShrinking::No);
+      Enemy->Destroy();
+      INC_DWORD_STAT(STAT_DungeonActorsDestroyed);
+    }
+    SlotEnemies.Add(Index, nullptr);
+  }
 
-  return FRotator::ZeroRotator;
+  if (FloorDelta.bLockedDoorOpen && !bLockedDoorOpenApplied && LockedDoorActor.IsValid())
+  {
+    bLockedDoorOpenApplied = true;
+    OnLockedDoorOpened.Broadcast(LockedDoorActor.Get());
+  }
 }
 
-bool ADungeonGenerator::IsOpposite(ERoomDirection Dir1, ERoomDirection Dir2)
+void ADungeonGenerator::AddLayoutSyncComponent(AGameModeBase* GameMode, APlayerController* Player)
 {
-  return (Dir1 == ERoomDirection::NORTH && Dir2 == ERoomDirection::SOUTH) ||
-    (Dir1 == ERoomDirection::SOUTH && Dir2 == ERoomDirection::NORTH) ||
-    (Dir1 == ERoomDirection::EAST && Dir2 == ERoomDirection::WEST) ||
-    (Dir1 == ERoomDirection::WEST && Dir2 == ERoomDirection::EAST);
+  // The listen server's own player never needs a layout sent
+  if (!Player || Player->IsLocalController() || Player->FindComponentByClass<UDungeonLayoutSyncComponent>()) return;
+
+  UDungeonLayoutSyncComponent* Channel = NewObject<UDungeonLayoutSyncComponent>(Player);
+  Channel->RegisterComponent();
 }
 
-FVector ADungeonGenerator::GetRotationOffset(float YawRotation)
+bool ADungeonGenerator::IsSpawnedLocally(TSubclassOf<AActor> Class) const
 {
-  // Pivot is at northwest corner, so we need to offset based on rotation
-  // 0 (North): No offset needed
-  // 90 (East): Offset by +X (CellSize)
-  // 180 (South): Offset by +X and +Y (CellSize, CellSize)
-  // 270 (West): Offset by +Y (CellSize)
+  // Replicated classes come from the server; spawning them here too would double them
+  return HasAuthority() || !Class->GetDefaultObject<AActor>()->GetIsReplicated();
+}
 
-  if (FMath::IsNearlyEqual(YawRotation, 0.0f, 0.1f))
+FDungeonLayoutParams ADungeonGenerator::MakeLayoutParams(int32 ForFloor, int32 ForCellCount, int32 ForEnemyCount) const
+{
+  FDungeonLayoutParams Params;
+  Params.Seed = FDungeonLayoutGenerator::MixSeed(Seed, (uint32)ForFloor);
+  Params.CellCount = ForCellCount;
+  Params.EnemyCount = ForEnemyCount;
+  Params.LoopFraction = LoopFraction;
+  Params.LockedAreaSizePercent = LockedAreaSizePercent;
+  Params.Engine = LayoutEngine == ERoomLayoutEngine::WaveFunctionCollapse ? EDungeonLayoutEngine::WaveFunctionCollapse : EDungeonLayoutEngine::Growth;
+  return Params;
+}
+
+int32 ADungeonGenerator::GetFloorSeed() const
+{
+  return MakeLayoutParams(Floor, CellCount, EnemyCount).Seed;
+}
+
+void ADungeonGenerator::BuildSpawnQueue()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonBuildSpawnQueue);
+  const FDungeonGrid& Grid = Layout.GetGrid();
+  SpawnQueue.Reset();
+  SpawnQueueHead = 0;
+  if (Layout.IsEmpty()) return;
+
+  // Rooms go out in door order from the safe room, where the player arrives. The
+  // locked door counts as open here so the locked area is ordered too.
+  TArray<int32> Order;
+  Order.Reserve(Grid.NumCells());
+  TArray<bool> Visited;
+  Visited.Init(false, Grid.NumIndices());
+
+  if (Grid.IsOccupied(Layout.GetSafeRoom()))
   {
-    return FVector(0, 0, 0);  // 0 - No offset
+    const int32 Start = Grid.ToIndex(Layout.GetSafeRoom());
+    Visited[Start] = true;
+    Order.Add(Start);
   }
-  else if (FMath::IsNearlyEqual(YawRotation, 90.0f, 0.1f))
+
+  for (int32 Head = 0; Head < Order.Num(); Head++)
   {
-    return FVector(CellSize, 0, 0);  // 90 - Offset X
+    const uint8 Doors = Grid.GetDoors(Order[Head]);
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      const int32 Neighbor = Grid.Neighbour(Order[Head], Dir);
+      if ((Doors & DungeonDoor::FromIndex(Dir)) && !Visited[Neighbor])
+      {
+        Visited[Neighbor] = true;
+        Order.Add(Neighbor);
+      }
+    }
   }
-  else if (FMath::IsNearlyEqual(YawRotation, 180.0f, 0.1f))
+
+  INC_DWORD_STAT_BY(STAT_DungeonBFSVisits, Order.Num());
+
+  // Rooms the doors don't reach still get spawned, last
+  for (const FIntPoint& Cell : Grid.GetCells())
   {
-    return FVector(CellSize, CellSize, 0);  // 180 - Offset X and Y
+    const int32 Index = Grid.ToIndex(Cell);
+    if (!Visited[Index])
+    {
+      Visited[Index] = true;
+      Order.Add(Index);
+    }
   }
-  else if (FMath::IsNearlyEqual(YawRotation, 270.0f, 0.1f))
+
+  EnemyAtIndex.Init(false, Grid.NumIndices());
+  if (EnemyPrefabClass && IsSpawnedLocally(EnemyPrefabClass))
   {
-    return FVector(0, CellSize, 0);  // 270 - Offset Y
+    for (const FIntPoint& Slot : Layout.GetEnemySlots())
+    {
+      EnemyAtIndex[Grid.ToIndex(Slot)] = true;
+    }
   }
+  bLockedDoorQueued = false;
+  bLockedDoorHalfQueued = false;
 
-  return FVector::ZeroVector;
+  SpawnQueue.Reserve(Order.Num() + Layout.GetEnemySlots().Num() + 1);
+  for (int32 Index : Order)
+  {
+    if (RoomStreamer.IsResident(Index))
+    {
+      QueueRoom(Index);
+    }
+  }
 }
 
-void ADungeonGenerator::ClearDungeon()
+void ADungeonGenerator::QueueRoom(int32 Index)
 {
-  for (AActor* Room : ActiveDungeonRooms)
+  const FDungeonGrid& Grid = Layout.GetGrid();
+  SpawnQueue.Add({ ESpawnStep::Room, Grid.ToCell(Index) });
+
+  // Objects follow the room they stand in
+  if (EnemyAtIndex[Index] && !SlotEnemies.Contains(Index))
+  {
+    SpawnQueue.Add({ ESpawnStep::Enemy, Grid.ToCell(Index) });
+  }
+
+  // The locked door follows the later of its two rooms, or the first when streaming
+  // since the other side may never load. Once spawned it stays for the whole floor.
+  if (LockedDoorPrefabClass && IsSpawnedLocally(LockedDoorPrefabClass) && Layout.HasLockedDoor() && !bLockedDoorQueued &&
+    (Index == Grid.ToIndex(Layout.GetLockedDoorRoom()) || Index == Grid.ToIndex(Layout.GetLockedDoorNeighbour())))
   {
-    if (Room && IsValid(Room))
+    if (bLockedDoorHalfQueued || bStreamRooms)
     {
-      Room->Destroy();
+      SpawnQueue.Add({ ESpawnStep::LockedDoor, Grid.ToCell(Index) });
+      bLockedDoorQueued = true;
     }
+    bLockedDoorHalfQueued = true;
   }
-  ActiveDungeonRooms.Empty();
+}
 
-  for (AActor* Obj : SpawnedObjects)
+void ADungeonGenerator::ProcessSpawnQueue()
+{
+  LLM_SCOPE_BYTAG(Dungeon);
+  SCOPE_CYCLE_COUNTER(STAT_DungeonSpawnSlice);
+  const double StartTime = FPlatformTime::Seconds();
+
+  // Always spawn at least one step so a single slow actor can't stall the floor
+  for (int32 Spawned = 0; SpawnQueueHead < SpawnQueue.Num(); Spawned++)
   {
-    if (Obj && IsValid(Obj))
+    if (Spawned > 0 && SpawnBudgetMs > 0.0f && (FPlatformTime::Seconds() - StartTime) * 1000.0 >= SpawnBudgetMs)
     {
-      Obj->Destroy();
+      break;
+    }
+
+    const FSpawnStep Step = SpawnQueue[SpawnQueueHead++];
+    const int32 Index = Layout.GetGrid().ToIndex(Step.GridPos);
+
+    // A streamed chunk may have been dropped again before its steps came up
+    if (Step.Type != ESpawnStep::LockedDoor && !RoomStreamer.IsResident(Index)) continue;
+
+    switch (Step.Type)
+    {
+    case ESpawnStep::Room:
+      SpawnQueuedRoom(Step.GridPos);
+      break;
+    case ESpawnStep::LockedDoor:
+      SpawnLockedDoor();
+      break;
+    case ESpawnStep::Enemy:
+      if (!SlotEnemies.Contains(Index))
+      {
+        SlotEnemies.Add(Index, SpawnEnemy(Step.GridPos));
+      }
+      break;
     }
   }
-  SpawnedObjects.Empty();
 
-  OccupiedCells.Empty();
-  AvailablePositions.Empty();
-  RoomMap.Empty();
-  ConnectedDoors.Empty();
-  LockedArea.Empty();
-  AccessibleArea.Empty();
+  RoomInstancer.Flush();
+
+  OnSpawnProgress.Broadcast(GetSpawnProgress());
+
+  if (IsSpawningDungeon())
+  {
+    SetActorTickEnabled(true);
+    return;
+  }
+
+  SpawnQueue.Reset();
+  SpawnQueueHead = 0;
+
+  // Keeps ticking until the navmesh has caught up
+  if (bFloorSpawned)
+  {
+    RebuildNavigation();
+    return;
+  }
+
+  bFloorSpawned = true;
+  NavStartTime = FPlatformTime::Seconds();
+  SpawnSeconds = NavStartTime - SpawnStartTime;
+  RebuildNavigation();
+  StartPrefetch();
+  OnDungeonReady.Broadcast();
 }
 
-void ADungeonGenerator::CreateLockedArea()
+void ADungeonGenerator::UpdateStreaming()
 {
-  if (OccupiedCells.Num() < 5) return;
+  LLM_SCOPE_BYTAG(Dungeon);
+  SCOPE_CYCLE_COUNTER(STAT_DungeonUpdateStreaming);
+  if (Layout.IsEmpty() || !RoomStreamer.IsActive()) return;
+  const FDungeonGrid& Grid = Layout.GetGrid();
 
-  FIntPoint FarthestRoom(0, 0);
-  int32 MaxDistance = 0;
-  for (const FIntPoint& Pos : OccupiedCells)
+  TArray<FIntPoint, TInlineAllocator<8>> PlayerCells;
+  for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
   {
-    int32 Distance = FMath::Abs(Pos.X - SafeRoomGridPos.X) + FMath::Abs(Pos.Y - SafeRoomGridPos.Y);
-    if (Distance > MaxDistance)
+    const APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr;
+    if (Pawn)
     {
-      MaxDistance = Distance;
-      FarthestRoom = Pos;
+      PlayerCells.Add(GetCellAt(Pawn->GetActorLocation()));
     }
   }
 
-  int32 TargetLockedRooms = FMath::Max(2, FMath::CeilToInt(OccupiedCells.Num() * LockedAreaSizePercent));
+  TArray<int32> Loaded, Unloaded;
+  if (!RoomStreamer.Update(Grid, PlayerCells, StreamLoadHops, GetStreamUnloadHops(), Loaded, Unloaded)) return;
+  if (Loaded.Num() == 0 && Unloaded.Num() == 0) return;
 
-  TArray<FIntPoint> Queue;
-  LockedArea.Add(FarthestRoom);
-  Queue.Add(FarthestRoom);
+  for (int32 Chunk : Unloaded)
+  {
+    for (int32 Index : RoomStreamer.GetChunkCells(Chunk))
+    {
+      AActor* KeptRoom = nullptr;
+      if (AActor* Room = RoomActors[Index])
+      {
+        ActiveDungeonRooms.RemoveSwap(Room, EAllowShrinking::No);
+        ReleaseRoomActor(Room);
+        RoomActors[Index] = nullptr;
+      }
+      else if (KeptRooms.RemoveAndCopyValue(Grid.ToCell(Index), KeptRoom))
+      {
+        ReleaseRoomActor(KeptRoom);
+      }
+      AddNavDirtyCell(Grid.ToCell(Index));
+    }
+  }
 
-  for (int32 i = 0; i < Queue.Num() && LockedArea.Num() < TargetLockedRooms; i++)
+  // Enemies left standing on dropped chunks are destroyed. Their slot spawns a fresh
+  // enemy when the chunk comes back, so damage and AI state do not survive the trip.
+  for (auto It = SlotEnemies.CreateIterator(); It; ++It)
   {
-    TArray<FIntPoint> Neighbors = {
-        FIntPoint(Queue[i].X, Queue[i].Y + 1), FIntPoint(Queue[i].X + 1, Queue[i].Y),
-        FIntPoint(Queue[i].X, Queue[i].Y - 1), FIntPoint(Queue[i].X - 1, Queue[i].Y)
-    };
+    AActor* Enemy = It.Value().Get();
+    if (!Enemy) continue;
+
+    const FIntPoint Cell = GetCellAt(Enemy->GetActorLocation());
+    if (Grid.IsInside(Cell) && RoomStreamer.IsResident(Grid.ToIndex(Cell))) continue;
 
-    // Shuffle neighbors for randomness
-    for (int32 j = Neighbors.Num() - 1; j > 0; j--)
-      Neighbors.Swap(j, FMath::RandRange(0, j));
+    SpawnedObjects.RemoveSwap(Enemy, EAllowShrinking::No);
+    Enemy->Destroy();
+    INC_DWORD_STAT(STAT_DungeonActorsDestroyed);
+    It.RemoveCurrent();
+  }
 
-    for (const FIntPoint& Neighbor : Neighbors)
+  for (int32 Chunk : Loaded)
+  {
+    for (int32 Index : RoomStreamer.GetChunkCells(Chunk))
     {
-      if (LockedArea.Num() >= TargetLockedRooms) break;
+      QueueRoom(Index);
+      AddNavDirtyCell(Grid.ToCell(Index));
+    }
+  }
 
-      if (OccupiedCells.Contains(Neighbor) && !LockedArea.Contains(Neighbor))
-      {
-        // TEST: temporarily add to locked area
-        LockedArea.Add(Neighbor);
+  // The navmesh follows once the new rooms are in
+  if (IsSpawningDungeon())
+  {
+    SetActorTickEnabled(true);
+  }
+  else
+  {
+    RebuildNavigation();
+  }
+}
 
-        // Verify all unlocked rooms can reach origin without crossing locked boundaries
-        TSet<FIntPoint> Reachable;
-        TArray<FIntPoint> BFS;
-        BFS.Add(FIntPoint(0, 0));
-        Reachable.Add(FIntPoint(0, 0));
+FIntPoint ADungeonGenerator::GetCellAt(const FVector& Location) const
+{
+  return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
 
-        for (int32 k = 0; k < BFS.Num(); k++)
-        {
-          TArray<FIntPoint> BFSNeighbors = {
-              FIntPoint(BFS[k].X, BFS[k].Y + 1), FIntPoint(BFS[k].X + 1, BFS[k].Y),
-              FIntPoint(BFS[k].X, BFS[k].Y - 1), FIntPoint(BFS[k].X - 1, BFS[k].Y)
-          };
+void ADungeonGenerator::Tick(float DeltaSeconds)
+{
+  Super::Tick(DeltaSeconds);
 
-          for (const FIntPoint& BN : BFSNeighbors)
-          {
-            if (OccupiedCells.Contains(BN) && !Reachable.Contains(BN))
-            {
-              FString Key = GetConnectionKey(BFS[k], BN);
-              // Can only traverse if connection exists AND neither room is locked
-              if (ConnectedDoors.Contains(Key) && !LockedArea.Contains(BFS[k]) && !LockedArea.Contains(BN))
-              {
-                Reachable.Add(BN);
-                BFS.Add(BN);
-              }
-            }
-          }
-        }
+  if (IsSpawningDungeon())
+  {
+    ProcessSpawnQueue();
+  }
+  else if (bWaitingForNavigation)
+  {
+    CheckNavigationReady();
+  }
+  else
+  {
+    SetActorTickEnabled(false);
+  }
+}
 
-        // Check if all unlocked rooms are reachable
-        bool bAllReachable = true;
-        for (const FIntPoint& Room : OccupiedCells)
-        {
-          if (!LockedArea.Contains(Room) && !Reachable.Contains(Room))
-          {
-            bAllReachable = false;
-            break;
-          }
-        }
+void ADungeonGenerator::CollectKeptRooms(const FDungeonLayout& NewLayout, const TArray<FResolvedRoom>& NewResolvedRooms, TMap<FIntPoint, AActor*>& OutKeptRooms)
+{
+  const FDungeonGrid& OldGrid = Layout.GetGrid();
+  const FDungeonGrid& NewGrid = NewLayout.GetGrid();
+  TSet<AActor*> Kept;
 
-        if (bAllReachable)
-        {
-          // Keep this room in locked area and add to queue for expansion
-          Queue.Add(Neighbor);
-        }
-        else
-        {
-          // Remove it - it would cause isolation
-          LockedArea.Remove(Neighbor);
-        }
+  for (const FIntPoint& Cell : OldGrid.GetCells())
+  {
+    const int32 OldIndex = OldGrid.ToIndex(Cell);
+    AActor* Room = RoomActors.IsValidIndex(OldIndex) ? RoomActors[OldIndex] : nullptr;
+
+    if (IsValid(Room) && NewGrid.IsOccupied(Cell))
+    {
+      const FResolvedRoom& OldRoom = ResolvedRooms[OldIndex];
+      const FResolvedRoom& NewRoom = NewResolvedRooms[NewGrid.ToIndex(Cell)];
+      if (OldRoom.Class == NewRoom.Class && OldRoom.Rotation.Equals(NewRoom.Rotation))
+      {
+        OutKeptRooms.Add(Cell, Room);
+        Kept.Add(Room);
+        continue;
       }
     }
+
+    AddNavDirtyCell(Cell);
+  }
+
+  if (Layout.HasLockedDoor())
+  {
+    AddNavDirtyCell(Layout.GetLockedDoorRoom());
+    AddNavDirtyCell(Layout.GetLockedDoorNeighbour());
+  }
+
+  if (Kept.Num() > 0)
+  {
+    ActiveDungeonRooms.RemoveAll([&Kept](AActor* Room) { return Kept.Contains(Room); });
   }
+}
+
+void ADungeonGenerator::AddNavDirtyCell(FIntPoint GridPos)
+{
+  NavDirtyCells.Add(GridPos);
+}
 
-  RemoveLockedAreaConnections();
-  CreateSingleLockedConnection();
-	PlaceKeyRoom();
+FBox ADungeonGenerator::GetCellNavBounds(FIntPoint GridPos) const
+{
+  // Rooms are assumed to be no taller than they are wide
+  const FVector Min(GridPos.X * CellSize, GridPos.Y * CellSize, -CellSize);
+  const FVector Max((GridPos.X + 1) * CellSize, (GridPos.Y + 1) * CellSize, CellSize);
+  return FBox(Min, Max);
 }
 
-void ADungeonGenerator::RemoveLockedAreaConnections()
+void ADungeonGenerator::ResolveRooms(const FDungeonLayout& ForLayout, TArray<FResolvedRoom>& OutRooms)
 {
-  TArray<FString> ConnectionsToRemove;
+  SCOPE_CYCLE_COUNTER(STAT_DungeonResolveRooms);
+  const FDungeonGrid& Grid = ForLayout.GetGrid();
+
+  // Classes are drawn in layout cell order, so the choice doesn't depend on spawn order
+  const FRandomStream RoomSelectionStream = FDungeonLayoutGenerator::MakeStream(ForLayout.GetSeed(), EDungeonRandomStream::RoomSelection);
+
+  BuildRoomCatalog();
+  FDungeonRoomCatalog::FPickState PickState;
 
-  for (const FIntPoint& LockedRoom : LockedArea)
+  OutRooms.Reset();
+  OutRooms.SetNum(Grid.NumIndices());
+
+  for (const FIntPoint& GridPos : Grid.GetCells())
   {
-    TArray<FIntPoint> Neighbors = {
-        FIntPoint(LockedRoom.X, LockedRoom.Y + 1),
-        FIntPoint(LockedRoom.X + 1, LockedRoom.Y),
-        FIntPoint(LockedRoom.X, LockedRoom.Y - 1),
-        FIntPoint(LockedRoom.X - 1, LockedRoom.Y)
-    };
+    const uint8 Doors = Grid.GetDoors(GridPos);
+    FResolvedRoom& Room = OutRooms[Grid.ToIndex(GridPos)];
 
-    for (const FIntPoint& Neighbor : Neighbors)
+    if (GridPos == ForLayout.GetSafeRoom())
     {
-      if (OccupiedCells.Contains(Neighbor) && !LockedArea.Contains(Neighbor))
-      {
-        FString Key = GetConnectionKey(LockedRoom, Neighbor);
-        ConnectionsToRemove.Add(Key);
-      }
+      Room = ResolveSpecialRoom(SafeRoom, GridPos, Doors);
+    }
+    else if (GridPos == ForLayout.GetEndRoom())
+    {
+      Room = ResolveSpecialRoom(EndRoomClass, GridPos, Doors);
+    }
+    else if (ForLayout.HasKeyRoom() && GridPos == ForLayout.GetKeyRoom() && KeyRoomClass)
+    {
+      Room = ResolveSpecialRoom(KeyRoomClass, GridPos, Doors);
+    }
+    else
+    {
+      Room = ResolveRoom(GridPos, Doors, RoomSelectionStream, PickState);
     }
   }
+}
 
-  for (const FString& Key : ConnectionsToRemove)
+ADungeonGenerator::FResolvedRoom ADungeonGenerator::ResolveSpecialRoom(TSubclassOf<AActor> RoomClass, FIntPoint GridPos, uint8 Doors)
+{
+  FResolvedRoom Room;
+  if (!RoomClass)
   {
-    ConnectedDoors.Remove(Key);
+    UE_LOG(LogTemp, Error, TEXT("No room class provided for position (%d, %d)"), GridPos.X, GridPos.Y);
+    return Room;
   }
+
+  // Special rooms are dead ends; face the doorway at the first open side
+  Room.Class = RoomClass;
+  Room.Rotation = FRotator(0.0f, DungeonRoomShape::QuarterToYaw(DungeonRoomShape::FromDoors(Doors).FacingQuarter), 0.0f);
+  return Room;
 }
 
-void ADungeonGenerator::CreateSingleLockedConnection()
+void ADungeonGenerator::BuildRoomCatalog()
 {
-  struct FConnection
-  {
-    FIntPoint Locked;
-    FIntPoint Unlocked;
-    ERoomDirection Dir;
-  };
+  RoomCatalog.SetVariants(EDungeonRoomShape::DeadEnd, DeadendRooms, RoomWeights);
+  RoomCatalog.SetVariants(EDungeonRoomShape::Straight, StraightRooms, RoomWeights);
+  RoomCatalog.SetVariants(EDungeonRoomShape::Turn, TurnRooms, RoomWeights);
+  RoomCatalog.SetVariants(EDungeonRoomShape::TJunction, TJunctionRooms, RoomWeights);
+  RoomCatalog.SetVariants(EDungeonRoomShape::Crossroad, CrossroadRooms, RoomWeights);
+}
+
+ADungeonGenerator::FResolvedRoom ADungeonGenerator::ResolveRoom(FIntPoint GridPos, uint8 Doors, const FRandomStream& Stream,
+  FDungeonRoomCatalog::FPickState& PickState)
+{
+  const FDungeonRoomShape& Shape = DungeonRoomShape::FromDoors(Doors);
 
-  TArray<FConnection> PossibleConnections;
+  FResolvedRoom Room;
+  Room.Class = RoomCatalog.Pick(Shape.Shape, Stream, bAvoidRepeatedRooms, PickState);
+  Room.Rotation = FRotator(0.0f, DungeonRoomShape::QuarterToYaw(Shape.Quarter), 0.0f);
 
-  for (const FIntPoint& LockedRoom : LockedArea)
+  if (!Room.Class)
   {
-    TArray<FIntPoint> Neighbors = {
-        FIntPoint(LockedRoom.X, LockedRoom.Y + 1),
-        FIntPoint(LockedRoom.X + 1, LockedRoom.Y),
-        FIntPoint(LockedRoom.X, LockedRoom.Y - 1),
-        FIntPoint(LockedRoom.X - 1, LockedRoom.Y)
-    };
+    UE_LOG(LogTemp, Error, TEXT("No room class available for position (%d, %d) with %d connections"),
+      GridPos.X, GridPos.Y, FMath::CountBits(Doors));
+  }
+  return Room;
+}
 
-    TArray<ERoomDirection> Directions = {
-        ERoomDirection::NORTH,
-        ERoomDirection::EAST,
-        ERoomDirection::SOUTH,
-        ERoomDirection::WEST
-    };
+void ADungeonGenerator::SpawnQueuedRoom(FIntPoint GridPos)
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonSpawnRoom);
+  const int32 Index = Layout.GetGrid().ToIndex(GridPos);
+  if (RoomActors[Index]) return;
 
-    for (int32 i = 0; i < Neighbors.Num(); i++)
-    {
-      if (OccupiedCells.Contains(Neighbors[i]) && !LockedArea.Contains(Neighbors[i]))
-      {
-        FConnection Connection;
-        Connection.Locked = LockedRoom;
-        Connection.Unlocked = Neighbors[i];
-        Connection.Dir = Directions[i];
-        PossibleConnections.Add(Connection);
-      }
-    }
+  AActor* KeptRoom = nullptr;
+  if (KeptRooms.RemoveAndCopyValue(GridPos, KeptRoom))
+  {
+    ActiveDungeonRooms.Add(KeptRoom);
+    RoomActors[Index] = KeptRoom;
+    return;
   }
 
-  if (PossibleConnections.Num() > 0)
+  const FResolvedRoom& Room = ResolvedRooms[Index];
+  if (!Room.Class) return;
+
+  // Offset to center the room (pivot is at northwest corner)
+  FVector SpawnLocation(GridPos.X * CellSize + CellSize / 2.0f, GridPos.Y * CellSize + CellSize / 2.0f, 0.0f);
+
+  // Instances can't be taken out one room at a time, so streamed floors use actors
+  if (RoomMaterialisation == ERoomMaterialisation::Instanced && !bStreamRooms &&
+    RoomInstancer.AddRoom(this, Room.Class, FTransform(Room.Rotation, SpawnLocation), SpawnedObjects))
   {
-    FConnection ChosenConnection = PossibleConnections[FMath::RandRange(0, PossibleConnections.Num() - 1)];
-    LockedDoorPos1 = ChosenConnection.Locked;
-    LockedDoorPos2 = ChosenConnection.Unlocked;
-    LockedDoorDirection = ChosenConnection.Dir;
+    return;
+  }
+
+  AActor* RoomInstance = SpawnRoomActor(Room.Class, SpawnLocation, Room.Rotation);
 
-    FString ChosenKey = GetConnectionKey(LockedDoorPos1, LockedDoorPos2);
-    ConnectedDoors.Add(ChosenKey);
+  if (RoomInstance)
+  {
+    ActiveDungeonRooms.Add(RoomInstance);
+    RoomActors[Index] = RoomInstance;
   }
 }
 
-void ADungeonGenerator::PlaceKeyRoom()
+AActor* ADungeonGenerator::SpawnRoomActor(TSubclassOf<AActor> RoomClass, const FVector& Location, const FRotator& Rotation)
 {
-  if (AccessibleArea.Num() == 0)
+  if (bPoolRooms)
   {
-    CalculateAccessibleArea();
+    return RoomPool.Acquire(GetWorld(), RoomClass, Location, Rotation, this);
   }
 
-  // Shuffle accessible rooms for randomness
-  TArray<FIntPoint> ShuffledRooms = AccessibleArea.Array();
-  for (int32 i = ShuffledRooms.Num() - 1; i > 0; i--)
+  FActorSpawnParameters SpawnParams;
+  SpawnParams.Owner = this;
+
+  AActor* Room = GetWorld()->SpawnActor<AActor>(RoomClass, Location, Rotation, SpawnParams);
+  if (Room)
   {
-    ShuffledRooms.Swap(i, FMath::RandRange(0, i));
+    INC_DWORD_STAT(STAT_DungeonActorsSpawned);
   }
+  return Room;
+}
 
-  TArray<FIntPoint> Directions = {
-    FIntPoint(0, 1), FIntPoint(1, 0), FIntPoint(0, -1), FIntPoint(-1, 0)
-  };
+void ADungeonGenerator::ReleaseRoomActor(AActor* Room)
+{
+  if (!IsValid(Room)) return;
 
-  // Try each accessible room until we find an empty adjacent spot
-  for (const FIntPoint& Room : ShuffledRooms)
+  if (bPoolRooms)
   {
-    if (Room == SafeRoomGridPos || Room == EndRoomGridPos) continue;
+    RoomPool.Release(Room);
+  }
+  else
+  {
+    Room->Destroy();
+    INC_DWORD_STAT(STAT_DungeonActorsDestroyed);
+  }
+}
 
-    for (const FIntPoint& Dir : Directions)
-    {
-      FIntPoint Candidate = Room + Dir;
+void ADungeonGenerator::WarmUpRoomPool(int32 CountPerClass)
+{
+  RoomPool.SetMaxPooledPerClass(RoomPoolMaxPerClass);
 
-      if (!OccupiedCells.Contains(Candidate) &&
-        FMath::Abs(Candidate.X - SafeRoomGridPos.X) + FMath::Abs(Candidate.Y - SafeRoomGridPos.Y) > 1 &&
-        FMath::Abs(Candidate.X - EndRoomGridPos.X) + FMath::Abs(Candidate.Y - EndRoomGridPos.Y) > 1)
-      {
-        KeyRoomGridPos = Candidate;
-        OccupiedCells.Add(KeyRoomGridPos);
-        ConnectedDoors.Add(GetConnectionKey(Room, KeyRoomGridPos));
-        return; // Done!
-      }
+  for (const TArray<TSubclassOf<AActor>>* ClassArray : { &DeadendRooms, &StraightRooms, &TurnRooms, &TJunctionRooms, &CrossroadRooms })
+  {
+    for (const TSubclassOf<AActor>& RoomClass : *ClassArray)
+    {
+      RoomPool.WarmUp(GetWorld(), RoomClass, CountPerClass, this);
     }
   }
 }
 
-void ADungeonGenerator::CalculateAccessibleArea()
+FVector ADungeonGenerator::GetRotationOffset(float YawRotation)
 {
-  AccessibleArea.Empty();
-  TQueue<FIntPoint> Queue;
-
-  FIntPoint Start = SafeRoomGridPos;
-  AccessibleArea.Add(Start);
-  Queue.Enqueue(Start);
+  // Pivot is at northwest corner, so we need to offset based on rotation
+  // 0 (North): No offset needed
+  // 90 (East): Offset by +X (CellSize)
+  // 180 (South): Offset by +X and +Y (CellSize, CellSize)
+  // 270 (West): Offset by +Y (CellSize)
 
-  while (!Queue.IsEmpty())
+  if (FMath::IsNearlyEqual(YawRotation, 0.0f, 0.1f))
+  {
+    return FVector(0, 0, 0);  // 0 - No offset
+  }
+  else if (FMath::IsNearlyEqual(YawRotation, 90.0f, 0.1f))
   {
-    FIntPoint Current;
-    Queue.Dequeue(Current);
+    return FVector(CellSize, 0, 0);  // 90 - Offset X
+  }
+  else if (FMath::IsNearlyEqual(YawRotation, 180.0f, 0.1f))
+  {
+    return FVector(CellSize, CellSize, 0);  // 180 - Offset X and Y
+  }
+  else if (FMath::IsNearlyEqual(YawRotation, 270.0f, 0.1f))
+  {
+    return FVector(0, CellSize, 0);  // 270 - Offset Y
+  }
 
-    TArray<FIntPoint> Neighbors = {
-        FIntPoint(Current.X, Current.Y + 1),
-        FIntPoint(Current.X + 1, Current.Y),
-        FIntPoint(Current.X, Current.Y - 1),
-        FIntPoint(Current.X - 1, Current.Y)
-    };
+  return FVector::ZeroVector;
+}
 
-    for (const FIntPoint& Neighbor : Neighbors)
-    {
-      if (OccupiedCells.Contains(Neighbor) && !AccessibleArea.Contains(Neighbor))
-      {
-        FString ConnectionKey = GetConnectionKey(Current, Neighbor);
+void ADungeonGenerator::ClearDungeon()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonClearDungeon);
+  RoomPool.SetMaxPooledPerClass(RoomPoolMaxPerClass);
 
-        if (ConnectionKey == GetConnectionKey(LockedDoorPos1, LockedDoorPos2))
-          continue;
+  // Carried-over rooms that never reached their spawn step go with the rest
+  for (const TPair<FIntPoint, AActor*>& Kept : KeptRooms)
+  {
+    ActiveDungeonRooms.Add(Kept.Value);
+  }
+  KeptRooms.Reset();
 
-        if (ConnectedDoors.Contains(ConnectionKey))
-        {
-          AccessibleArea.Add(Neighbor);
-          Queue.Enqueue(Neighbor);
-        }
-      }
+  for (AActor* Room : ActiveDungeonRooms)
+  {
+    ReleaseRoomActor(Room);
+  }
+  ActiveDungeonRooms.Empty();
+
+  for (AActor* Obj : SpawnedObjects)
+  {
+    if (Obj && IsValid(Obj))
+    {
+      Obj->Destroy();
+      INC_DWORD_STAT(STAT_DungeonActorsDestroyed);
     }
   }
+  SpawnedObjects.Empty();
+
+  RoomInstancer.Clear();
+
+  Layout = FDungeonLayout();
+  ResolvedRooms.Empty();
+  RoomActors.Empty();
+
+  SpawnQueue.Reset();
+  SpawnQueueHead = 0;
+  bWaitingForNavigation = false;
+  GatedEnemyControllers.Reset();
+  SetActorTickEnabled(false);
+
+  GetWorldTimerManager().ClearTimer(StreamTimer);
+  RoomStreamer.Empty();
+  SlotEnemies.Reset();
+  LockedDoorActor.Reset();
+  bLockedDoorOpenApplied = false;
+
+  SET_DWORD_STAT(STAT_DungeonCells, 0);
+  SET_DWORD_STAT(STAT_DungeonDoors, 0);
 }
 
 void ADungeonGenerator::SpawnLockedDoor()
 {
-  if (!LockedDoorPrefabClass || !RoomMap.Contains(LockedDoorPos1)) return;
+  SCOPE_CYCLE_COUNTER(STAT_DungeonSpawnLockedDoor);
+  if (!LockedDoorPrefabClass || !Layout.HasLockedDoor() || !ResolvedRooms[Layout.GetGrid().ToIndex(Layout.GetLockedDoorRoom())].Class) return;
+
+  const FIntPoint LockedDoorPos1 = Layout.GetLockedDoorRoom();
+  const FIntPoint LockedDoorPos2 = Layout.GetLockedDoorNeighbour();
 
   float offset = CellSize / 2;
   FVector LockedRoomWorld(LockedDoorPos1.X * CellSize + offset, LockedDoorPos1.Y * CellSize + offset, 0.0f);
@@ -703,7 +1209,7 @@ void ADungeonGenerator::SpawnLockedDoor()
   FVector DoorPosition = (LockedRoomWorld + UnlockedRoomWorld) / 2.0f;
 
   FRotator DoorRotation(0.0f, 0.0f, 0.0f);
-  switch (LockedDoorDirection)
+  switch ((ERoomDirection)Layout.GetLockedDoorFacing())
   {
   case ERoomDirection::NORTH:
     DoorRotation = FRotator(0, 0, 0);
@@ -722,150 +1228,202 @@ void ADungeonGenerator::SpawnLockedDoor()
   AActor* LockedDoor = GetWorld()->SpawnActor<AActor>(LockedDoorPrefabClass, DoorPosition, DoorRotation);
   if (LockedDoor)
   {
+    INC_DWORD_STAT(STAT_DungeonActorsSpawned);
     SpawnedObjects.Add(LockedDoor);
+    LockedDoorActor = LockedDoor;
+
+    // The door may have been opened before it got here
+    ApplyFloorDelta();
   }
 }
 
-void ADungeonGenerator::SpawnObjectsInFarRooms()
+AActor* ADungeonGenerator::SpawnEnemy(FIntPoint GridPos)
 {
-  if (OccupiedCells.Num() == 0) return;
-
-  TArray<FIntPoint> RoomsByDistance = OccupiedCells.Array();
-  RoomsByDistance.Sort([this](const FIntPoint& A, const FIntPoint& B) {
-    int32 DistA = FMath::Abs(A.X - SafeRoomGridPos.X) + FMath::Abs(A.Y - SafeRoomGridPos.Y);
-    int32 DistB = FMath::Abs(B.X - SafeRoomGridPos.X) + FMath::Abs(B.Y - SafeRoomGridPos.Y);
-    return DistA > DistB;
-    });
-
-  int32 FarRoomCount = FMath::Max(1, FMath::CeilToInt(RoomsByDistance.Num() * 0.3f));
-  TArray<FIntPoint> FarRooms;
-  for (int32 i = 0; i < FarRoomCount && i < RoomsByDistance.Num(); i++)
+  SCOPE_CYCLE_COUNTER(STAT_DungeonSpawnEnemy);
+  float offset = CellSize / 2;
+  FVector WorldPos(GridPos.X * CellSize + offset, GridPos.Y * CellSize + offset, 0.0f);
+  AActor* Enemy = GetWorld()->SpawnActor<AActor>(EnemyPrefabClass, WorldPos, FRotator::ZeroRotator);
+  if (Enemy)
   {
-    FarRooms.Add(RoomsByDistance[i]);
+    INC_DWORD_STAT(STAT_DungeonActorsSpawned);
+    SpawnedObjects.Add(Enemy);
+
+    // Hold the AI until the navmesh under the new floor exists
+    APawn* EnemyPawn = Cast<APawn>(Enemy);
+    AAIController* Controller = EnemyPawn ? Cast<AAIController>(EnemyPawn->GetController()) : nullptr;
+    if (!bNavigationReady && Controller && Controller->GetBrainComponent())
+    {
+      Controller->GetBrainComponent()->PauseLogic(TEXT("Waiting for dungeon navmesh"));
+      GatedEnemyControllers.Add(Controller);
+    }
   }
+  return Enemy;
+}
 
-  if (EnemyPrefabClass)
+void ADungeonGenerator::RebuildNavigation()
+{
+  SCOPE_CYCLE_COUNTER(STAT_DungeonRebuildNavigation);
+  // Only tiles under cells that changed are marked dirty; the navmesh rebuilds them
+  // in the background and keeps the rest. Requires runtime generation set to Dynamic.
+  UNavigationSystemV1* NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+  if (NavSys && NavDirtyCells.Num() > 0)
   {
-    for (int32 i = 0; i < EnemyCount && i < RoomsByDistance.Num(); i++)
+    ARecastNavMesh* NavMesh = Cast<ARecastNavMesh>(NavSys->GetDefaultNavDataInstance());
+    if (!NavTileLibrary || !NavTileLibrary->IsCompatible(NavMesh, CellSize))
     {
-      float offset = CellSize / 2;
-      FVector WorldPos(RoomsByDistance[i].X * CellSize + offset, RoomsByDistance[i].Y * CellSize + offset, 0.0f);
-      AActor* Enemy = GetWorld()->SpawnActor<AActor>(EnemyPrefabClass, WorldPos, FRotator::ZeroRotator);
-      if (Enemy)
+      NavMesh = nullptr;
+    }
+
+    // Stitched cells only need their polygons rebuilt from the layers we supplied,
+    // which is what a modifier-only dirty area does. The rest is voxelised again.
+    TArray<FBox> StitchedAreas;
+    TArray<FBox> RebuildAreas;
+    for (const FIntPoint& Cell : NavDirtyCells)
+    {
+      if (NavMesh && StitchNavCell(NavMesh, Cell))
       {
-        SpawnedObjects.Add(Enemy);
+        StitchedAreas.Add(GetCellNavBounds(Cell));
       }
+      else
+      {
+        RebuildAreas.Add(GetCellNavBounds(Cell));
+      }
+    }
+
+    if (StitchedAreas.Num() > 0)
+    {
+      NavSys->AddDirtyAreas(StitchedAreas, ENavigationDirtyFlag::DynamicModifier);
+    }
+    if (RebuildAreas.Num() > 0)
+    {
+      NavSys->AddDirtyAreas(RebuildAreas, ENavigationDirtyFlag::All);
     }
   }
+  NavDirtyCells.Reset();
+
+  bWaitingForNavigation = true;
+  SetActorTickEnabled(true);
 }
 
-void ADungeonGenerator::CreateMinimalConnections()
+bool ADungeonGenerator::StitchNavCell(ARecastNavMesh* NavMesh, FIntPoint GridPos)
 {
-  TSet<FIntPoint> Visited;
-  TQueue<FIntPoint> Queue;
+  SCOPE_CYCLE_COUNTER(STAT_DungeonStitchNavCell);
+  const FDungeonGrid& Grid = Layout.GetGrid();
+  if (!Grid.IsOccupied(GridPos) || !RoomStreamer.IsResident(Grid.ToIndex(GridPos)))
+  {
+    // Vacated by the previous floor or a dropped chunk
+    NavTileLibrary->ClearCell(NavMesh, GridPos);
+    return true;
+  }
 
-  FIntPoint Start(0, 0);
-  Visited.Add(Start);
-  Queue.Enqueue(Start);
+  const FResolvedRoom& Room = ResolvedRooms[Grid.ToIndex(GridPos)];
+  const FDungeonNavTileEntry* Entry = Room.Class ? NavTileLibrary->FindEntry(Room.Class, Room.Rotation.Yaw) : nullptr;
+  return Entry && NavTileLibrary->Stitch(NavMesh, *Entry, GridPos);
+}
 
-  while (!Queue.IsEmpty())
+#if WITH_EDITOR
+void ADungeonGenerator::BakeRoomNavTiles()
+{
+  UWorld* World = GetWorld();
+  UNavigationSystemV1* NavSys = UNavigationSystemV1::GetCurrent(World);
+  ARecastNavMesh* NavMesh = NavSys ? Cast<ARecastNavMesh>(NavSys->GetDefaultNavDataInstance()) : nullptr;
+  if (!NavTileLibrary || !NavMesh)
   {
-    FIntPoint Current;
-    Queue.Dequeue(Current);
+    UE_LOG(LogTemp, Error, TEXT("Baking room nav tiles needs a NavTileLibrary and a Recast navmesh in the level"));
+    return;
+  }
 
-    TArray<FIntPoint> Neighbors = {
-        FIntPoint(Current.X, Current.Y + 1),
-        FIntPoint(Current.X + 1, Current.Y),
-        FIntPoint(Current.X, Current.Y - 1),
-        FIntPoint(Current.X - 1, Current.Y)
-    };
+  const float TileSize = NavMesh->GetTileSizeUU();
+  if (FMath::Fmod(CellSize, TileSize) > KINDA_SMALL_NUMBER)
+  {
+    UE_LOG(LogTemp, Error, TEXT("CellSize %.0f is not a multiple of the navmesh tile size %.0f"), CellSize, TileSize);
+    return;
+  }
+
+  NavTileLibrary->Reset(CellSize, TileSize);
 
-    for (const FIntPoint& Neighbor : Neighbors)
+  const FIntPoint BakeCell(0, 0);
+  const float offset = CellSize / 2;
+  TArray<AActor*> Fillers;
+  if (NavBakeFillerClass)
+  {
+    for (const FIntPoint& Dir : DungeonDoor::Offsets)
     {
-      if (OccupiedCells.Contains(Neighbor) && !Visited.Contains(Neighbor))
-      {
-        Visited.Add(Neighbor);
-        Queue.Enqueue(Neighbor);
+      const FIntPoint Neighbor = BakeCell + Dir;
+      FVector FillerLocation(Neighbor.X * CellSize + offset, Neighbor.Y * CellSize + offset, 0.0f);
+      Fillers.Add(World->SpawnActor<AActor>(NavBakeFillerClass, FillerLocation, FRotator::ZeroRotator));
+    }
+  }
 
-        FString ConnectionKey = GetConnectionKey(Current, Neighbor);
-        ConnectedDoors.Add(ConnectionKey);
-      }
+  TArray<TSubclassOf<AActor>> RoomClasses;
+  for (const TArray<TSubclassOf<AActor>>* ClassArray : { &DeadendRooms, &StraightRooms, &TurnRooms, &TJunctionRooms, &CrossroadRooms })
+  {
+    for (const TSubclassOf<AActor>& RoomClass : *ClassArray)
+    {
+      RoomClasses.AddUnique(RoomClass);
     }
   }
-}
+  RoomClasses.AddUnique(SafeRoom);
+  RoomClasses.AddUnique(EndRoomClass);
+  RoomClasses.AddUnique(KeyRoomClass);
 
-void ADungeonGenerator::AddExtraDoors()
-{
-  for (const FIntPoint& Pos : OccupiedCells)
+  int32 Baked = 0;
+  for (const TSubclassOf<AActor>& RoomClass : RoomClasses)
   {
-    TArray<FIntPoint> Neighbors = {
-        FIntPoint(Pos.X, Pos.Y + 1),
-        FIntPoint(Pos.X + 1, Pos.Y),
-        FIntPoint(Pos.X, Pos.Y - 1),
-        FIntPoint(Pos.X - 1, Pos.Y)
-    };
+    if (!RoomClass) continue;
 
-    for (const FIntPoint& Neighbor : Neighbors)
+    for (int32 Quadrant = 0; Quadrant < 4; Quadrant++)
     {
-      if (OccupiedCells.Contains(Neighbor))
-      {
-        FString ConnectionKey = GetConnectionKey(Pos, Neighbor);
+      FVector RoomLocation(BakeCell.X * CellSize + offset, BakeCell.Y * CellSize + offset, 0.0f);
+      AActor* Room = World->SpawnActor<AActor>(RoomClass, RoomLocation, FRotator(0.0f, Quadrant * 90.0f, 0.0f));
+      if (!Room) continue;
 
-        bool bIsLockedBoundary = (LockedArea.Contains(Pos) && !LockedArea.Contains(Neighbor)) ||
-          (!LockedArea.Contains(Pos) && LockedArea.Contains(Neighbor));
+      NavSys->Build();
+      Baked += NavTileLibrary->Capture(NavMesh, RoomClass, Quadrant, BakeCell) ? 1 : 0;
+      Room->Destroy();
+    }
+  }
 
-        if (!bIsLockedBoundary && !ConnectedDoors.Contains(ConnectionKey) && FMath::FRand() < ExtraDoorChance)
-        {
-          ConnectedDoors.Add(ConnectionKey);
-        }
-      }
+  for (AActor* Filler : Fillers)
+  {
+    if (Filler)
+    {
+      Filler->Destroy();
     }
   }
+  NavSys->Build();
+
+  NavTileLibrary->MarkPackageDirty();
+  UE_LOG(LogTemp, Log, TEXT("Baked %d room nav tile entries into %s"), Baked, *NavTileLibrary->GetName());
 }
+#endif
 
-FString ADungeonGenerator::GetConnectionKey(FIntPoint Pos1, FIntPoint Pos2) const
+void ADungeonGenerator::CheckNavigationReady()
 {
-  if (Pos1.X < Pos2.X || (Pos1.X == Pos2.X && Pos1.Y < Pos2.Y))
-  {
-    return FString::Printf(TEXT("%d,%d-%d,%d"), Pos1.X, Pos1.Y, Pos2.X, Pos2.Y);
-  }
-  else
+  UNavigationSystemV1* NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
+  if (NavSys && (NavSys->HasDirtyAreasQueued() || NavSys->IsNavigationBuildInProgress()))
   {
-    return FString::Printf(TEXT("%d,%d-%d,%d"), Pos2.X, Pos2.Y, Pos1.X, Pos1.Y);
+    return;
   }
-}
 
-bool ADungeonGenerator::HasDoorConnection(FIntPoint Pos1, FIntPoint Pos2) const
-{
-  FString ConnectionKey = GetConnectionKey(Pos1, Pos2);
-  return ConnectedDoors.Contains(ConnectionKey);
-}
+  bWaitingForNavigation = false;
+  SetActorTickEnabled(false);
 
-void ADungeonGenerator::AddAdjacentPositions(FIntPoint Pos)
-{
-  TArray<FIntPoint> Directions = {
-      FIntPoint(0, 1),
-      FIntPoint(0, -1),
-      FIntPoint(-1, 0),
-      FIntPoint(1, 0)
-  };
+  // Streamed chunks rebuild their tiles too; the floor was announced the first time
+  if (bNavigationReady) return;
 
-  for (const FIntPoint& Dir : Directions)
-  {
-    FIntPoint AdjacentPos = Pos + Dir;
+  bNavigationReady = true;
+  UE_LOG(LogTemp, Log, TEXT("Floor %d spawned in %.1f ms, navigation ready %.1f ms later"),
+    Floor, SpawnSeconds * 1000.0, (FPlatformTime::Seconds() - NavStartTime) * 1000.0);
 
-    if (AdjacentPos.Y >= 0 && !OccupiedCells.Contains(AdjacentPos) && !AvailablePositions.Contains(AdjacentPos))
+  for (const TWeakObjectPtr<AAIController>& Controller : GatedEnemyControllers)
+  {
+    if (Controller.IsValid() && Controller->GetBrainComponent())
     {
-      AvailablePositions.Add(AdjacentPos);
+      Controller->GetBrainComponent()->ResumeLogic(TEXT("Dungeon navmesh ready"));
     }
   }
-}
+  GatedEnemyControllers.Reset();
 
-void ADungeonGenerator::RebuildNavigation()
-{
-  UNavigationSystemV1* NavSys = UNavigationSystemV1::GetCurrent(GetWorld());
-  if (NavSys)
-  {
-    NavSys->Build();
-  }
+  OnNavigationReady.Broadcast();
 }
\ No newline at end of file
@@ -3,6 +3,13 @@
 #include "GameFramework/Actor.h"
 #include "NavigationSystem.h"
 #include "NavMesh/NavMeshBoundsVolume.h"
+#include "DungeonLayout.h"
+#include "DungeonLayoutCache.h"
+#include "DungeonRoomPool.h"
+#include "DungeonRoomInstancer.h"
+#include "DungeonNavTileLibrary.h"
+#include "DungeonRoomStreamer.h"
+#include "DungeonRoomCatalog.h"
 #include "DungeonGenerator.generated.h"
 
 UENUM(BlueprintType)
@@ -14,6 +21,103 @@ enum class ERoomDirection : uint8
   WEST UMETA(DisplayName = "West")
 };
 
+UENUM(BlueprintType)
+enum class ERoomMaterialisation : uint8
+{
+  // Every room is its own actor
+  Actors UMETA(DisplayName = "Actors"),
+  // Room meshes become floor-wide instanced meshes; only interactive parts are actors
+  Instanced UMETA(DisplayName = "Instanced")
+};
+
+UENUM(BlueprintType)
+enum class ERoomLayoutEngine : uint8
+{
+  // Rooms grow one at a time from the start, joined by a random spanning tree
+  Growth UMETA(DisplayName = "Frontier Growth"),
+  // Rooms and doors collapse together under adjacency rules (no two crossroads touch,
+  // straight corridors run on to a junction). Room counts land near CellCount.
+  WaveFunctionCollapse UMETA(DisplayName = "Wave Function Collapse")
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDungeonReady);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDungeonSpawnProgress, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDungeonLockedDoorOpened, AActor*, LockedDoor);
+
+class UDungeonLayoutSyncComponent;
+
+// Everything a client needs to build the current floor itself, replicated in place
+// of the room actors. The client checks its result against Checksum and asks for
+// the full layout through UDungeonLayoutSyncComponent if they differ.
+USTRUCT()
+struct FDungeonFloorNetState
+{
+  GENERATED_BODY()
+
+  // Bumped for every floor the server applies, so a floor built again from the same
+  // params still replicates
+  UPROPERTY()
+  uint16 Revision = 0;
+
+  // Run seed; the floor seed is derived from it as on the server
+  UPROPERTY()
+  int32 Seed = 0;
+
+  UPROPERTY()
+  int32 Floor = 0;
+
+  UPROPERTY()
+  int32 CellCount = 0;
+
+  UPROPERTY()
+  int32 EnemyCount = 0;
+
+  UPROPERTY()
+  float LoopFraction = 0.0f;
+
+  UPROPERTY()
+  float LockedAreaSizePercent = 0.0f;
+
+  UPROPERTY()
+  bool bBossFloor = false;
+
+  UPROPERTY()
+  ERoomLayoutEngine LayoutEngine = ERoomLayoutEngine::Growth;
+
+  // FDungeonLayoutFormat::Checksum of the server's layout
+  UPROPERTY()
+  uint32 Checksum = 0;
+
+  bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FDungeonFloorNetState> : public TStructOpsTypeTraitsBase2<FDungeonFloorNetState>
+{
+  enum
+  {
+    WithNetSerializer = true
+  };
+};
+
+// Runtime changes to the current floor since it was built
+USTRUCT()
+struct FDungeonFloorNetDelta
+{
+  GENERATED_BODY()
+
+  // FDungeonFloorNetState::Revision of the floor these changes belong to
+  UPROPERTY()
+  uint16 Revision = 0;
+
+  UPROPERTY()
+  bool bLockedDoorOpen = false;
+
+  // One bit per entry of the layout's enemy slots
+  UPROPERTY()
+  TArray<uint8> KilledEnemies;
+};
+
 UCLASS()
 class HORRORCITY_API ADungeonGenerator : public AActor
 {
@@ -38,6 +142,16 @@ public:
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Room Types")
   TArray<TSubclassOf<AActor>> CrossroadRooms;
 
+  // Relative chance of a room class against the others of its type; classes not
+  // listed weigh 1 and a weight of 0 takes a class out
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Room Types")
+  TMap<TSubclassOf<AActor>, float> RoomWeights;
+
+  // Never give two rooms of a type the same class one after the other in layout
+  // order, as long as the type has another class to use
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Room Types")
+  bool bAvoidRepeatedRooms = true;
+
   UPROPERTY(EditAnywhere, Category = "Dungeon Generation")
   TSubclassOf<AActor> SafeRoom;
 
@@ -56,7 +170,7 @@ public:
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation")
   int32 Floor = 1;
 
-  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation", meta = (ClampMin = "5", ClampMax = "100"))
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation", meta = (ClampMin = "5", ClampMax = "100000", UIMax = "100"))
   int32 CellCount = 15;
 
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation")
@@ -65,8 +179,18 @@ public:
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation", meta = (ClampMin = "0.0", ClampMax = "1.0"))
   float EnemiesPerRoom = 0.3f;
 
+  // Fraction of the doors that could close a loop that a floor gets, shortcuts saving
+  // the longest walk first: 0 leaves a tree of rooms, 1 joins every adjacent pair.
+  // Replaces ExtraDoorChance, a chance per adjacent pair; old values carry over as is.
+  // ExtraDoorChance was rolled from both rooms of a pair, so 0.3 used to give loops on
+  // about half the candidates. Levels saved with it have about 40% fewer loops now;
+  // retune them (0.5 matches the old 0.3).
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation", meta = (ClampMin = "0.0", ClampMax = "1.0"))
-  float ExtraDoorChance = 0.3f;
+  float LoopFraction = 0.3f;
+
+  // Migrated to LoopFraction in PostLoad. Negative once migrated or never set.
+  UPROPERTY(meta = (DeprecatedProperty, DeprecationMessage = "Use LoopFraction, a fraction of the loop-closing doors rather than a chance per adjacent pair."))
+  float ExtraDoorChance_DEPRECATED = -1.0f;
 
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation")
   TSubclassOf<AActor> EnemyPrefabClass;
@@ -77,13 +201,127 @@ public:
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation")
   int32 EnemyCount = 3;
 
+  // Share of the rooms behind the locked door. Grown floors reach it to within a room
+  // or two; collapsed floors lock beyond the door that comes closest.
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation", meta = (ClampMin = "0.2", ClampMax = "0.5"))
   float LockedAreaSizePercent = 0.3f;
 
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation")
+  ERoomLayoutEngine LayoutEngine = ERoomLayoutEngine::Growth;
+
+  // Time spent spawning rooms and objects per frame. 0 spawns the whole floor at once.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Spawning", meta = (ClampMin = "0.0", Units = "ms"))
+  float SpawnBudgetMs = 4.0f;
+
+  // Instanced mode needs rooms built from static meshes and child actors only; other
+  // room classes (or ones tagged DungeonNoInstancing) are still spawned as actors.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Spawning")
+  ERoomMaterialisation RoomMaterialisation = ERoomMaterialisation::Actors;
+
+  // Prebaked navmesh layers per room class and yaw. Cells whose room is in the library
+  // get stitched tiles instead of a Recast rebuild. The navmesh must keep tile cache
+  // layers (runtime generation Dynamic or DynamicModifiersOnly).
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Navigation")
+  TObjectPtr<UDungeonNavTileLibrary> NavTileLibrary;
+
+  // Placed around the room while baking so doorway floors reach the cell edge
+  UPROPERTY(EditAnywhere, Category = "Dungeon Generation|Navigation")
+  TSubclassOf<AActor> NavBakeFillerClass;
+
+  // Hide and reuse room actors between floors instead of destroying them
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Pooling")
+  bool bPoolRooms = true;
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Pooling", meta = (ClampMin = "0", EditCondition = "bPoolRooms"))
+  int32 RoomPoolMaxPerClass = 32;
+
+  // Idle rooms spawned per room class on BeginPlay
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Pooling", meta = (ClampMin = "0", EditCondition = "bPoolRooms"))
+  int32 RoomPoolWarmUpCount = 0;
+
+  // Materialise only the rooms near players, for floors far larger than can be spawned
+  // at once. Rooms are always actors in this mode.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Streaming")
+  bool bStreamRooms = false;
+
+  // Side of the square blocks of cells that are loaded and dropped together
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Streaming", meta = (ClampMin = "1", EditCondition = "bStreamRooms"))
+  int32 StreamChunkSize = 4;
+
+  // A chunk loads when one of its rooms is this many doors or fewer from a player
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Streaming", meta = (ClampMin = "0", EditCondition = "bStreamRooms"))
+  int32 StreamLoadHops = 3;
+
+  // A chunk unloads once all of its rooms are further than this. Always treated as
+  // at least StreamLoadHops + 1 so chunks on the edge don't flap.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Streaming", meta = (ClampMin = "1", EditCondition = "bStreamRooms"))
+  int32 StreamUnloadHops = 5;
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Streaming", meta = (ClampMin = "0.05", Units = "s", EditCondition = "bStreamRooms"))
+  float StreamUpdateInterval = 0.25f;
+
+  // Keep finished floors on disk under Saved/DungeonFloors and reuse them instead of
+  // generating again. Floors copied to Content/DungeonFloors ship with the game and
+  // are looked up first.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Cache")
+  bool bCacheFloors = false;
+
+  // Run seed. Each floor derives its own layout seed from this and Floor.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Seed", meta = (EditCondition = "!bRandomizeSeed"))
+  int32 Seed = 0;
+
+  // Pick a new run seed on BeginPlay
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation|Seed")
+  bool bRandomizeSeed = true;
+
+  // Build the next floor's layout in the background while this one is played
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Generation")
+  bool bPrefetchNextFloor = true;
+
+  // Fires once every room and object of a floor has spawned. The navmesh may still
+  // be catching up; wait for OnNavigationReady before moving AI.
+  UPROPERTY(BlueprintAssignable, Category = "Dungeon Generation|Spawning")
+  FOnDungeonReady OnDungeonReady;
+
+  // Fires when the navmesh tiles under the new floor have been rebuilt. Enemy AI
+  // spawned before this has its brain paused until then.
+  UPROPERTY(BlueprintAssignable, Category = "Dungeon Generation|Navigation")
+  FOnDungeonReady OnNavigationReady;
+
+  // Fires after each spawn slice with the fraction of the floor spawned so far
+  UPROPERTY(BlueprintAssignable, Category = "Dungeon Generation|Spawning")
+  FOnDungeonSpawnProgress OnSpawnProgress;
+
+  // Fires on every machine when the server opens the locked door, once the door
+  // actor exists there
+  UPROPERTY(BlueprintAssignable, Category = "Dungeon Generation|Network")
+  FOnDungeonLockedDoorOpened OnLockedDoorOpened;
+
   // Public functions
   UFUNCTION(BlueprintCallable, Category = "Dungeon Generation")
   void GenerateDungeon();
 
+  // Builds the layout on a worker thread and starts spawning it on the game thread
+  // when done; OnComplete runs once the safe room is up. A new request, a synchronous
+  // GenerateDungeon or CancelDungeonGeneration cancels the pending one, in which
+  // case OnComplete receives false.
+  void GenerateDungeonAsync(TFunction<void(bool bCompleted)> OnComplete = nullptr);
+
+  UFUNCTION(BlueprintCallable, Category = "Dungeon Generation")
+  void CancelDungeonGeneration();
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation")
+  bool IsGeneratingDungeon() const { return PendingCancellation.IsValid(); }
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation|Spawning")
+  bool IsSpawningDungeon() const { return SpawnQueueHead < SpawnQueue.Num(); }
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation|Navigation")
+  bool IsNavigationReady() const { return bNavigationReady; }
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation|Spawning")
+  float GetSpawnProgress() const { return SpawnQueue.Num() > 0 ? (float)SpawnQueueHead / SpawnQueue.Num() : 1.0f; }
+
   UFUNCTION(BlueprintCallable, Category = "Dungeon Generation")
   void ClearDungeon();
 
@@ -92,50 +330,183 @@ public:
 
   void SpawnBossFloor();
 
+  // Fills the pool with CountPerClass idle rooms for every configured room class
+  UFUNCTION(BlueprintCallable, Category = "Dungeon Generation|Pooling")
+  void WarmUpRoomPool(int32 CountPerClass);
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation|Pooling")
+  FDungeonRoomPoolStats GetRoomPoolStats() const { return RoomPool.GetStats(); }
+
+#if WITH_EDITOR
+  // Builds the navmesh around every room class at each yaw in cell (0, 0) of the
+  // editor world and stores the resulting tile layers in NavTileLibrary
+  UFUNCTION(CallInEditor, Category = "Dungeon Generation|Navigation")
+  void BakeRoomNavTiles();
+#endif
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation|Seed")
+  int32 GetFloorSeed() const;
+
+  // Server only. Records the change for the current floor and replicates it.
+  UFUNCTION(BlueprintCallable, Category = "Dungeon Generation|Network")
+  void OpenLockedDoor();
+
+  // Server only. The enemy's slot stays empty for the rest of the floor on every
+  // machine, including after its chunk streams out and back in.
+  UFUNCTION(BlueprintCallable, Category = "Dungeon Generation|Network")
+  void NotifyEnemyKilled(AActor* Enemy);
+
+  UFUNCTION(BlueprintPure, Category = "Dungeon Generation|Network")
+  bool IsLockedDoorOpen() const { return FloorDelta.bLockedDoorOpen; }
+
+  // Full layout fallback, driven by UDungeonLayoutSyncComponent
+  void SendFullLayout(UDungeonLayoutSyncComponent* Channel, uint16 Revision);
+  void ReceiveFullLayout(uint16 Revision, const TArray<uint8>& Data);
+
+  virtual void PostLoad() override;
+  virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 protected:
   virtual void BeginPlay() override;
+  virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+  virtual void Tick(float DeltaSeconds) override;
 
 private:
   // Data structures
-  TSet<FIntPoint> OccupiedCells;
-  TArray<FIntPoint> AvailablePositions;
+  FDungeonLayoutGenerator LayoutGenerator;
+  FDungeonLayoutCache FloorCache;
+
+  // Generators for background layout tasks, kept so their arenas survive between
+  // floors. One is free again once no task holds a reference to it.
+  TArray<TSharedPtr<FDungeonLayoutGenerator, ESPMode::ThreadSafe>> WorkerGenerators;
+  FDungeonLayout Layout;
   TArray<AActor*> ActiveDungeonRooms;
-  TMap<FIntPoint, AActor*> RoomMap;
-  TSet<FString> ConnectedDoors;
+  TArray<AActor*> RoomActors; // Spawned room per layout grid index
   TArray<AActor*> SpawnedObjects;
-  TSet<FIntPoint> LockedArea;
-  TSet<FIntPoint> AccessibleArea;
-  FIntPoint SafeRoomGridPos;
-  FIntPoint EndRoomGridPos;
-  FIntPoint KeyRoomGridPos;
-  FIntPoint LockedDoorPos1;
-  FIntPoint LockedDoorPos2;
-  ERoomDirection LockedDoorDirection;
+  FDungeonRoomPool RoomPool;
+  FDungeonRoomInstancer RoomInstancer;
+  FDungeonRoomStreamer RoomStreamer;
+  FDungeonRoomCatalog RoomCatalog;
+
+  // Room class and rotation picked for each layout grid index
+  struct FResolvedRoom
+  {
+    TSubclassOf<AActor> Class;
+    FRotator Rotation = FRotator::ZeroRotator;
+  };
+
+  TArray<FResolvedRoom> ResolvedRooms;
+
+  // Room actors carried over from the previous floor, waiting for their spawn step
+  TMap<FIntPoint, AActor*> KeptRooms;
+
+  // Cells whose geometry changed since the last navmesh update
+  TArray<FIntPoint> NavDirtyCells;
+  bool bWaitingForNavigation = false;
+  bool bNavigationReady = false;
+  TArray<TWeakObjectPtr<class AAIController>> GatedEnemyControllers;
+
+  // Wall time of the current floor's spawn and navmesh phases, for the floor log
+  double SpawnStartTime = 0.0;
+  double SpawnSeconds = 0.0;
+  double NavStartTime = 0.0;
+
+  // Set once the whole first batch of a floor has spawned; later batches are streamed chunks
+  bool bFloorSpawned = false;
+
+  FTimerHandle StreamTimer;
+
+  // Enemies by the grid index of their slot. A slot whose enemy died keeps its stale
+  // or null entry so it is never refilled.
+  TMap<int32, TWeakObjectPtr<AActor>> SlotEnemies;
+
+  // Replicated floor. Clients build the layout themselves from FloorState; the
+  // layout in hand belongs to LayoutRevision, which may lag while one is built.
+  UPROPERTY(ReplicatedUsing = OnRep_FloorState)
+  FDungeonFloorNetState FloorState;
+
+  UPROPERTY(ReplicatedUsing = OnRep_FloorDelta)
+  FDungeonFloorNetDelta FloorDelta;
+
+  uint16 LayoutRevision = 0;
+  TWeakObjectPtr<AActor> LockedDoorActor;
+  bool bLockedDoorOpenApplied = false;
+  FDelegateHandle PostLoginHandle;
+
+  // Async request in flight, if any
+  TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe> PendingCancellation;
+  TFunction<void(bool)> PendingCallback;
+
+  // Next floor, built while the current one is played. PrefetchParams says which
+  // floor it is so NextLevel can tell whether it still matches.
+  TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe> PrefetchCancellation;
+  FDungeonLayoutParams PrefetchParams;
+  FDungeonLayout PrefetchedLayout;
+  TArray<FResolvedRoom> PrefetchedRooms;
+  bool bHasPrefetchedLayout = false;
+
+  // Spawn work for the current floor, in priority order
+  enum class ESpawnStep : uint8
+  {
+    Room,
+    LockedDoor,
+    Enemy
+  };
+
+  struct FSpawnStep
+  {
+    ESpawnStep Type;
+    FIntPoint GridPos;
+  };
+
+  TArray<FSpawnStep> SpawnQueue;
+  int32 SpawnQueueHead = 0;
+  TArray<bool> EnemyAtIndex;
+  bool bLockedDoorQueued = false;
+  bool bLockedDoorHalfQueued = false;
 
   // Helper functions
-  void SpawnAllRooms();
-  void SpawnRoom(FIntPoint GridPos);
-  void SpawnSpecialRoom(TSubclassOf<AActor> RoomClass, FIntPoint GridPos);
-  void AddAdjacentPositions(FIntPoint Pos);
-  void CreateMinimalConnections();
-  void AddExtraDoors();
-  void CreateLockedArea();
-  void RemoveLockedAreaConnections();
-  void CreateSingleLockedConnection();
-  void CalculateAccessibleArea();
+  FDungeonLayoutParams MakeLayoutParams(int32 ForFloor, int32 ForCellCount, int32 ForEnemyCount) const;
+  void AdvanceFloor(int32& InOutFloor, int32& InOutCellCount, int32& InOutEnemyCount) const;
+  bool IsBossFloor(int32 ForFloor) const;
+  TSharedPtr<FDungeonLayoutGenerator, ESPMode::ThreadSafe> AcquireWorkerGenerator();
+  void LaunchLayoutTask(const FDungeonLayoutParams& Params, const TSharedPtr<FDungeonLayoutCancellation, ESPMode::ThreadSafe>& Cancellation,
+    TFunction<void(ADungeonGenerator&, FDungeonLayout&&)> OnFinished);
+  void StartPrefetch();
+  void CancelPrefetch();
+  void ApplyLayout(FDungeonLayout&& NewLayout, TArray<FResolvedRoom>&& NewResolvedRooms);
+  void PublishFloorState(bool bBossFloor);
+  UFUNCTION()
+  void OnRep_FloorState();
+  UFUNCTION()
+  void OnRep_FloorDelta();
+  void ApplyReplicatedLayout(FDungeonLayout&& NewLayout, TArray<FResolvedRoom>&& NewResolvedRooms);
+  void ApplyFloorDelta();
+  void AddLayoutSyncComponent(class AGameModeBase* GameMode, class APlayerController* Player);
+  bool IsSpawnedLocally(TSubclassOf<AActor> Class) const;
+  void MovePlayerToSafeRoom();
+  void BuildSpawnQueue();
+  void QueueRoom(int32 Index);
+  void ProcessSpawnQueue();
+  void UpdateStreaming();
+  int32 GetStreamUnloadHops() const { return FMath::Max(StreamUnloadHops, StreamLoadHops + 1); }
+  FIntPoint GetCellAt(const FVector& Location) const;
+  void ResolveRooms(const FDungeonLayout& ForLayout, TArray<FResolvedRoom>& OutRooms);
+  void BuildRoomCatalog();
+  FResolvedRoom ResolveRoom(FIntPoint GridPos, uint8 Doors, const FRandomStream& Stream, FDungeonRoomCatalog::FPickState& PickState);
+  FResolvedRoom ResolveSpecialRoom(TSubclassOf<AActor> RoomClass, FIntPoint GridPos, uint8 Doors);
+  void SpawnQueuedRoom(FIntPoint GridPos);
+  AActor* SpawnRoomActor(TSubclassOf<AActor> RoomClass, const FVector& Location, const FRotator& Rotation);
+  void ReleaseRoomActor(AActor* Room);
   void SpawnLockedDoor();
-  void PlaceKeyRoom();
-  void SpawnObjectsInFarRooms();
-  FString GetConnectionKey(FIntPoint Pos1, FIntPoint Pos2) const;
-  bool HasDoorConnection(FIntPoint Pos1, FIntPoint Pos2) const;
+  AActor* SpawnEnemy(FIntPoint GridPos);
+  void CollectKeptRooms(const FDungeonLayout& NewLayout, const TArray<FResolvedRoom>& NewResolvedRooms, TMap<FIntPoint, AActor*>& OutKeptRooms);
+  void AddNavDirtyCell(FIntPoint GridPos);
+  FBox GetCellNavBounds(FIntPoint GridPos) const;
+  bool StitchNavCell(ARecastNavMesh* NavMesh, FIntPoint GridPos);
   void RebuildNavigation();
+  void CheckNavigationReady();
 
   // Room selection helpers
-  TSubclassOf<AActor> GetRandomClass(const TArray<TSubclassOf<AActor>>& ClassArray);
-  FRotator GetDeadendRotation(ERoomDirection OpenDir);
-  FRotator GetStraightRotation(ERoomDirection FirstDir);
-  FRotator GetTurnRotation(ERoomDirection Dir1, ERoomDirection Dir2);
-  FRotator GetTJunctionRotation(const TArray<ERoomDirection>& OpenDirs);
-  bool IsOpposite(ERoomDirection Dir1, ERoomDirection Dir2);
   FVector GetRotationOffset(float YawRotation);
 };
\ No newline at end of file
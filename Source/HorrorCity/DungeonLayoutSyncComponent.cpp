@@ -0,0 +1,104 @@
+// DungeonLayoutSyncComponent.cpp
+#include "DungeonLayoutSyncComponent.h"
+#include "DungeonGenerator.h"
+
+UDungeonLayoutSyncComponent::UDungeonLayoutSyncComponent()
+{
+  PrimaryComponentTick.bCanEverTick = false;
+  SetIsReplicatedByDefault(true);
+}
+
+void UDungeonLayoutSyncComponent::RequestLayout(ADungeonGenerator* Generator, uint16 Revision)
+{
+  ReceivingRevision = Revision;
+  ReceivingSize = 0;
+  ReceivedData.Reset();
+  ServerRequestLayout(Generator, Revision);
+}
+
+void UDungeonLayoutSyncComponent::ServerRequestLayout_Implementation(ADungeonGenerator* Generator, uint16 Revision)
+{
+  if (Generator)
+  {
+    Generator->SendFullLayout(this, Revision);
+  }
+}
+
+bool UDungeonLayoutSyncComponent::IsSendingLayout(uint16 Revision) const
+{
+  return SendingData.Num() > 0 && SendingRevision == Revision;
+}
+
+void UDungeonLayoutSyncComponent::SendLayout(ADungeonGenerator* Generator, uint16 Revision, TArray<uint8>&& Data)
+{
+  if (IsSendingLayout(Revision)) return;
+
+  SendingGenerator = Generator;
+  SendingRevision = Revision;
+  SendingData = MoveTemp(Data);
+  SendOffset = 0;
+  SendChunks();
+}
+
+void UDungeonLayoutSyncComponent::ServerAckLayoutChunk_Implementation()
+{
+  ChunksInFlight = FMath::Max(0, ChunksInFlight - 1);
+  SendChunks();
+}
+
+void UDungeonLayoutSyncComponent::SendChunks()
+{
+  ADungeonGenerator* Generator = SendingGenerator.Get();
+  if (Generator)
+  {
+    TArray<uint8> Chunk;
+    while (SendOffset < SendingData.Num() && ChunksInFlight < MaxChunksInFlight)
+    {
+      const int32 Size = FMath::Min(ChunkSize, SendingData.Num() - SendOffset);
+      Chunk.Reset();
+      Chunk.Append(SendingData.GetData() + SendOffset, Size);
+      ClientReceiveLayoutChunk(Generator, SendingRevision, SendingData.Num(), Chunk);
+      SendOffset += Size;
+      ChunksInFlight++;
+    }
+  }
+
+  // The transfer ends once the client holds every piece, or when the floor is gone
+  if (!Generator || (SendOffset == SendingData.Num() && ChunksInFlight == 0))
+  {
+    SendingData.Empty();
+    SendOffset = 0;
+  }
+}
+
+void UDungeonLayoutSyncComponent::ClientReceiveLayoutChunk_Implementation(ADungeonGenerator* Generator, uint16 Revision, int32 TotalSize,
+  const TArray<uint8>& Chunk)
+{
+  // Every piece is acked, wanted or not, so the server can send the next one
+  ServerAckLayoutChunk();
+
+  // Pieces of a layout the client has since stopped waiting for
+  if (!Generator || Revision != ReceivingRevision) return;
+
+  if (ReceivedData.Num() == 0)
+  {
+    if (TotalSize <= 0 || TotalSize > MaxLayoutSize) return;
+    ReceivingSize = TotalSize;
+    ReceivedData.Reserve(TotalSize);
+  }
+
+  if (TotalSize != ReceivingSize || ReceivedData.Num() + Chunk.Num() > ReceivingSize)
+  {
+    UE_LOG(LogTemp, Warning, TEXT("Dropping malformed layout transfer for floor revision %d"), Revision);
+    ReceivedData.Reset();
+    return;
+  }
+
+  ReceivedData.Append(Chunk);
+  if (ReceivedData.Num() == ReceivingSize)
+  {
+    TArray<uint8> Data = MoveTemp(ReceivedData);
+    ReceivedData.Reset();
+    Generator->ReceiveFullLayout(Revision, Data);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DungeonLayoutFormat.h"
+#include "DungeonLayoutSyncComponent.generated.h"
+
+class ADungeonGenerator;
+
+// Per-player channel for the one thing floor replication can't do through the
+// generator itself: a client whose locally built floor doesn't match the server's
+// checksum asks for the full binary layout, and the server sends it to that client
+// alone, a few pieces at a time. The generator adds one to every player controller
+// on the server.
+UCLASS()
+class HORRORCITY_API UDungeonLayoutSyncComponent : public UActorComponent
+{
+  GENERATED_BODY()
+
+public:
+  UDungeonLayoutSyncComponent();
+
+  // Layouts are sent in reliable pieces of this size so no single bunch gets large
+  static constexpr int32 ChunkSize = 16 * 1024;
+
+  // Pieces sent and not yet acked by the client. Each piece goes out as about sixteen
+  // reliable partial bunches, so however big the layout, a transfer stays well inside
+  // the channel's reliable buffer instead of overflowing it and losing the connection.
+  static constexpr int32 MaxChunksInFlight = 4;
+
+  // The largest layout the generator can produce; anything bigger is not a layout
+  static constexpr int32 MaxLayoutSize = (int32)FDungeonLayoutFormat::MaxFileSize;
+  static_assert(FDungeonLayoutFormat::MaxFileSize <= MAX_int32, "Layouts must fit an int32 size");
+
+  void RequestLayout(ADungeonGenerator* Generator, uint16 Revision);
+
+  // Server side. A client gets one transfer at a time: asking again for the floor
+  // already on its way is ignored, and a newer floor replaces it.
+  bool IsSendingLayout(uint16 Revision) const;
+  void SendLayout(ADungeonGenerator* Generator, uint16 Revision, TArray<uint8>&& Data);
+
+private:
+  UFUNCTION(Server, Reliable)
+  void ServerRequestLayout(ADungeonGenerator* Generator, uint16 Revision);
+
+  UFUNCTION(Server, Reliable)
+  void ServerAckLayoutChunk();
+
+  UFUNCTION(Client, Reliable)
+  void ClientReceiveLayoutChunk(ADungeonGenerator* Generator, uint16 Revision, int32 TotalSize, const TArray<uint8>& Chunk);
+
+  // Sends pieces of the current transfer until MaxChunksInFlight are on the wire
+  void SendChunks();
+
+  // Layout being sent, if any. SendOffset is the first byte not sent yet.
+  TWeakObjectPtr<ADungeonGenerator> SendingGenerator;
+  uint16 SendingRevision = 0;
+  int32 SendOffset = 0;
+  TArray<uint8> SendingData;
+
+  // Counts pieces of a replaced transfer too, until the client acks them
+  int32 ChunksInFlight = 0;
+
+  // Layout being received, if any
+  uint16 ReceivingRevision = 0;
+  int32 ReceivingSize = 0;
+  TArray<uint8> ReceivedData;
+};
@@ -0,0 +1,176 @@
+// DungeonNavTileLibrary.cpp
+#include "DungeonNavTileLibrary.h"
+#include "NavMesh/RecastNavMesh.h"
+#if WITH_RECAST
+#include "Detour/DetourAlloc.h"
+#include "DetourTileCache/DetourTileCacheBuilder.h"
+#endif
+
+int32 UDungeonNavTileLibrary::YawToQuadrant(float Yaw)
+{
+  return ((FMath::RoundToInt(Yaw / 90.0f) % 4) + 4) % 4;
+}
+
+const FDungeonNavTileEntry* UDungeonNavTileLibrary::FindEntry(UClass* RoomClass, float Yaw) const
+{
+  const int32 Quadrant = YawToQuadrant(Yaw);
+  return Entries.FindByPredicate([RoomClass, Quadrant](const FDungeonNavTileEntry& Entry)
+    {
+      return Entry.RoomClass == RoomClass && Entry.YawQuadrant == Quadrant;
+    });
+}
+
+bool UDungeonNavTileLibrary::IsCompatible(const ARecastNavMesh* NavMesh, float InCellSize) const
+{
+  return NavMesh && TileSize > 0.0f &&
+    FMath::IsNearlyEqual(CellSize, InCellSize) &&
+    FMath::IsNearlyEqual(TileSize, NavMesh->GetTileSizeUU());
+}
+
+void UDungeonNavTileLibrary::GetCellTiles(const ARecastNavMesh* NavMesh, FIntPoint Cell, FIntPoint& OutMin, FIntPoint& OutMax) const
+{
+  // Sample just inside opposite corners; Recast's axes are flipped relative to the
+  // grid, so sort the results
+  const float Inset = TileSize * 0.5f;
+  int32 AX = 0, AY = 0, BX = 0, BY = 0;
+  NavMesh->GetNavMeshTileXY(FVector(Cell.X * CellSize + Inset, Cell.Y * CellSize + Inset, 0.0f), AX, AY);
+  NavMesh->GetNavMeshTileXY(FVector((Cell.X + 1) * CellSize - Inset, (Cell.Y + 1) * CellSize - Inset, 0.0f), BX, BY);
+
+  OutMin = FIntPoint(FMath::Min(AX, BX), FMath::Min(AY, BY));
+  OutMax = FIntPoint(FMath::Max(AX, BX), FMath::Max(AY, BY));
+}
+
+bool UDungeonNavTileLibrary::Stitch(ARecastNavMesh* NavMesh, const FDungeonNavTileEntry& Entry, FIntPoint TargetCell) const
+{
+#if WITH_RECAST
+  FIntPoint BakeMin, BakeMax, TargetMin, TargetMax;
+  GetCellTiles(NavMesh, Entry.BakeCell, BakeMin, BakeMax);
+  GetCellTiles(NavMesh, TargetCell, TargetMin, TargetMax);
+
+  const FIntPoint TileDelta = TargetMin - BakeMin;
+  const FVector WorldDelta((TargetCell.X - Entry.BakeCell.X) * CellSize, (TargetCell.Y - Entry.BakeCell.Y) * CellSize, 0.0f);
+
+  TMap<FIntPoint, TArray<FNavMeshTileData>> LayersByTile;
+  for (int32 X = TargetMin.X; X <= TargetMax.X; X++)
+  {
+    for (int32 Y = TargetMin.Y; Y <= TargetMax.Y; Y++)
+    {
+      LayersByTile.Add(FIntPoint(X, Y));
+    }
+  }
+
+  for (const FDungeonNavTileLayer& Layer : Entry.Layers)
+  {
+    if (Layer.Data.Num() < (int32)sizeof(dtTileCacheLayerHeader)) return false;
+
+    uint8* Data = (uint8*)dtAlloc(Layer.Data.Num(), DT_ALLOC_PERM_TILE_DATA);
+    FMemory::Memcpy(Data, Layer.Data.GetData(), Layer.Data.Num());
+
+    // The header sits uncompressed in front of the layer. Moving a layer to another
+    // tile only needs its tile coordinates and bounds shifted by whole tiles.
+    dtTileCacheLayerHeader* Header = (dtTileCacheLayerHeader*)Data;
+    if (Header->magic != DT_TILECACHE_MAGIC || Header->version != DT_TILECACHE_VERSION)
+    {
+      dtFree(Data, DT_ALLOC_PERM_TILE_DATA);
+      return false;
+    }
+
+    Header->tx += TileDelta.X;
+    Header->ty += TileDelta.Y;
+    Header->bmin[0] += TileDelta.X * TileSize;
+    Header->bmax[0] += TileDelta.X * TileSize;
+    Header->bmin[2] += TileDelta.Y * TileSize;
+    Header->bmax[2] += TileDelta.Y * TileSize;
+
+    const FIntPoint Tile = Layer.TileOffset + TargetMin;
+    TArray<FNavMeshTileData>* TileLayers = LayersByTile.Find(Tile);
+    if (!TileLayers)
+    {
+      dtFree(Data, DT_ALLOC_PERM_TILE_DATA);
+      return false;
+    }
+
+    FBox Bounds = Layer.Bounds;
+    Bounds = Bounds.ShiftBy(WorldDelta);
+    TileLayers->Add(FNavMeshTileData(Data, Layer.Data.Num(), Layer.LayerIndex, Bounds));
+  }
+
+  for (TPair<FIntPoint, TArray<FNavMeshTileData>>& Pair : LayersByTile)
+  {
+    if (Pair.Value.Num() > 0)
+    {
+      NavMesh->AddTileCacheLayers(Pair.Key.X, Pair.Key.Y, Pair.Value);
+    }
+    else
+    {
+      NavMesh->MarkEmptyTileCacheLayers(Pair.Key.X, Pair.Key.Y);
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void UDungeonNavTileLibrary::ClearCell(ARecastNavMesh* NavMesh, FIntPoint Cell) const
+{
+  FIntPoint Min, Max;
+  GetCellTiles(NavMesh, Cell, Min, Max);
+
+  for (int32 X = Min.X; X <= Max.X; X++)
+  {
+    for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+    {
+      NavMesh->MarkEmptyTileCacheLayers(X, Y);
+    }
+  }
+}
+
+#if WITH_EDITOR
+void UDungeonNavTileLibrary::Reset(float InCellSize, float InTileSize)
+{
+  Modify();
+  CellSize = InCellSize;
+  TileSize = InTileSize;
+  Entries.Empty();
+}
+
+bool UDungeonNavTileLibrary::Capture(ARecastNavMesh* NavMesh, TSubclassOf<AActor> RoomClass, int32 YawQuadrant, FIntPoint BakeCell)
+{
+  FIntPoint Min, Max;
+  GetCellTiles(NavMesh, BakeCell, Min, Max);
+
+  FDungeonNavTileEntry Entry;
+  Entry.RoomClass = RoomClass;
+  Entry.YawQuadrant = YawQuadrant;
+  Entry.BakeCell = BakeCell;
+
+  for (int32 X = Min.X; X <= Max.X; X++)
+  {
+    for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+    {
+      for (const FNavMeshTileData& TileLayer : NavMesh->GetTileCacheLayers(X, Y))
+      {
+        if (!TileLayer.IsValid()) continue;
+
+        FDungeonNavTileLayer& Layer = Entry.Layers.AddDefaulted_GetRef();
+        Layer.TileOffset = FIntPoint(X, Y) - Min;
+        Layer.LayerIndex = TileLayer.LayerIndex;
+        Layer.Bounds = TileLayer.LayerBBox;
+        Layer.Data.Append(TileLayer.GetData(), TileLayer.DataSize);
+      }
+    }
+  }
+
+  if (Entry.Layers.Num() == 0)
+  {
+    UE_LOG(LogTemp, Warning, TEXT("No navmesh layers under %s at yaw %d; is the navmesh's runtime generation dynamic?"),
+      *GetNameSafe(RoomClass), YawQuadrant * 90);
+    return false;
+  }
+
+  Modify();
+  Entries.Add(MoveTemp(Entry));
+  return true;
+}
+#endif
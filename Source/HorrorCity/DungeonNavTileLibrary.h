@@ -0,0 +1,91 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DungeonNavTileLibrary.generated.h"
+
+class ARecastNavMesh;
+
+// One tile cache layer captured under a baked room
+USTRUCT()
+struct FDungeonNavTileLayer
+{
+  GENERATED_BODY()
+
+  // Tile relative to the first tile of the cell
+  UPROPERTY()
+  FIntPoint TileOffset = FIntPoint::ZeroValue;
+
+  UPROPERTY()
+  int32 LayerIndex = 0;
+
+  UPROPERTY()
+  FBox Bounds = FBox(ForceInit);
+
+  // Compressed layer as produced by Recast, header included
+  UPROPERTY()
+  TArray<uint8> Data;
+};
+
+// Navigation for one room class at one yaw quadrant
+USTRUCT()
+struct FDungeonNavTileEntry
+{
+  GENERATED_BODY()
+
+  UPROPERTY(VisibleAnywhere, Category = "Navigation")
+  TSubclassOf<AActor> RoomClass;
+
+  // Yaw / 90, in 0..3
+  UPROPERTY(VisibleAnywhere, Category = "Navigation")
+  int32 YawQuadrant = 0;
+
+  UPROPERTY()
+  FIntPoint BakeCell = FIntPoint::ZeroValue;
+
+  UPROPERTY()
+  TArray<FDungeonNavTileLayer> Layers;
+};
+
+// Prebaked navmesh tile cache layers per room class and rotation. The navmesh
+// rebuilds a stitched tile from these layers without voxelising any geometry.
+// Needs CellSize to be a whole number of navmesh tiles so no tile spans two cells.
+UCLASS(BlueprintType)
+class HORRORCITY_API UDungeonNavTileLibrary : public UDataAsset
+{
+  GENERATED_BODY()
+
+public:
+  UPROPERTY(VisibleAnywhere, Category = "Navigation")
+  float CellSize = 0.0f;
+
+  UPROPERTY(VisibleAnywhere, Category = "Navigation")
+  float TileSize = 0.0f;
+
+  UPROPERTY(VisibleAnywhere, Category = "Navigation")
+  TArray<FDungeonNavTileEntry> Entries;
+
+  static int32 YawToQuadrant(float Yaw);
+
+  const FDungeonNavTileEntry* FindEntry(UClass* RoomClass, float Yaw) const;
+
+  // True if tiles baked into this library line up with NavMesh and InCellSize
+  bool IsCompatible(const ARecastNavMesh* NavMesh, float InCellSize) const;
+
+  // Moves the entry's layers onto the tiles under TargetCell. The caller then dirties
+  // the cell with ENavigationDirtyFlag::DynamicModifier so only those layers are used.
+  bool Stitch(ARecastNavMesh* NavMesh, const FDungeonNavTileEntry& Entry, FIntPoint TargetCell) const;
+
+  // Empties the tiles under Cell
+  void ClearCell(ARecastNavMesh* NavMesh, FIntPoint Cell) const;
+
+#if WITH_EDITOR
+  void Reset(float InCellSize, float InTileSize);
+
+  // Stores the cached layers of every tile under BakeCell after a navmesh build
+  bool Capture(ARecastNavMesh* NavMesh, TSubclassOf<AActor> RoomClass, int32 YawQuadrant, FIntPoint BakeCell);
+#endif
+
+private:
+  // Inclusive tile range covered by a cell
+  void GetCellTiles(const ARecastNavMesh* NavMesh, FIntPoint Cell, FIntPoint& OutMin, FIntPoint& OutMax) const;
+};
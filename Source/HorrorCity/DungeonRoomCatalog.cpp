@@ -0,0 +1,36 @@
+// DungeonRoomCatalog.cpp
+#include "DungeonRoomCatalog.h"
+
+void FDungeonRoomCatalog::SetVariants(EDungeonRoomShape Shape, const TArray<TSubclassOf<AActor>>& Classes, const TMap<TSubclassOf<AActor>, float>& Weights)
+{
+  FShapeVariants& Variants = Shapes[(int32)Shape];
+  Variants.Classes = Classes;
+
+  TArray<float, TInlineAllocator<32>> VariantWeights;
+  for (const TSubclassOf<AActor>& Class : Classes)
+  {
+    const float* Weight = Weights.Find(Class);
+    VariantWeights.Add(Class ? (Weight ? *Weight : 1.0f) : 0.0f);
+  }
+  Variants.All.Build(VariantWeights);
+
+  Variants.Without.SetNum(Classes.Num());
+  for (int32 Variant = 0; Variant < Classes.Num(); Variant++)
+  {
+    const float Weight = VariantWeights[Variant];
+    VariantWeights[Variant] = 0.0f;
+    Variants.Without[Variant].Build(VariantWeights);
+    VariantWeights[Variant] = Weight;
+  }
+}
+
+TSubclassOf<AActor> FDungeonRoomCatalog::Pick(EDungeonRoomShape Shape, const FRandomStream& Stream, bool bAvoidRepeat, FPickState& State) const
+{
+  const FShapeVariants& Variants = Shapes[(int32)Shape];
+  if (Variants.All.IsEmpty()) return nullptr;
+
+  int32& Last = State.LastVariant[(int32)Shape];
+  const bool bExcludeLast = bAvoidRepeat && Variants.Without.IsValidIndex(Last) && !Variants.Without[Last].IsEmpty();
+  Last = (bExcludeLast ? Variants.Without[Last] : Variants.All).Sample(Stream);
+  return Variants.Classes[Last];
+}
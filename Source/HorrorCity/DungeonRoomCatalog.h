@@ -0,0 +1,44 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonRoomShapes.h"
+#include "DungeonAliasTable.h"
+
+// Room classes per shape with weighted O(1) draws. Besides the full table each
+// shape keeps one table per variant with that variant left out, so a pick that must
+// differ from the previous one is still a single exact draw.
+class FDungeonRoomCatalog
+{
+public:
+  static constexpr int32 NumShapes = (int32)EDungeonRoomShape::Num;
+
+  // Last variant drawn per shape, for the no-repeat rule
+  struct FPickState
+  {
+    int32 LastVariant[NumShapes];
+
+    FPickState()
+    {
+      for (int32& Variant : LastVariant)
+      {
+        Variant = INDEX_NONE;
+      }
+    }
+  };
+
+  // Classes missing from Weights weigh 1; empty entries are never drawn
+  void SetVariants(EDungeonRoomShape Shape, const TArray<TSubclassOf<AActor>>& Classes, const TMap<TSubclassOf<AActor>, float>& Weights);
+
+  // Null if the shape has nothing to draw. With bAvoidRepeat the class differs from
+  // the previous pick for the shape unless it is the only one.
+  TSubclassOf<AActor> Pick(EDungeonRoomShape Shape, const FRandomStream& Stream, bool bAvoidRepeat, FPickState& State) const;
+
+private:
+  struct FShapeVariants
+  {
+    TArray<TSubclassOf<AActor>> Classes;
+    FDungeonAliasTable All;
+    TArray<FDungeonAliasTable> Without;
+  };
+
+  FShapeVariants Shapes[NumShapes];
+};
@@ -0,0 +1,188 @@
+// DungeonRoomInstancer.cpp
+#include "DungeonRoomInstancer.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/Actor.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "DungeonLayoutStats.h"
+
+const FName FDungeonRoomInstancer::NoInstancingTag(TEXT("DungeonNoInstancing"));
+
+// Transform of a component relative to its actor's root
+static FTransform GetTransformInActor(const USceneComponent* Component)
+{
+  FTransform Result = FTransform::Identity;
+  for (const USceneComponent* Current = Component; Current && Current->GetAttachParent(); Current = Current->GetAttachParent())
+  {
+    Result = Result * Current->GetRelativeTransform();
+  }
+  return Result;
+}
+
+bool FDungeonRoomInstancer::AddRoom(AActor* Owner, TSubclassOf<AActor> RoomClass, const FTransform& RoomTransform, TArray<AActor*>& OutActors)
+{
+  if (!Owner || !RoomClass) return false;
+
+  const FRoomBake& Bake = GetBake(Owner, RoomClass);
+  if (!Bake.bInstanceable) return false;
+
+  for (const FBakedMesh& Mesh : Bake.Meshes)
+  {
+    Batches[Mesh.Batch].Pending.Add(Mesh.RelativeTransform * RoomTransform);
+  }
+
+  FActorSpawnParameters SpawnParams;
+  SpawnParams.Owner = Owner;
+
+  for (const FBakedActor& Part : Bake.Actors)
+  {
+    AActor* PartActor = Owner->GetWorld()->SpawnActor<AActor>(Part.Class, Part.RelativeTransform * RoomTransform, SpawnParams);
+    if (PartActor)
+    {
+      INC_DWORD_STAT(STAT_DungeonActorsSpawned);
+      OutActors.Add(PartActor);
+    }
+  }
+  return true;
+}
+
+void FDungeonRoomInstancer::Flush()
+{
+  for (FInstanceBatch& Batch : Batches)
+  {
+    if (Batch.Pending.Num() == 0) continue;
+
+    if (IsValid(Batch.Component))
+    {
+      Batch.Component->AddInstances(Batch.Pending, false, true);
+    }
+    Batch.Pending.Reset();
+  }
+}
+
+void FDungeonRoomInstancer::Clear()
+{
+  for (FInstanceBatch& Batch : Batches)
+  {
+    Batch.Pending.Reset();
+    if (IsValid(Batch.Component))
+    {
+      Batch.Component->ClearInstances();
+    }
+  }
+}
+
+const FDungeonRoomInstancer::FRoomBake& FDungeonRoomInstancer::GetBake(AActor* Owner, UClass* RoomClass)
+{
+  if (const FRoomBake* Existing = Bakes.Find(RoomClass))
+  {
+    return *Existing;
+  }
+
+  FRoomBake Bake;
+
+  if (RoomClass->GetDefaultObject<AActor>()->ActorHasTag(NoInstancingTag))
+  {
+    return Bakes.Add(RoomClass, MoveTemp(Bake));
+  }
+
+  // Run the construction script on a throwaway instance. The template never begins
+  // play, but construction registers its components and spawns any child actors, so
+  // they exist in the world until the Destroy below. Collision is off for that window
+  // since the template sits at the origin regardless of what is there.
+  FActorSpawnParameters SpawnParams;
+  SpawnParams.bDeferConstruction = true;
+  SpawnParams.ObjectFlags |= RF_Transient;
+  SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+  AActor* Template = Owner->GetWorld()->SpawnActor<AActor>(RoomClass, FTransform::Identity, SpawnParams);
+  if (!Template)
+  {
+    return Bakes.Add(RoomClass, MoveTemp(Bake));
+  }
+  Template->SetActorEnableCollision(false);
+  Template->ExecuteConstruction(FTransform::Identity, nullptr, nullptr, true);
+
+  Bake.bInstanceable = true;
+
+  TInlineComponentArray<UActorComponent*> Components;
+  Template->GetComponents(Components);
+
+  for (UActorComponent* Component : Components)
+  {
+    if (Component->IsEditorOnly()) continue;
+
+    UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component);
+    UChildActorComponent* ChildComponent = Cast<UChildActorComponent>(Component);
+
+    if (MeshComponent && !MeshComponent->IsA<UInstancedStaticMeshComponent>())
+    {
+      UStaticMesh* Mesh = MeshComponent->GetStaticMesh();
+      if (!Mesh) continue;
+
+      TArray<UMaterialInterface*> Materials;
+      for (int32 i = 0; i < MeshComponent->GetNumMaterials(); i++)
+      {
+        Materials.Add(MeshComponent->GetMaterial(i));
+      }
+
+      FBakedMesh& Baked = Bake.Meshes.AddDefaulted_GetRef();
+      Baked.Batch = FindOrAddBatch(Owner, Mesh, Materials, MeshComponent->GetCollisionProfileName());
+      Baked.RelativeTransform = GetTransformInActor(MeshComponent);
+    }
+    else if (ChildComponent)
+    {
+      if (ChildComponent->GetChildActorClass())
+      {
+        Bake.Actors.Add({ ChildComponent->GetChildActorClass(), GetTransformInActor(ChildComponent) });
+      }
+    }
+    else if (Component->GetClass() != USceneComponent::StaticClass())
+    {
+      UE_LOG(LogTemp, Log, TEXT("%s has a %s component and will be spawned as an actor"),
+        *RoomClass->GetName(), *Component->GetClass()->GetName());
+      Bake.bInstanceable = false;
+      break;
+    }
+  }
+
+  Template->Destroy();
+
+  if (!Bake.bInstanceable)
+  {
+    Bake.Meshes.Empty();
+    Bake.Actors.Empty();
+  }
+  return Bakes.Add(RoomClass, MoveTemp(Bake));
+}
+
+int32 FDungeonRoomInstancer::FindOrAddBatch(AActor* Owner, UStaticMesh* Mesh, const TArray<UMaterialInterface*>& Materials, FName CollisionProfile)
+{
+  for (int32 i = 0; i < Batches.Num(); i++)
+  {
+    const FInstanceBatch& Batch = Batches[i];
+    if (Batch.Mesh == Mesh && Batch.Materials == Materials && Batch.CollisionProfile == CollisionProfile)
+    {
+      return i;
+    }
+  }
+
+  UHierarchicalInstancedStaticMeshComponent* Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner);
+  Component->SetStaticMesh(Mesh);
+  for (int32 i = 0; i < Materials.Num(); i++)
+  {
+    Component->SetMaterial(i, Materials[i]);
+  }
+  Component->SetCollisionProfileName(CollisionProfile);
+  Component->SetupAttachment(Owner->GetRootComponent());
+  Component->RegisterComponent();
+  Owner->AddInstanceComponent(Component);
+
+  FInstanceBatch& Batch = Batches.AddDefaulted_GetRef();
+  Batch.Mesh = Mesh;
+  Batch.Materials = Materials;
+  Batch.CollisionProfile = CollisionProfile;
+  Batch.Component = Component;
+  return Batches.Num() - 1;
+}
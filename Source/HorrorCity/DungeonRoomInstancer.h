@@ -0,0 +1,63 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class UStaticMesh;
+class UMaterialInterface;
+class UHierarchicalInstancedStaticMeshComponent;
+
+// Materialises rooms as hierarchical instanced meshes shared by the whole floor
+// instead of one actor per room. Each room class is baked once: its static mesh
+// components become instances and its child actor components stay real actors.
+// A class with any other component (lights, triggers, audio...) or the
+// NoInstancingTag actor tag is not instanceable and is spawned as a normal actor.
+class FDungeonRoomInstancer
+{
+public:
+  static const FName NoInstancingTag;
+
+  // Adds one room. Returns false if RoomClass can't be instanced; the caller spawns
+  // it as an actor instead. Actors spawned for interactive parts go to OutActors.
+  bool AddRoom(AActor* Owner, TSubclassOf<AActor> RoomClass, const FTransform& RoomTransform, TArray<AActor*>& OutActors);
+
+  // Pushes rooms added since the last flush to their components in one batch each
+  void Flush();
+
+  // Removes every instance. Components and bakes are kept for the next floor.
+  void Clear();
+
+private:
+  struct FBakedMesh
+  {
+    int32 Batch = INDEX_NONE;
+    FTransform RelativeTransform;
+  };
+
+  struct FBakedActor
+  {
+    TSubclassOf<AActor> Class;
+    FTransform RelativeTransform;
+  };
+
+  struct FRoomBake
+  {
+    bool bInstanceable = false;
+    TArray<FBakedMesh> Meshes;
+    TArray<FBakedActor> Actors;
+  };
+
+  // One component per distinct mesh, material and collision combination
+  struct FInstanceBatch
+  {
+    UStaticMesh* Mesh = nullptr;
+    TArray<UMaterialInterface*> Materials;
+    FName CollisionProfile;
+    UHierarchicalInstancedStaticMeshComponent* Component = nullptr;
+    TArray<FTransform> Pending;
+  };
+
+  const FRoomBake& GetBake(AActor* Owner, UClass* RoomClass);
+  int32 FindOrAddBatch(AActor* Owner, UStaticMesh* Mesh, const TArray<UMaterialInterface*>& Materials, FName CollisionProfile);
+
+  TMap<UClass*, FRoomBake> Bakes;
+  TArray<FInstanceBatch> Batches;
+};
@@ -0,0 +1,110 @@
+// DungeonRoomPool.cpp
+#include "DungeonRoomPool.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "DungeonLayoutStats.h"
+
+AActor* FDungeonRoomPool::Acquire(UWorld* World, TSubclassOf<AActor> RoomClass, const FVector& Location, const FRotator& Rotation, AActor* Owner)
+{
+  if (!World || !RoomClass) return nullptr;
+
+  if (TArray<TWeakObjectPtr<AActor>>* Free = FreeRooms.Find(RoomClass))
+  {
+    while (Free->Num() > 0)
+    {
+      AActor* Room = Free->Pop(EAllowShrinking::No).Get();
+      Stats.Pooled--;
+
+      // Something else may have destroyed it while it sat in the pool
+      if (!IsValid(Room)) continue;
+
+      Room->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+      Room->SetActorHiddenInGame(false);
+      Room->SetActorEnableCollision(true);
+      Room->SetActorTickEnabled(Room->PrimaryActorTick.bStartWithTickEnabled);
+
+      Stats.Hits++;
+      Stats.InUse++;
+      Stats.HighWaterMark = FMath::Max(Stats.HighWaterMark, Stats.InUse);
+      return Room;
+    }
+  }
+
+  FActorSpawnParameters SpawnParams;
+  SpawnParams.Owner = Owner;
+  AActor* Room = World->SpawnActor<AActor>(RoomClass, Location, Rotation, SpawnParams);
+  if (Room)
+  {
+    INC_DWORD_STAT(STAT_DungeonActorsSpawned);
+    Stats.Misses++;
+    Stats.InUse++;
+    Stats.HighWaterMark = FMath::Max(Stats.HighWaterMark, Stats.InUse);
+  }
+  return Room;
+}
+
+void FDungeonRoomPool::Release(AActor* Room)
+{
+  if (!IsValid(Room)) return;
+  Stats.InUse--;
+
+  TArray<TWeakObjectPtr<AActor>>& Free = FreeRooms.FindOrAdd(Room->GetClass());
+  if (Free.Num() >= MaxPooledPerClass)
+  {
+    Room->Destroy();
+    INC_DWORD_STAT(STAT_DungeonActorsDestroyed);
+    Stats.Evictions++;
+    return;
+  }
+
+  Deactivate(Room);
+  Free.Add(Room);
+  Stats.Pooled++;
+}
+
+void FDungeonRoomPool::WarmUp(UWorld* World, TSubclassOf<AActor> RoomClass, int32 Count, AActor* Owner)
+{
+  if (!World || !RoomClass) return;
+
+  TArray<TWeakObjectPtr<AActor>>& Free = FreeRooms.FindOrAdd(RoomClass);
+  const int32 Target = FMath::Min(Count, MaxPooledPerClass);
+
+  FActorSpawnParameters SpawnParams;
+  SpawnParams.Owner = Owner;
+
+  while (Free.Num() < Target)
+  {
+    AActor* Room = World->SpawnActor<AActor>(RoomClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+    if (!Room) break;
+    INC_DWORD_STAT(STAT_DungeonActorsSpawned);
+
+    Deactivate(Room);
+    Free.Add(Room);
+    Stats.Pooled++;
+  }
+}
+
+void FDungeonRoomPool::Empty()
+{
+  for (TPair<UClass*, TArray<TWeakObjectPtr<AActor>>>& Pair : FreeRooms)
+  {
+    for (const TWeakObjectPtr<AActor>& WeakRoom : Pair.Value)
+    {
+      AActor* Room = WeakRoom.Get();
+      if (IsValid(Room))
+      {
+        Room->Destroy();
+        INC_DWORD_STAT(STAT_DungeonActorsDestroyed);
+      }
+    }
+  }
+  FreeRooms.Empty();
+  Stats.Pooled = 0;
+}
+
+void FDungeonRoomPool::Deactivate(AActor* Room)
+{
+  Room->SetActorHiddenInGame(true);
+  Room->SetActorEnableCollision(false);
+  Room->SetActorTickEnabled(false);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonRoomPool.generated.h"
+
+USTRUCT(BlueprintType)
+struct FDungeonRoomPoolStats
+{
+  GENERATED_BODY()
+
+  // Acquires served from the pool
+  UPROPERTY(BlueprintReadOnly, Category = "Dungeon Generation|Pool")
+  int32 Hits = 0;
+
+  // Acquires that had to spawn a new actor
+  UPROPERTY(BlueprintReadOnly, Category = "Dungeon Generation|Pool")
+  int32 Misses = 0;
+
+  // Released actors destroyed because their class was already at the cap
+  UPROPERTY(BlueprintReadOnly, Category = "Dungeon Generation|Pool")
+  int32 Evictions = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "Dungeon Generation|Pool")
+  int32 InUse = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "Dungeon Generation|Pool")
+  int32 Pooled = 0;
+
+  // Most actors in use at once
+  UPROPERTY(BlueprintReadOnly, Category = "Dungeon Generation|Pool")
+  int32 HighWaterMark = 0;
+};
+
+// Keeps released room actors hidden and collision-free, per class, so the next
+// floor can move them into place instead of spawning new ones. Actors stay owned
+// by the world; the pool holds weak pointers, so a room destroyed while it sits
+// idle (level teardown, gameplay code) is simply skipped on reuse.
+class FDungeonRoomPool
+{
+public:
+  // Idle actors kept per class; anything released beyond that is destroyed
+  void SetMaxPooledPerClass(int32 InMaxPooledPerClass) { MaxPooledPerClass = FMath::Max(0, InMaxPooledPerClass); }
+
+  AActor* Acquire(UWorld* World, TSubclassOf<AActor> RoomClass, const FVector& Location, const FRotator& Rotation, AActor* Owner);
+  void Release(AActor* Room);
+
+  // Spawns idle actors until RoomClass has Count pooled (bounded by the cap)
+  void WarmUp(UWorld* World, TSubclassOf<AActor> RoomClass, int32 Count, AActor* Owner);
+
+  // Destroys every idle actor. Actors in use are left alone.
+  void Empty();
+
+  const FDungeonRoomPoolStats& GetStats() const { return Stats; }
+
+private:
+  static void Deactivate(AActor* Room);
+
+  TMap<UClass*, TArray<TWeakObjectPtr<AActor>>> FreeRooms;
+  FDungeonRoomPoolStats Stats;
+  int32 MaxPooledPerClass = 32;
+};
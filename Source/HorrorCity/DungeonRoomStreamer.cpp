@@ -0,0 +1,138 @@
+// DungeonRoomStreamer.cpp
+#include "DungeonRoomStreamer.h"
+#include "DungeonLayoutStats.h"
+
+void FDungeonRoomStreamer::Reset(const FDungeonGrid& Grid, int32 InChunkSize)
+{
+  Empty();
+
+  const int32 ChunkSize = FMath::Max(1, InChunkSize);
+  ChunkOfIndex.Init(INDEX_NONE, Grid.NumIndices());
+  VisitStamps.Init(0, Grid.NumIndices());
+  Distances.SetNumUninitialized(Grid.NumIndices());
+
+  TMap<FIntPoint, int32> ChunkIds;
+  for (const FIntPoint& Cell : Grid.GetCells())
+  {
+    const FIntPoint ChunkPos(FMath::FloorToInt((float)Cell.X / ChunkSize), FMath::FloorToInt((float)Cell.Y / ChunkSize));
+    int32* Chunk = ChunkIds.Find(ChunkPos);
+    if (!Chunk)
+    {
+      Chunk = &ChunkIds.Add(ChunkPos, ChunkCells.Num());
+      ChunkCells.AddDefaulted();
+    }
+
+    const int32 Index = Grid.ToIndex(Cell);
+    ChunkOfIndex[Index] = *Chunk;
+    ChunkCells[*Chunk].Add(Index);
+  }
+
+  Resident.Init(false, ChunkCells.Num());
+  ChunkDistances.Init(MAX_int32, ChunkCells.Num());
+}
+
+void FDungeonRoomStreamer::Empty()
+{
+  ChunkOfIndex.Reset();
+  ChunkCells.Reset();
+  Resident.Reset();
+  ResidentChunks.Reset();
+  VisitStamps.Reset();
+  CurrentStamp = 0;
+  Distances.Reset();
+  Queue.Reset();
+  ChunkDistances.Reset();
+  TouchedChunks.Reset();
+}
+
+bool FDungeonRoomStreamer::IsResident(int32 GridIndex) const
+{
+  if (!IsActive()) return true;
+  if (!ChunkOfIndex.IsValidIndex(GridIndex) || ChunkOfIndex[GridIndex] == INDEX_NONE) return false;
+  return Resident[ChunkOfIndex[GridIndex]];
+}
+
+bool FDungeonRoomStreamer::Update(const FDungeonGrid& Grid, TArrayView<const FIntPoint> SourceCells, int32 LoadHops, int32 UnloadHops,
+  TArray<int32>& OutLoaded, TArray<int32>& OutUnloaded)
+{
+  OutLoaded.Reset();
+  OutUnloaded.Reset();
+  if (!IsActive()) return false;
+
+  if (++CurrentStamp == 0)
+  {
+    VisitStamps.Init(0, VisitStamps.Num());
+    CurrentStamp = 1;
+  }
+
+  Queue.Reset();
+  for (const FIntPoint& Cell : SourceCells)
+  {
+    if (!Grid.IsOccupied(Cell)) continue;
+
+    const int32 Index = Grid.ToIndex(Cell);
+    if (VisitStamps[Index] != CurrentStamp)
+    {
+      VisitStamps[Index] = CurrentStamp;
+      Distances[Index] = 0;
+      Queue.Add(Index);
+    }
+  }
+  if (Queue.Num() == 0) return false;
+
+  // Breadth-first over doors, stopping at UnloadHops: anything further is dropped
+  // whatever its state, so there is no need to look at it
+  TouchedChunks.Reset();
+  for (int32 Head = 0; Head < Queue.Num(); Head++)
+  {
+    const int32 Index = Queue[Head];
+    const int32 Distance = Distances[Index];
+
+    const int32 Chunk = ChunkOfIndex[Index];
+    if (ChunkDistances[Chunk] == MAX_int32)
+    {
+      TouchedChunks.Add(Chunk);
+    }
+    ChunkDistances[Chunk] = FMath::Min(ChunkDistances[Chunk], Distance);
+
+    if (Distance >= UnloadHops) continue;
+
+    const uint8 Doors = Grid.GetDoors(Index);
+    for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+    {
+      const int32 Neighbour = Grid.Neighbour(Index, Dir);
+      if ((Doors & DungeonDoor::FromIndex(Dir)) && VisitStamps[Neighbour] != CurrentStamp)
+      {
+        VisitStamps[Neighbour] = CurrentStamp;
+        Distances[Neighbour] = Distance + 1;
+        Queue.Add(Neighbour);
+      }
+    }
+  }
+  INC_DWORD_STAT_BY(STAT_DungeonBFSVisits, Queue.Num());
+
+  // Chunks between the two distances keep whatever state they had
+  for (int32 i = ResidentChunks.Num() - 1; i >= 0; i--)
+  {
+    const int32 Chunk = ResidentChunks[i];
+    if (ChunkDistances[Chunk] > UnloadHops)
+    {
+      Resident[Chunk] = false;
+      ResidentChunks.RemoveAtSwap(i, 1, EAllowShrinking::No);
+      OutUnloaded.Add(Chunk);
+    }
+  }
+
+  for (int32 Chunk : TouchedChunks)
+  {
+    if (!Resident[Chunk] && ChunkDistances[Chunk] <= LoadHops)
+    {
+      Resident[Chunk] = true;
+      ResidentChunks.Add(Chunk);
+      OutLoaded.Add(Chunk);
+    }
+    ChunkDistances[Chunk] = MAX_int32;
+  }
+
+  return true;
+}
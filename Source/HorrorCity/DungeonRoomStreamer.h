@@ -0,0 +1,42 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+
+// Decides which parts of a large floor are materialised. The floor is cut into
+// square chunks of cells; a chunk becomes resident when one of its rooms is within
+// LoadHops doors of a player and is dropped only once every room in it is more than
+// UnloadHops away, so a player pacing along a boundary doesn't make rooms flap.
+class FDungeonRoomStreamer
+{
+public:
+  // Partitions the occupied cells of Grid. Nothing is resident until the first Update.
+  void Reset(const FDungeonGrid& Grid, int32 InChunkSize);
+  void Empty();
+
+  // Walks the door graph out from SourceCells and lists the chunks that changed state.
+  // Returns false, changing nothing, if none of the source cells is a room.
+  bool Update(const FDungeonGrid& Grid, TArrayView<const FIntPoint> SourceCells, int32 LoadHops, int32 UnloadHops,
+    TArray<int32>& OutLoaded, TArray<int32>& OutUnloaded);
+
+  bool IsActive() const { return ChunkCells.Num() > 0; }
+
+  // Whether the room at a grid index should exist. Everything does while inactive.
+  bool IsResident(int32 GridIndex) const;
+
+  // Grid indices of the rooms in a chunk
+  const TArray<int32>& GetChunkCells(int32 Chunk) const { return ChunkCells[Chunk]; }
+
+private:
+  TArray<int32> ChunkOfIndex; // Chunk per grid index, INDEX_NONE for empty cells
+  TArray<TArray<int32>> ChunkCells;
+  TArray<bool> Resident;
+  TArray<int32> ResidentChunks;
+
+  // Search scratch. Cells count as visited when their stamp matches the current one.
+  TArray<uint32> VisitStamps;
+  uint32 CurrentStamp = 0;
+  TArray<int32> Distances;
+  TArray<int32> Queue;
+  TArray<int32> ChunkDistances;
+  TArray<int32> TouchedChunks;
+};
@@ -0,0 +1,391 @@
+// DungeonStatsCommandlet.cpp
+#include "DungeonStatsCommandlet.h"
+#include "DungeonCommandletHelpers.h"
+#include "DungeonLayout.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+  constexpr uint32 StatsFileVersion = 1;
+  constexpr int32 RowGroupSize = 65536;
+
+  // Failure modes, one bit each in the flags column
+  namespace EStatsFlag
+  {
+    constexpr uint8 RanOutOfPositions = 1 << 0;
+    constexpr uint8 NoLockedDoor = 1 << 1;
+    constexpr uint8 NoKeyRoom = 1 << 2;
+  }
+
+  // Per worker scratch. The generator keeps its own containers between layouts.
+  struct FStatsWorker
+  {
+    FDungeonLayoutGenerator Generator;
+    TArray<int32> Distances;
+    TArray<int32> Queue;
+  };
+
+  // One row group's results, column by column. Workers fill disjoint rows.
+  struct FStatsRowGroup
+  {
+    TArray<int32> Seed;
+    TArray<int32> Rooms;
+    TArray<int32> DeadEnds;
+    TArray<int32> Loops;
+    TArray<int32> LockedRooms;
+    TArray<int32> AccessibleRooms;
+    TArray<int32> KeyToDoorPath;    // INDEX_NONE without a key room and locked door
+    TArray<int32> MaxDistance;      // Farthest room from the safe room, in doors
+    TArray<int32> NearestEnemy;     // INDEX_NONE without enemies
+    TArray<uint8> Flags;
+
+    void SetNum(int32 Rows)
+    {
+      for (TArray<int32>* Column : { &Seed, &Rooms, &DeadEnds, &Loops, &LockedRooms, &AccessibleRooms, &KeyToDoorPath, &MaxDistance, &NearestEnemy })
+      {
+        Column->SetNumUninitialized(Rows, EAllowShrinking::No);
+      }
+      Flags.SetNumUninitialized(Rows, EAllowShrinking::No);
+    }
+  };
+
+  // Must list the columns in the order WriteRowGroup writes them
+  struct FStatsColumn
+  {
+    const ANSICHAR* Name;
+    uint8 Type;
+  };
+
+  const FStatsColumn StatsColumns[] = {
+    { "seed", 0 }, { "rooms", 0 }, { "dead_ends", 0 }, { "loops", 0 }, { "locked_rooms", 0 },
+    { "accessible_rooms", 0 }, { "key_to_door_path", 0 }, { "max_distance", 0 }, { "nearest_enemy", 0 }, { "flags", 1 }
+  };
+
+  struct FStatsConfig
+  {
+    int32 CellCount = 15;
+    float LoopFraction = 0.3f;
+    float LockedAreaSize = 0.3f;
+    float EnemiesPerRoom = 0.3f;
+  };
+
+  // Running sums for the summary line of one configuration
+  struct FStatsTotals
+  {
+    int64 Layouts = 0;
+    int64 Rooms = 0;
+    int64 DeadEnds = 0;
+    int64 Loops = 0;
+    int64 LockedRooms = 0;
+    int64 KeyToDoorPath = 0;
+    int64 KeyToDoorLayouts = 0;
+    int32 MaxKeyToDoorPath = 0;
+    int64 NearestEnemy = 0;
+    int64 NearestEnemyLayouts = 0;
+    int64 RanOutOfPositions = 0;
+    int64 NoLockedDoor = 0;
+    int64 NoKeyRoom = 0;
+
+    void Add(const FStatsRowGroup& Group)
+    {
+      for (int32 Row = 0; Row < Group.Seed.Num(); Row++)
+      {
+        Layouts++;
+        Rooms += Group.Rooms[Row];
+        DeadEnds += Group.DeadEnds[Row];
+        Loops += Group.Loops[Row];
+        LockedRooms += Group.LockedRooms[Row];
+        if (Group.KeyToDoorPath[Row] != INDEX_NONE)
+        {
+          KeyToDoorPath += Group.KeyToDoorPath[Row];
+          KeyToDoorLayouts++;
+          MaxKeyToDoorPath = FMath::Max(MaxKeyToDoorPath, Group.KeyToDoorPath[Row]);
+        }
+        if (Group.NearestEnemy[Row] != INDEX_NONE)
+        {
+          NearestEnemy += Group.NearestEnemy[Row];
+          NearestEnemyLayouts++;
+        }
+        RanOutOfPositions += (Group.Flags[Row] & EStatsFlag::RanOutOfPositions) ? 1 : 0;
+        NoLockedDoor += (Group.Flags[Row] & EStatsFlag::NoLockedDoor) ? 1 : 0;
+        NoKeyRoom += (Group.Flags[Row] & EStatsFlag::NoKeyRoom) ? 1 : 0;
+      }
+    }
+  };
+
+  double SafeRatio(int64 Numerator, int64 Denominator)
+  {
+    return Denominator > 0 ? (double)Numerator / Denominator : 0.0;
+  }
+
+  // Door hops from the key room to the outer side of the locked door, without crossing it
+  int32 MeasureKeyToDoorPath(const FDungeonLayout& Layout, FStatsWorker& Worker)
+  {
+    if (!Layout.HasKeyRoom() || !Layout.HasLockedDoor()) return INDEX_NONE;
+
+    const FDungeonGrid& Grid = Layout.GetGrid();
+    const int32 Target = Grid.ToIndex(Layout.GetLockedDoorNeighbour());
+    const int32 LockedSide = Grid.ToIndex(Layout.GetLockedDoorRoom());
+
+    TArray<int32>& Distances = Worker.Distances;
+    TArray<int32>& Queue = Worker.Queue;
+    Distances.Init(INDEX_NONE, Grid.NumIndices());
+    Queue.Reset();
+
+    const int32 Start = Grid.ToIndex(Layout.GetKeyRoom());
+    Distances[Start] = 0;
+    Queue.Add(Start);
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+      const int32 Current = Queue[Head];
+      if (Current == Target) return Distances[Current];
+
+      const uint8 Doors = Grid.GetDoors(Current);
+      for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+      {
+        const int32 Neighbour = Grid.Neighbour(Current, Dir);
+        if ((Doors & DungeonDoor::FromIndex(Dir)) && Neighbour != LockedSide && Distances[Neighbour] == INDEX_NONE)
+        {
+          Distances[Neighbour] = Distances[Current] + 1;
+          Queue.Add(Neighbour);
+        }
+      }
+    }
+    return INDEX_NONE;
+  }
+
+  // Independent cycles in the door graph: doors - rooms + connected components
+  int32 CountLoops(const FDungeonLayout& Layout, FStatsWorker& Worker)
+  {
+    const FDungeonGrid& Grid = Layout.GetGrid();
+    TArray<int32>& Visited = Worker.Distances;
+    TArray<int32>& Queue = Worker.Queue;
+    Visited.Init(0, Grid.NumIndices());
+
+    int32 DoorEnds = 0;
+    int32 Components = 0;
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      const int32 Start = Grid.ToIndex(Cell);
+      DoorEnds += FMath::CountBits(Grid.GetDoors(Start));
+      if (Visited[Start]) continue;
+
+      Components++;
+      Visited[Start] = 1;
+      Queue.Reset();
+      Queue.Add(Start);
+      for (int32 Head = 0; Head < Queue.Num(); Head++)
+      {
+        const uint8 Doors = Grid.GetDoors(Queue[Head]);
+        for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+        {
+          const int32 Neighbour = Grid.Neighbour(Queue[Head], Dir);
+          if ((Doors & DungeonDoor::FromIndex(Dir)) && !Visited[Neighbour])
+          {
+            Visited[Neighbour] = 1;
+            Queue.Add(Neighbour);
+          }
+        }
+      }
+    }
+    return DoorEnds / 2 - Grid.NumCells() + Components;
+  }
+
+  void MeasureLayout(const FDungeonLayout& Layout, int32 Seed, FStatsWorker& Worker, FStatsRowGroup& Group, int32 Row)
+  {
+    const FDungeonGrid& Grid = Layout.GetGrid();
+
+    int32 DeadEnds = 0;
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      DeadEnds += FMath::CountBits(Grid.GetDoors(Cell)) == 1 ? 1 : 0;
+    }
+
+    int32 NearestEnemy = INDEX_NONE;
+    for (const FIntPoint& Slot : Layout.GetEnemySlots())
+    {
+      const int32 Distance = Layout.GetSafeRoomDistance(Slot);
+      if (Distance != INDEX_NONE && (NearestEnemy == INDEX_NONE || Distance < NearestEnemy))
+      {
+        NearestEnemy = Distance;
+      }
+    }
+
+    uint8 Flags = 0;
+    Flags |= Layout.RanOutOfPositions() ? EStatsFlag::RanOutOfPositions : 0;
+    Flags |= Layout.HasLockedDoor() ? 0 : EStatsFlag::NoLockedDoor;
+    Flags |= Layout.HasKeyRoom() ? 0 : EStatsFlag::NoKeyRoom;
+
+    Group.Seed[Row] = Seed;
+    Group.Rooms[Row] = Grid.NumCells();
+    Group.DeadEnds[Row] = DeadEnds;
+    Group.Loops[Row] = CountLoops(Layout, Worker);
+    Group.LockedRooms[Row] = Layout.GetLockedRoomCount();
+    Group.AccessibleRooms[Row] = Layout.GetAccessibleRoomCount();
+    Group.KeyToDoorPath[Row] = MeasureKeyToDoorPath(Layout, Worker);
+    Group.MaxDistance[Row] = Layout.GetMaxSafeRoomDistance();
+    Group.NearestEnemy[Row] = NearestEnemy;
+    Group.Flags[Row] = Flags;
+  }
+
+  template<typename T>
+  void WriteColumn(FArchive& Ar, const TArray<T>& Column)
+  {
+    Ar.Serialize((void*)Column.GetData(), Column.Num() * sizeof(T));
+  }
+
+  void WriteHeader(FArchive& Ar)
+  {
+    ANSICHAR Magic[4] = { 'D', 'G', 'S', 'T' };
+    Ar.Serialize(Magic, sizeof(Magic));
+
+    uint32 Version = StatsFileVersion;
+    uint32 ColumnCount = UE_ARRAY_COUNT(StatsColumns);
+    Ar << Version;
+    Ar << ColumnCount;
+
+    for (const FStatsColumn& Column : StatsColumns)
+    {
+      uint8 Type = Column.Type;
+      uint8 NameLength = (uint8)FCStringAnsi::Strlen(Column.Name);
+      Ar << Type;
+      Ar << NameLength;
+      Ar.Serialize((void*)Column.Name, NameLength);
+    }
+  }
+
+  void WriteRowGroup(FArchive& Ar, const FStatsConfig& Config, const FStatsRowGroup& Group)
+  {
+    int32 CellCount = Config.CellCount;
+    float LoopFraction = Config.LoopFraction;
+    float LockedAreaSize = Config.LockedAreaSize;
+    float EnemiesPerRoom = Config.EnemiesPerRoom;
+    uint32 Rows = Group.Seed.Num();
+    Ar << CellCount;
+    Ar << LoopFraction;
+    Ar << LockedAreaSize;
+    Ar << EnemiesPerRoom;
+    Ar << Rows;
+
+    WriteColumn(Ar, Group.Seed);
+    WriteColumn(Ar, Group.Rooms);
+    WriteColumn(Ar, Group.DeadEnds);
+    WriteColumn(Ar, Group.Loops);
+    WriteColumn(Ar, Group.LockedRooms);
+    WriteColumn(Ar, Group.AccessibleRooms);
+    WriteColumn(Ar, Group.KeyToDoorPath);
+    WriteColumn(Ar, Group.MaxDistance);
+    WriteColumn(Ar, Group.NearestEnemy);
+    WriteColumn(Ar, Group.Flags);
+  }
+}
+
+UDungeonStatsCommandlet::UDungeonStatsCommandlet()
+{
+  IsClient = false;
+  IsServer = false;
+  IsEditor = false;
+  LogToConsole = true;
+}
+
+int32 UDungeonStatsCommandlet::Main(const FString& Params)
+{
+  const TArray<int32> CellCounts = DungeonCommandlet::ParseList<int32>(Params, TEXT("CellCounts="), { 15, 30, 60, 100 });
+  const TArray<float> LoopFractions = DungeonCommandlet::ParseList<float>(Params, TEXT("LoopFractions="), { 0.0f, 0.15f, 0.3f, 0.45f, 0.6f });
+  const TArray<float> LockedAreaSizes = DungeonCommandlet::ParseList<float>(Params, TEXT("LockedAreaSizes="), { 0.2f, 0.3f, 0.4f, 0.5f });
+  const TArray<float> EnemiesPerRoomValues = DungeonCommandlet::ParseList<float>(Params, TEXT("EnemiesPerRoom="), { 0.3f });
+
+  int32 LayoutsPerConfig = 100000;
+  int32 BaseSeed = 0;
+  FParse::Value(*Params, TEXT("Layouts="), LayoutsPerConfig);
+  FParse::Value(*Params, TEXT("Seed="), BaseSeed);
+  LayoutsPerConfig = FMath::Max(LayoutsPerConfig, 1);
+
+  FString OutputBase;
+  if (!FParse::Value(*Params, TEXT("Output="), OutputBase))
+  {
+    OutputBase = FPaths::ProjectSavedDir() / TEXT("DungeonStats") / FString::Printf(TEXT("DungeonStats-%s"), *FDateTime::Now().ToString());
+  }
+
+  const FString DataPath = OutputBase + TEXT(".dgst");
+  TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*DataPath));
+  if (!Writer)
+  {
+    UE_LOG(LogTemp, Error, TEXT("Could not open %s for writing"), *DataPath);
+    return 1;
+  }
+  WriteHeader(*Writer);
+
+  FString Summary = TEXT("cell_count,loop_fraction,locked_area_size,enemies_per_room,layouts,mean_rooms,dead_end_ratio,mean_loops,")
+    TEXT("locked_share,mean_key_to_door_path,max_key_to_door_path,mean_nearest_enemy,ran_out_of_positions,no_locked_door,no_key_room\n");
+
+  TArray<FStatsWorker> Workers;
+  FStatsRowGroup Group;
+  const double StartTime = FPlatformTime::Seconds();
+
+  for (int32 CellCount : CellCounts)
+  {
+    for (float LoopFraction : LoopFractions)
+    {
+      for (float LockedAreaSize : LockedAreaSizes)
+      {
+        for (float EnemiesPerRoom : EnemiesPerRoomValues)
+        {
+          FStatsConfig Config;
+          Config.CellCount = CellCount;
+          Config.LoopFraction = LoopFraction;
+          Config.LockedAreaSize = LockedAreaSize;
+          Config.EnemiesPerRoom = EnemiesPerRoom;
+
+          FDungeonLayoutParams LayoutParams;
+          LayoutParams.CellCount = CellCount;
+          LayoutParams.EnemyCount = (int32)(CellCount * EnemiesPerRoom);
+          LayoutParams.LoopFraction = LoopFraction;
+          LayoutParams.LockedAreaSizePercent = LockedAreaSize;
+
+          // Every configuration sees the same seeds, so rows compare pairwise
+          FStatsTotals Totals;
+          for (int32 First = 0; First < LayoutsPerConfig; First += RowGroupSize)
+          {
+            const int32 Rows = FMath::Min(RowGroupSize, LayoutsPerConfig - First);
+            Group.SetNum(Rows);
+
+            ParallelForWithTaskContext(Workers, Rows, [&LayoutParams, &Group, BaseSeed, First](FStatsWorker& Worker, int32 Row)
+              {
+                FDungeonLayoutParams WorkerParams = LayoutParams;
+                WorkerParams.Seed = FDungeonLayoutGenerator::MixSeed(BaseSeed, (uint32)(First + Row));
+                const FDungeonLayout Layout = Worker.Generator.Generate(WorkerParams);
+                MeasureLayout(Layout, WorkerParams.Seed, Worker, Group, Row);
+              });
+
+            WriteRowGroup(*Writer, Config, Group);
+            Totals.Add(Group);
+          }
+
+          Summary += FString::Printf(TEXT("%d,%.3f,%.3f,%.3f,%lld,%.2f,%.4f,%.3f,%.4f,%.3f,%d,%.3f,%lld,%lld,%lld\n"),
+            CellCount, LoopFraction, LockedAreaSize, EnemiesPerRoom, Totals.Layouts,
+            SafeRatio(Totals.Rooms, Totals.Layouts), SafeRatio(Totals.DeadEnds, Totals.Rooms), SafeRatio(Totals.Loops, Totals.Layouts),
+            SafeRatio(Totals.LockedRooms, Totals.Rooms), SafeRatio(Totals.KeyToDoorPath, Totals.KeyToDoorLayouts), Totals.MaxKeyToDoorPath,
+            SafeRatio(Totals.NearestEnemy, Totals.NearestEnemyLayouts), Totals.RanOutOfPositions, Totals.NoLockedDoor, Totals.NoKeyRoom);
+
+          UE_LOG(LogTemp, Display, TEXT("CellCount %d, LoopFraction %.2f, LockedAreaSize %.2f, EnemiesPerRoom %.2f: %lld layouts, %lld ran out of positions"),
+            CellCount, LoopFraction, LockedAreaSize, EnemiesPerRoom, Totals.Layouts, Totals.RanOutOfPositions);
+        }
+      }
+    }
+  }
+
+  const bool bWritten = Writer->Close();
+  const FString SummaryPath = OutputBase + TEXT(".csv");
+  if (!bWritten || !FFileHelper::SaveStringToFile(Summary, *SummaryPath))
+  {
+    UE_LOG(LogTemp, Error, TEXT("Failed to write layout statistics to %s"), *OutputBase);
+    return 1;
+  }
+
+  UE_LOG(LogTemp, Display, TEXT("Wrote %s and %s in %.1f s"), *DataPath, *SummaryPath, FPlatformTime::Seconds() - StartTime);
+  return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonStatsCommandlet.generated.h"
+
+// Generates large batches of seeded layouts on every core and reports what the
+// design parameters actually produce: dead ends, loops, locked area size, key to
+// door distance and how often generation falls short. Runs headless, e.g. on Linux:
+//
+//   UnrealEditor-Cmd HorrorCity.uproject -run=DungeonStats -unattended -nullrhi
+//     [-CellCounts=15,30] [-LoopFractions=0,0.3] [-LockedAreaSizes=0.2,0.3]
+//     [-EnemiesPerRoom=0.3] [-Layouts=1000000] [-Seed=0] [-Output=Path/Without/Extension]
+//
+// Per layout rows stream to <Output>.dgst as they are produced, column by column in
+// row groups. Little endian:
+//   header:    "DGST", uint32 version, uint32 column count,
+//              per column: uint8 type (0 int32, 1 uint8), uint8 name length, name
+//   row group: int32 cell count, float loop fraction, float locked area size,
+//              float enemies per room, uint32 rows, then each column's rows in turn
+// Per configuration averages go to <Output>.csv.
+UCLASS()
+class HORRORCITY_API UDungeonStatsCommandlet : public UCommandlet
+{
+  GENERATED_BODY()
+
+public:
+  UDungeonStatsCommandlet();
+
+  virtual int32 Main(const FString& Params) override;
+};
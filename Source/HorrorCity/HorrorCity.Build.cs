@@ -12,7 +12,9 @@ public class HorrorCity : ModuleRules
 				"Engine",
 				"InputCore",
 				"NavigationSystem",  // Add this
-				"AIModule"           // Add this if using AI
+				"Navmesh",
+				"AIModule",          // Add this if using AI
+				"DungeonLayout"
 		});
 				PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
@@ -0,0 +1,29 @@
+// CoreMinimal.cpp
+#include "CoreMinimal.h"
+#include <chrono>
+#include <cstdio>
+
+namespace DungeonCoreShim
+{
+  void CheckFailed(const char* Expr, const char* File, int32 Line)
+  {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", File, Line, Expr);
+    std::abort();
+  }
+}
+
+void* FMemory::Malloc(SIZE_T Count, SIZE_T Alignment)
+{
+  Alignment = FMath::Max<SIZE_T>(Alignment, 16);
+  return std::aligned_alloc(Alignment, Align(FMath::Max<SIZE_T>(Count, 1), Alignment));
+}
+
+void FMemory::Free(void* Original)
+{
+  std::free(Original);
+}
+
+double FPlatformTime::Seconds()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
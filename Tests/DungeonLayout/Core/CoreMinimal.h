@@ -0,0 +1,340 @@
+#pragma once
+
+// Stand-ins for the slice of Unreal's Core module that the DungeonLayout sources use,
+// so the module builds as plain C++ for its tests and benchmark. Only what those
+// sources call is here. Anything that feeds a layout (FRandomStream, FMath rounding)
+// follows the engine's implementation exactly, so seeds give the same floors as in game.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef size_t SIZE_T;
+
+// The host is narrow-character throughout, so instruction set names print directly
+typedef char TCHAR;
+#define TEXT(Text) Text
+
+#define FORCEINLINE inline
+#define INDEX_NONE (-1)
+#define MAX_int32 0x7fffffff
+#define UE_ARRAY_COUNT(Array) (sizeof(Array) / sizeof((Array)[0]))
+#define MoveTemp std::move
+#define PLATFORM_CACHE_LINE_SIZE 64
+
+// Slow guards follow the build type unless the build sets them
+#ifndef DO_GUARD_SLOW
+#ifdef NDEBUG
+#define DO_GUARD_SLOW 0
+#else
+#define DO_GUARD_SLOW 1
+#endif
+#endif
+
+// check stays on in every configuration, as the tests rely on it; checkSlow only with slow guards
+#define check(Expr) ((Expr) ? (void)0 : DungeonCoreShim::CheckFailed(#Expr, __FILE__, __LINE__))
+#if DO_GUARD_SLOW
+#define checkSlow(Expr) check(Expr)
+#else
+#define checkSlow(Expr) ((void)0)
+#endif
+
+#define UE_LOG(Category, Verbosity, Format, ...) ((void)0)
+
+// Target features come from the compiler, as the engine's platform headers do
+#if defined(__x86_64__) || defined(_M_X64)
+#ifndef PLATFORM_CPU_X86_FAMILY
+#define PLATFORM_CPU_X86_FAMILY 1
+#endif
+#define PLATFORM_CPU_ARM_FAMILY 0
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PLATFORM_CPU_X86_FAMILY 0
+#define PLATFORM_CPU_ARM_FAMILY 1
+#else
+#define PLATFORM_CPU_X86_FAMILY 0
+#define PLATFORM_CPU_ARM_FAMILY 0
+#endif
+
+#ifndef PLATFORM_ALWAYS_HAS_AVX_2
+#if defined(__AVX2__) && PLATFORM_CPU_X86_FAMILY
+#define PLATFORM_ALWAYS_HAS_AVX_2 1
+#else
+#define PLATFORM_ALWAYS_HAS_AVX_2 0
+#endif
+#endif
+
+#ifndef PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#define PLATFORM_ENABLE_VECTORINTRINSICS_NEON PLATFORM_CPU_ARM_FAMILY
+#endif
+
+namespace DungeonCoreShim
+{
+  [[noreturn]] void CheckFailed(const char* Expr, const char* File, int32 Line);
+}
+
+enum class EAllowShrinking : uint8
+{
+  No,
+  Yes
+};
+
+struct FIntPoint
+{
+  int32 X = 0;
+  int32 Y = 0;
+
+  static const FIntPoint ZeroValue;
+
+  constexpr FIntPoint() = default;
+  constexpr FIntPoint(int32 InX, int32 InY) : X(InX), Y(InY) {}
+
+  constexpr FIntPoint operator+(const FIntPoint& Other) const { return FIntPoint(X + Other.X, Y + Other.Y); }
+  constexpr FIntPoint operator-(const FIntPoint& Other) const { return FIntPoint(X - Other.X, Y - Other.Y); }
+  FIntPoint& operator+=(const FIntPoint& Other)
+  {
+    X += Other.X;
+    Y += Other.Y;
+    return *this;
+  }
+  constexpr bool operator==(const FIntPoint& Other) const { return X == Other.X && Y == Other.Y; }
+  constexpr bool operator!=(const FIntPoint& Other) const { return !(*this == Other); }
+};
+
+inline constexpr FIntPoint FIntPoint::ZeroValue(0, 0);
+
+struct FMath
+{
+  template <typename T> static constexpr T Max(T A, T B) { return A > B ? A : B; }
+  template <typename T> static constexpr T Min(T A, T B) { return A < B ? A : B; }
+  template <typename T> static constexpr T Max3(T A, T B, T C) { return Max(Max(A, B), C); }
+  template <typename T> static constexpr T Abs(T A) { return A < 0 ? -A : A; }
+  template <typename T> static constexpr T Clamp(T Value, T Low, T High) { return Value < Low ? Low : (Value > High ? High : Value); }
+
+  static bool IsFinite(float Value) { return std::isfinite(Value); }
+  static float Sqrt(float Value) { return std::sqrt(Value); }
+  static int32 CeilToInt(float Value) { return (int32)std::ceil(Value); }
+  static int32 FloorToInt(float Value) { return (int32)std::floor(Value); }
+  // The engine rounds halves up, not away from zero
+  static int32 RoundToInt(float Value) { return FloorToInt(Value + 0.5f); }
+
+  static uint32 CountBits(uint64 Bits) { return (uint32)__builtin_popcountll(Bits); }
+  static uint32 CountTrailingZeros(uint32 Value) { return Value == 0 ? 32 : (uint32)__builtin_ctz(Value); }
+  static uint64 CountTrailingZeros64(uint64 Value) { return Value == 0 ? 64 : (uint64)__builtin_ctzll(Value); }
+  static uint32 RoundUpToPowerOfTwo(uint32 Value) { return Value <= 1 ? 1 : 1u << (32 - __builtin_clz(Value - 1)); }
+};
+
+template <typename T>
+constexpr T Align(T Value, uint64 Alignment)
+{
+  return (T)(((uint64)Value + Alignment - 1) & ~(Alignment - 1));
+}
+
+template <typename T>
+void Swap(T& A, T& B)
+{
+  std::swap(A, B);
+}
+
+struct FMemory
+{
+  static void* Memcpy(void* Dest, const void* Src, SIZE_T Count) { return std::memcpy(Dest, Src, Count); }
+  static void* Memzero(void* Dest, SIZE_T Count) { return std::memset(Dest, 0, Count); }
+  template <typename T> static void Memzero(T& Value) { std::memset(&Value, 0, sizeof(T)); }
+  static void* Malloc(SIZE_T Count, SIZE_T Alignment = 16);
+  static void Free(void* Original);
+};
+
+struct FPlatformTime
+{
+  static double Seconds();
+};
+
+// The engine's linear congruential stream, draw for draw
+class FRandomStream
+{
+public:
+  FRandomStream() = default;
+  explicit FRandomStream(int32 InSeed) { Initialize(InSeed); }
+
+  void Initialize(int32 InSeed)
+  {
+    InitialSeed = InSeed;
+    Seed = (uint32)InSeed;
+  }
+
+  void Reset() const { Seed = (uint32)InitialSeed; }
+  int32 GetInitialSeed() const { return InitialSeed; }
+  int32 GetCurrentSeed() const { return (int32)Seed; }
+
+  float GetFraction() const
+  {
+    MutateSeed();
+    const uint32 Bits = 0x3F800000U | (Seed >> 9);
+    float Result;
+    std::memcpy(&Result, &Bits, sizeof(Result));
+    return Result - 1.0f;
+  }
+
+  float FRand() const { return GetFraction(); }
+
+  uint32 GetUnsignedInt() const
+  {
+    MutateSeed();
+    return Seed;
+  }
+
+  int32 RandHelper(int32 A) const
+  {
+    return A > 0 ? FMath::Min((int32)std::trunc(GetFraction() * (float)A), A - 1) : 0;
+  }
+
+  int32 RandRange(int32 Min, int32 Max) const
+  {
+    const int32 Range = (Max - Min) + 1;
+    return Min + RandHelper(Range);
+  }
+
+private:
+  void MutateSeed() const { Seed = (Seed * 196314165U) + 907633515U; }
+
+  int32 InitialSeed = 0;
+  mutable uint32 Seed = 0;
+};
+
+template <int32 NumInlineElements>
+class TInlineAllocator
+{
+};
+
+class FDefaultAllocator
+{
+};
+
+// Heap array with TArray's interface. The allocator parameter is accepted and ignored.
+template <typename ElementType, typename AllocatorType = FDefaultAllocator>
+class TArray
+{
+public:
+  TArray() = default;
+  TArray(std::initializer_list<ElementType> Elements) : Storage(Elements) {}
+
+  int32 Num() const { return (int32)Storage.size(); }
+  bool IsEmpty() const { return Storage.empty(); }
+  bool IsValidIndex(int32 Index) const { return Index >= 0 && Index < Num(); }
+
+  ElementType& operator[](int32 Index)
+  {
+    check(IsValidIndex(Index));
+    return Storage[Index];
+  }
+  const ElementType& operator[](int32 Index) const
+  {
+    check(IsValidIndex(Index));
+    return Storage[Index];
+  }
+
+  ElementType& Last(int32 IndexFromEnd = 0) { return (*this)[Num() - 1 - IndexFromEnd]; }
+  const ElementType& Last(int32 IndexFromEnd = 0) const { return (*this)[Num() - 1 - IndexFromEnd]; }
+  ElementType* GetData() { return Storage.data(); }
+  const ElementType* GetData() const { return Storage.data(); }
+
+  int32 Add(const ElementType& Element)
+  {
+    Storage.push_back(Element);
+    return Num() - 1;
+  }
+
+  int32 AddZeroed(int32 Count = 1)
+  {
+    const int32 Index = Num();
+    Storage.resize(Storage.size() + Count);
+    return Index;
+  }
+
+  ElementType Pop(EAllowShrinking = EAllowShrinking::Yes)
+  {
+    ElementType Element = Last();
+    Storage.pop_back();
+    return Element;
+  }
+
+  void RemoveAtSwap(int32 Index, int32 Count = 1, EAllowShrinking = EAllowShrinking::Yes)
+  {
+    for (int32 i = 0; i < Count; i++)
+    {
+      Storage[Index + i] = Storage.back();
+      Storage.pop_back();
+    }
+  }
+
+  void Init(const ElementType& Element, int32 Count) { Storage.assign(Count, Element); }
+  void SetNum(int32 Count) { Storage.resize(Count); }
+  void SetNumUninitialized(int32 Count) { Storage.resize(Count); }
+  void Reserve(int32 Count) { Storage.reserve(Count); }
+
+  void Reset(int32 Slack = 0)
+  {
+    Storage.clear();
+    Storage.reserve(Slack);
+  }
+
+  void Empty(int32 Slack = 0)
+  {
+    std::vector<ElementType>().swap(Storage);
+    Storage.reserve(Slack);
+  }
+
+  template <typename PredicateType>
+  void StableSort(PredicateType Predicate) { std::stable_sort(Storage.begin(), Storage.end(), Predicate); }
+
+  bool operator==(const TArray& Other) const { return Storage == Other.Storage; }
+  bool operator!=(const TArray& Other) const { return Storage != Other.Storage; }
+
+  ElementType* begin() { return Storage.data(); }
+  ElementType* end() { return Storage.data() + Storage.size(); }
+  const ElementType* begin() const { return Storage.data(); }
+  const ElementType* end() const { return Storage.data() + Storage.size(); }
+
+private:
+  std::vector<ElementType> Storage;
+};
+
+template <typename ElementType>
+class TArrayView
+{
+public:
+  TArrayView() = default;
+  TArrayView(ElementType* InData, int32 InNum) : Data(InData), Count(InNum) {}
+
+  template <typename OtherElementType, typename AllocatorType>
+  TArrayView(const TArray<OtherElementType, AllocatorType>& Array) : Data(Array.GetData()), Count(Array.Num()) {}
+
+  TArrayView(std::initializer_list<std::remove_const_t<ElementType>> Elements) : Data(Elements.begin()), Count((int32)Elements.size()) {}
+
+  int32 Num() const { return Count; }
+  ElementType* GetData() const { return Data; }
+  ElementType& operator[](int32 Index) const
+  {
+    check(Index >= 0 && Index < Count);
+    return Data[Index];
+  }
+  ElementType* begin() const { return Data; }
+  ElementType* end() const { return Data + Count; }
+
+private:
+  ElementType* Data = nullptr;
+  int32 Count = 0;
+};
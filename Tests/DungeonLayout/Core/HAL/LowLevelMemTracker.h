@@ -0,0 +1,6 @@
+#pragma once
+
+// No memory tracking in the host build
+#define LLM_DECLARE_TAG_API(Tag, Api)
+#define LLM_DEFINE_TAG(Tag)
+#define LLM_SCOPE_BYTAG(Tag)
@@ -0,0 +1,29 @@
+#pragma once
+#include <utility>
+
+namespace DungeonCoreShim
+{
+  template <typename FuncType>
+  class TScopeGuard
+  {
+  public:
+    explicit TScopeGuard(FuncType&& InFunc) : Func(std::move(InFunc)) {}
+    ~TScopeGuard() { Func(); }
+
+    TScopeGuard(const TScopeGuard&) = delete;
+    TScopeGuard& operator=(const TScopeGuard&) = delete;
+
+  private:
+    FuncType Func;
+  };
+
+  struct FScopeGuardSyntaxSupport
+  {
+    template <typename FuncType>
+    TScopeGuard<FuncType> operator+(FuncType&& Func) { return TScopeGuard<FuncType>(std::forward<FuncType>(Func)); }
+  };
+}
+
+#define DUNGEON_SCOPE_GUARD_JOIN_INNER(A, B) A##B
+#define DUNGEON_SCOPE_GUARD_JOIN(A, B) DUNGEON_SCOPE_GUARD_JOIN_INNER(A, B)
+#define ON_SCOPE_EXIT const auto DUNGEON_SCOPE_GUARD_JOIN(ScopeGuard_, __LINE__) = DungeonCoreShim::FScopeGuardSyntaxSupport() + [&]()
@@ -0,0 +1,11 @@
+#pragma once
+
+// Stats compile out of the host build, as they do in shipping builds
+#define DECLARE_STATS_GROUP(GroupDesc, GroupId, GroupCat)
+#define DECLARE_CYCLE_STAT(CounterName, StatId, GroupId)
+#define DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(CounterName, StatId, GroupId, Api)
+#define DECLARE_DWORD_COUNTER_STAT_EXTERN(CounterName, StatId, GroupId, Api)
+#define DEFINE_STAT(Stat)
+#define SCOPE_CYCLE_COUNTER(Stat)
+#define INC_DWORD_STAT_BY(Stat, Amount)
+#define SET_DWORD_STAT(Stat, Value)
@@ -0,0 +1,136 @@
+// DungeonAliasTableTests.cpp
+#include "DungeonTestHarness.h"
+#include "DungeonAliasTable.h"
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  constexpr int32 NumDraws = 200000;
+
+  // Draws NumDraws times and checks every index comes up in proportion to its weight,
+  // within five standard deviations, and that undrawable weights never do
+  bool MatchesWeights(const FDungeonAliasTable& Table, const TArray<float>& Weights, FRandomStream& Stream)
+  {
+    double Total = 0.0;
+    for (float Weight : Weights)
+    {
+      Total += Weight > 0.0f && FMath::IsFinite(Weight) ? Weight : 0.0f;
+    }
+
+    TArray<int32> Counts;
+    Counts.Init(0, Weights.Num());
+    for (int32 Draw = 0; Draw < NumDraws; Draw++)
+    {
+      const int32 Index = Table.Sample(Stream);
+      if (!Counts.IsValidIndex(Index)) return false;
+      Counts[Index]++;
+    }
+
+    for (int32 i = 0; i < Weights.Num(); i++)
+    {
+      const bool bDrawable = Weights[i] > 0.0f && FMath::IsFinite(Weights[i]);
+      if (!bDrawable)
+      {
+        if (Counts[i] > 0) return false;
+        continue;
+      }
+
+      const double Expected = NumDraws * Weights[i] / Total;
+      const double Sigma = std::sqrt(Expected * (1.0 - Weights[i] / Total));
+      if (std::abs(Counts[i] - Expected) > 5.0 * Sigma + 1.0) return false;
+    }
+    return true;
+  }
+}
+
+DUNGEON_TEST(AliasTableDrawsInProportion)
+{
+  FRandomStream Stream = DungeonTest::MakeStream("AliasTableDrawsInProportion");
+  const float NaN = std::numeric_limits<float>::quiet_NaN();
+  const float Infinity = std::numeric_limits<float>::infinity();
+
+  const TArray<float> WeightSets[] = {
+    { 1.0f },
+    { 1.0f, 1.0f, 1.0f, 1.0f },
+    { 1.0f, 0.0f, 3.0f, 0.5f, 5.5f },
+    { 0.0f, -2.0f, 4.0f, NaN, 0.01f, Infinity, 1.0f },
+    { 1000.0f, 0.001f, 1.0f },
+  };
+  for (const TArray<float>& Weights : WeightSets)
+  {
+    FDungeonAliasTable Table;
+    Table.Build(Weights);
+    EXPECT(!Table.IsEmpty());
+    EXPECTF(MatchesWeights(Table, Weights, Stream), "%d weights", Weights.Num());
+  }
+
+  // Random weights, a quarter of them zero
+  for (int32 Round = 0; Round < 20; Round++)
+  {
+    TArray<float> Weights;
+    const int32 Num = Stream.RandRange(2, 40);
+    for (int32 i = 0; i < Num; i++)
+    {
+      Weights.Add(Stream.FRand() < 0.25f ? 0.0f : Stream.FRand() * 10.0f);
+    }
+    Weights[Stream.RandRange(0, Num - 1)] = 1.0f;
+
+    FDungeonAliasTable Table;
+    Table.Build(Weights);
+    EXPECTF(MatchesWeights(Table, Weights, Stream), "round %d", Round);
+  }
+}
+
+DUNGEON_TEST(AliasTableWithNothingDrawableIsEmpty)
+{
+  const float NaN = std::numeric_limits<float>::quiet_NaN();
+
+  FDungeonAliasTable Table;
+  Table.Build(TArray<float>());
+  EXPECT(Table.IsEmpty());
+  Table.Build(TArray<float>{ 0.0f, 0.0f, 0.0f });
+  EXPECT(Table.IsEmpty());
+  Table.Build(TArray<float>{ 0.0f, -1.0f, NaN });
+  EXPECT(Table.IsEmpty());
+
+  // A rebuild drops what the table held before
+  Table.Build(TArray<float>{ 2.0f });
+  EXPECT(!Table.IsEmpty());
+  Table.Build(TArray<float>{ 0.0f });
+  EXPECT(Table.IsEmpty());
+}
+
+// The room catalog keeps, per variant, a table built with that variant's weight zeroed,
+// and draws from it to avoid repeating the last variant. Built the same way here.
+DUNGEON_TEST(AliasTableWithoutVariantNeverRepeats)
+{
+  FRandomStream Stream = DungeonTest::MakeStream("AliasTableWithoutVariantNeverRepeats");
+
+  const TArray<float> WeightSets[] = {
+    { 1.0f, 2.0f },
+    { 3.0f, 1.0f, 0.0f, 0.5f },
+    { 0.0f, 1.0f, 1.0f, 1.0f, 8.0f },
+  };
+  for (const TArray<float>& Weights : WeightSets)
+  {
+    for (int32 Variant = 0; Variant < Weights.Num(); Variant++)
+    {
+      TArray<float> Without = Weights;
+      Without[Variant] = 0.0f;
+
+      FDungeonAliasTable Table;
+      Table.Build(Without);
+      EXPECT(!Table.IsEmpty());
+      EXPECTF(MatchesWeights(Table, Without, Stream), "%d weights without variant %d", Weights.Num(), Variant);
+    }
+  }
+
+  // A shape with one drawable variant has nothing else to pick, so that variant's table
+  // is empty and the catalog falls back to repeating it
+  TArray<float> Without = { 0.0f, 4.0f, 0.0f };
+  Without[1] = 0.0f;
+  FDungeonAliasTable Table;
+  Table.Build(Without);
+  EXPECT(Table.IsEmpty());
+}
@@ -0,0 +1,121 @@
+// DungeonArticulationTests.cpp
+#include "DungeonTestHarness.h"
+#include "DungeonArticulation.h"
+#include "DungeonGrid.h"
+
+namespace
+{
+  // Connected floor of NumRooms cells grown from the origin along a random tree, plus
+  // a share of the remaining adjacent pairs joined to close loops
+  void MakeRandomFloor(FDungeonGrid& Grid, int32 NumRooms, float LoopDoorChance, FRandomStream& Stream)
+  {
+    Grid.Reset(FIntPoint(-2, -2), 4, 4);
+    Grid.Occupy(FIntPoint(0, 0));
+    while (Grid.NumCells() < NumRooms)
+    {
+      const FIntPoint From = Grid.GetCells()[Stream.RandRange(0, Grid.NumCells() - 1)];
+      const FIntPoint To = From + DungeonDoor::Offsets[Stream.RandRange(0, DungeonDoor::NumDirections - 1)];
+      if (Grid.IsOccupied(To)) continue;
+
+      Grid.Occupy(To);
+      Grid.Connect(From, To);
+    }
+
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      for (const FIntPoint& Offset : { FIntPoint(1, 0), FIntPoint(0, 1) })
+      {
+        if (Grid.IsOccupied(Cell + Offset) && Stream.FRand() < LoopDoorChance)
+        {
+          Grid.Connect(Cell, Cell + Offset);
+        }
+      }
+    }
+  }
+
+  // Whether every unlocked cell but Candidate is reachable from Root once Candidate is
+  // locked, by a fresh flood fill
+  bool CanLockByFloodFill(FDungeonGrid& Grid, int32 Root, int32 Candidate)
+  {
+    TArray<uint8> Reached;
+    Reached.Init(0, Grid.NumIndices());
+    TArray<int32> Queue;
+    if (Root != Candidate && !Grid.HasFlag(Root, DungeonCell::Locked))
+    {
+      Reached[Root] = 1;
+      Queue.Add(Root);
+    }
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+      for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+      {
+        const int32 Next = Grid.Neighbour(Queue[Head], Dir);
+        if (!(Grid.GetDoors(Queue[Head]) & DungeonDoor::FromIndex(Dir)) || Next == Candidate ||
+          Grid.HasFlag(Next, DungeonCell::Locked) || Reached[Next]) continue;
+
+        Reached[Next] = 1;
+        Queue.Add(Next);
+      }
+    }
+
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      const int32 Index = Grid.ToIndex(Cell);
+      if (Index != Candidate && !Grid.HasFlag(Index, DungeonCell::Locked) && !Reached[Index]) return false;
+    }
+    return true;
+  }
+}
+
+DUNGEON_TEST(ArticulationTrackerMatchesFloodFill)
+{
+  FRandomStream Stream = DungeonTest::MakeStream("ArticulationTrackerMatchesFloodFill");
+  FDungeonArena Arena;
+  int32 NumAllowed = 0;
+  int32 NumRefused = 0;
+  for (int32 Floor = 0; Floor < 2000; Floor++)
+  {
+    FDungeonGrid Grid;
+    MakeRandomFloor(Grid, Stream.RandRange(2, 60), Stream.FRand() * 0.5f, Stream);
+    const int32 Root = Grid.ToIndex(FIntPoint(0, 0));
+
+    // Some floors start with cells locked behind the tracker's back, root included,
+    // which leaves unlocked rooms the root can't reach
+    const int32 NumPreLocked = Stream.RandRange(0, 2);
+    for (int32 i = 0; i < NumPreLocked; i++)
+    {
+      Grid.SetFlag(Grid.ToIndex(Grid.GetCells()[Stream.RandRange(0, Grid.NumCells() - 1)]), DungeonCell::Locked);
+    }
+
+    Arena.Reset();
+    FDungeonArticulationTracker Tracker;
+    Tracker.Build(Arena, Grid, FIntPoint(0, 0));
+
+    // Lock random cells for as long as the tracker allows, checking every answer
+    for (int32 Step = 0; Step < Grid.NumCells() * 2; Step++)
+    {
+      const int32 Candidate = Grid.ToIndex(Grid.GetCells()[Stream.RandRange(0, Grid.NumCells() - 1)]);
+      if (Grid.HasFlag(Candidate, DungeonCell::Locked))
+      {
+        EXPECT(!Tracker.CanLock(Candidate));
+        continue;
+      }
+
+      const bool bExpected = CanLockByFloodFill(Grid, Root, Candidate);
+      EXPECTF(Tracker.CanLock(Candidate) == bExpected, "floor %d, step %d, cell (%d, %d): tracker says %d",
+        Floor, Step, Grid.ToCell(Candidate).X, Grid.ToCell(Candidate).Y, (int32)!bExpected);
+      if (!bExpected)
+      {
+        NumRefused++;
+        continue;
+      }
+
+      NumAllowed++;
+      Grid.SetFlag(Candidate, DungeonCell::Locked);
+      Tracker.OnLocked(Candidate);
+    }
+  }
+
+  // Both answers come up often enough for the comparison to mean something
+  EXPECT(NumAllowed > 10000 && NumRefused > 10000);
+}
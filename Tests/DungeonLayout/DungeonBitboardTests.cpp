@@ -0,0 +1,161 @@
+// DungeonBitboardTests.cpp
+#include "DungeonTestHarness.h"
+#include "DungeonBitboard.h"
+
+namespace
+{
+  // Random floor in a Width x Height grid. Some rows stay empty, and the rest are
+  // filled at a random density, out to the last column the border ring allows.
+  // Dense floors fill whole rows and join nearly every pair, so links run the full
+  // width of a row.
+  void MakeRandomFloor(FDungeonGrid& Grid, int32 Width, int32 Height, bool bDense, FRandomStream& Stream)
+  {
+    Grid.Reset(FIntPoint(0, 0), Width, Height);
+    const float RowChance = Stream.FRand();
+    const float CellChance = bDense ? 1.0f : Stream.FRand();
+    const float DoorChance = bDense ? 0.98f : Stream.FRand();
+    for (int32 Y = 1; Y < Height - 1; Y++)
+    {
+      if (Stream.FRand() > RowChance) continue;
+
+      for (int32 X = 1; X < Width - 1; X++)
+      {
+        if (Stream.FRand() < CellChance) Grid.Occupy(FIntPoint(X, Y));
+      }
+    }
+    check(Grid.GetWidth() == Width && Grid.GetHeight() == Height);
+
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      for (const FIntPoint& Offset : { FIntPoint(1, 0), FIntPoint(0, 1) })
+      {
+        if (Grid.IsOccupied(Cell + Offset) && Stream.FRand() < DoorChance)
+        {
+          Grid.Connect(Cell, Cell + Offset);
+        }
+      }
+    }
+
+    // A few locked cells to leave out
+    for (const FIntPoint& Cell : Grid.GetCells())
+    {
+      if (Stream.FRand() < 0.05f) Grid.SetFlag(Grid.ToIndex(Cell), DungeonCell::Locked);
+    }
+  }
+
+  // Breadth-first distances the way the generator's queue search finds them
+  TArray<int32> QueueDistances(const FDungeonGrid& Grid, int32 Start, EDungeonBitboardEdges Edges, uint8 ExcludeFlags, int32 RemovedIndex, int32 RemovedDirection)
+  {
+    TArray<int32> Distances;
+    Distances.Init(INDEX_NONE, Grid.NumIndices());
+    TArray<int32> Queue;
+    Distances[Start] = 0;
+    Queue.Add(Start);
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+      const int32 Current = Queue[Head];
+      for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+      {
+        const int32 Next = Grid.Neighbour(Current, Dir);
+        const bool bLinked = Edges == EDungeonBitboardEdges::Adjacency || (Grid.GetDoors(Current) & DungeonDoor::FromIndex(Dir));
+        const bool bRemoved = (Current == RemovedIndex && Dir == RemovedDirection) ||
+          (Next == RemovedIndex && Dir == (RemovedDirection + 2) % DungeonDoor::NumDirections);
+        if (!bLinked || bRemoved || !Grid.IsOccupied(Next) || Grid.HasFlag(Next, ExcludeFlags) || Distances[Next] != INDEX_NONE) continue;
+
+        Distances[Next] = Distances[Current] + 1;
+        Queue.Add(Next);
+      }
+    }
+    return Distances;
+  }
+}
+
+DUNGEON_TEST(BitboardMatchesQueueSearch)
+{
+  FRandomStream Stream = DungeonTest::MakeStream("BitboardMatchesQueueSearch");
+  const int32 Sizes[] = { 3, 4, 17, 32, 33, 63, 64 };
+  int32 NumSearches = 0;
+  for (int32 Floor = 0; Floor < 1500; Floor++)
+  {
+    // Every fourth floor is the full 64 columns, to exercise the top bit of each row
+    const int32 Width = Floor % 4 == 0 ? FDungeonBitboard::MaxSize : Sizes[Stream.RandRange(0, UE_ARRAY_COUNT(Sizes) - 1)];
+    const int32 Height = Sizes[Stream.RandRange(0, UE_ARRAY_COUNT(Sizes) - 1)];
+    FDungeonGrid Grid;
+    MakeRandomFloor(Grid, Width, Height, Floor % 3 == 0, Stream);
+    if (Grid.NumCells() == 0) continue;
+
+    const EDungeonBitboardEdges Edges = Floor % 5 == 0 ? EDungeonBitboardEdges::Adjacency : EDungeonBitboardEdges::Doors;
+    const uint8 ExcludeFlags = Floor % 2 == 0 ? DungeonCell::Locked : DungeonCell::None;
+    FDungeonBitboard Bitboard;
+    Bitboard.Build(Grid, Edges, ExcludeFlags);
+
+    // Half of the floors lose one door, as the locked door is left out of searches
+    int32 RemovedIndex = INDEX_NONE;
+    int32 RemovedDirection = 0;
+    if (Floor % 2 == 1)
+    {
+      RemovedIndex = Grid.ToIndex(Grid.GetCells()[Stream.RandRange(0, Grid.NumCells() - 1)]);
+      RemovedDirection = Stream.RandRange(0, DungeonDoor::NumDirections - 1);
+      Bitboard.RemoveDoor(RemovedIndex, DungeonDoor::FromIndex(RemovedDirection));
+    }
+
+    for (int32 Search = 0; Search < 3; Search++)
+    {
+      const int32 Start = Grid.ToIndex(Grid.GetCells()[Stream.RandRange(0, Grid.NumCells() - 1)]);
+      if (Grid.HasFlag(Start, ExcludeFlags))
+      {
+        EXPECT(!Bitboard.ReachesAll(Start));
+        continue;
+      }
+      NumSearches++;
+
+      const TArray<int32> Expected = QueueDistances(Grid, Start, Edges, ExcludeFlags, RemovedIndex, RemovedDirection);
+      int32 NumExpected = 0;
+      bool bExpectedAll = true;
+      for (const FIntPoint& Cell : Grid.GetCells())
+      {
+        const int32 Index = Grid.ToIndex(Cell);
+        NumExpected += Expected[Index] != INDEX_NONE ? 1 : 0;
+        bExpectedAll &= Expected[Index] != INDEX_NONE || Grid.HasFlag(Index, ExcludeFlags);
+      }
+
+      // Fill reaches the same cells
+      FDungeonBitboard::FRows Reached;
+      Reached.Reset();
+      Bitboard.SetCell(Reached, Start);
+      Bitboard.Fill(Reached);
+      int32 NumFilled = 0;
+      bool bFillMatches = true;
+      Bitboard.ForEachCell(Reached, [&](int32 Index)
+        {
+          NumFilled++;
+          bFillMatches &= Expected[Index] != INDEX_NONE;
+        });
+      EXPECTF(bFillMatches && NumFilled == NumExpected, "floor %d (%dx%d): fill reached %d cells, queue %d", Floor, Width, Height, NumFilled, NumExpected);
+      EXPECTF(Bitboard.ReachesAll(Start) == bExpectedAll, "floor %d (%dx%d)", Floor, Width, Height);
+
+      // Stepping level by level gives the same distances
+      FDungeonBitboard::FRows Levels[2];
+      FDungeonBitboard::FRows Visited;
+      Levels[0].Reset();
+      Levels[1].Reset();
+      Visited.Reset();
+      Bitboard.SetCell(Levels[0], Start);
+      Bitboard.SetCell(Visited, Start);
+      int32 Distance = 0;
+      int32 NumStepped = 1;
+      bool bStepMatches = true;
+      while (Bitboard.Step(Levels[Distance & 1], Visited, Levels[(Distance + 1) & 1]))
+      {
+        Distance++;
+        Bitboard.ForEachCell(Levels[Distance & 1], [&](int32 Index)
+          {
+            NumStepped++;
+            bStepMatches &= Expected[Index] == Distance;
+          });
+      }
+      EXPECTF(bStepMatches && NumStepped == NumExpected, "floor %d (%dx%d): stepped to %d cells, queue %d", Floor, Width, Height, NumStepped, NumExpected);
+    }
+  }
+  EXPECT(NumSearches > 3000);
+}
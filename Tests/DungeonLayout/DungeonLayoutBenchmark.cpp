@@ -0,0 +1,243 @@
+// DungeonLayoutBenchmark.cpp
+// Times every layout phase over a sweep of floor sizes, like the DungeonBenchmark
+// commandlet but without the engine, and prints the percentiles per phase.
+// -WaveCollapse lays floors out with the wave function collapse engine instead of
+// growth, and also reports how many floors collapsed rather than falling back. Then
+// times one reachability search from the safe room, bitboard fill against queue
+// search, on generated floors of each of BitboardRooms.
+//
+//   DungeonLayoutBenchmark [-CellCounts=15,1000,10000] [-Seeds=20] [-Runs=3]
+//     [-BitboardRooms=50,200,800] [-WaveCollapse]
+#include "CoreMinimal.h"
+#include "DungeonLayout.h"
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+  struct FPhaseSamples
+  {
+    const char* Name;
+    TArray<double> Ms;
+  };
+
+  // Nearest-rank percentile
+  double Percentile(TArray<double> Samples, double Percent)
+  {
+    if (Samples.IsEmpty()) return 0.0;
+
+    Samples.StableSort([](double A, double B) { return A < B; });
+    const int32 Rank = FMath::CeilToInt((float)(Percent / 100.0 * Samples.Num()));
+    return Samples[FMath::Clamp(Rank - 1, 0, Samples.Num() - 1)];
+  }
+
+  // Value of -Name=Value among the arguments, or null
+  const char* FindValue(int ArgC, char** ArgV, const char* Name)
+  {
+    const size_t Length = std::strlen(Name);
+    for (int i = 1; i < ArgC; i++)
+    {
+      if (ArgV[i][0] == '-' && std::strncmp(ArgV[i] + 1, Name, Length) == 0 && ArgV[i][Length + 1] == '=')
+      {
+        return ArgV[i] + Length + 2;
+      }
+    }
+    return nullptr;
+  }
+
+  bool HasFlag(int ArgC, char** ArgV, const char* Name)
+  {
+    for (int i = 1; i < ArgC; i++)
+    {
+      if (ArgV[i][0] == '-' && std::strcmp(ArgV[i] + 1, Name) == 0) return true;
+    }
+    return false;
+  }
+
+  int32 ParseInt(int ArgC, char** ArgV, const char* Name, int32 Default)
+  {
+    const char* Value = FindValue(ArgC, ArgV, Name);
+    return Value ? std::atoi(Value) : Default;
+  }
+
+  TArray<int32> ParseIntList(int ArgC, char** ArgV, const char* Name, TArray<int32> Default)
+  {
+    const char* Value = FindValue(ArgC, ArgV, Name);
+    if (!Value) return Default;
+
+    TArray<int32> List;
+    for (const char* Item = Value; *Item;)
+    {
+      List.Add(std::atoi(Item));
+      const char* Comma = std::strchr(Item, ',');
+      if (!Comma) break;
+      Item = Comma + 1;
+    }
+    return List;
+  }
+
+  // Rooms the safe room reaches through doors, by the queue search the generator
+  // uses on floors too big for the bitboard. Visited holds a stamp per grid index.
+  int32 QueueReach(const FDungeonGrid& Grid, int32 Start, int32 Stamp, TArray<int32>& Visited, TArray<int32>& Queue)
+  {
+    Queue.Reset(Grid.NumCells());
+    Queue.Add(Start);
+    Visited[Start] = Stamp;
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+      const int32 Current = Queue[Head];
+      const uint8 Doors = Grid.GetDoors(Current);
+      for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+      {
+        const int32 Next = Grid.Neighbour(Current, Dir);
+        if ((Doors & DungeonDoor::FromIndex(Dir)) && Visited[Next] != Stamp)
+        {
+          Visited[Next] = Stamp;
+          Queue.Add(Next);
+        }
+      }
+    }
+    return Queue.Num();
+  }
+
+  // Median microseconds per bitboard build, bitboard fill and queue search over floors
+  // of about CellCount rooms
+  void BenchmarkReachability(FDungeonLayoutGenerator& Generator, int32 CellCount, int32 SeedCount)
+  {
+    constexpr int32 Repeats = 2000;
+    TArray<double> BuildUs;
+    TArray<double> FillUs;
+    TArray<double> QueueUs;
+    int64 TotalRooms = 0;
+    // Read back so the searches can't be optimised away
+    volatile int64 Sink = 0;
+
+    FDungeonLayoutParams Params;
+    Params.CellCount = CellCount;
+    for (int32 SeedIndex = 1; SeedIndex <= SeedCount; SeedIndex++)
+    {
+      Params.Seed = FDungeonLayoutGenerator::MixSeed(SeedIndex, (uint32)CellCount);
+      const FDungeonLayout Layout = Generator.Generate(Params);
+      const FDungeonGrid& Grid = Layout.GetGrid();
+      if (!FDungeonBitboard::Fits(Grid)) continue;
+
+      TotalRooms += Grid.NumCells();
+      const int32 Start = Grid.ToIndex(Layout.GetSafeRoom());
+
+      FDungeonBitboard Bitboard;
+      double StartTime = FPlatformTime::Seconds();
+      for (int32 Repeat = 0; Repeat < Repeats; Repeat++)
+      {
+        Bitboard.Build(Grid, EDungeonBitboardEdges::Doors);
+        Sink = Sink + (int64)Bitboard.GetCells()[1];
+      }
+      BuildUs.Add((FPlatformTime::Seconds() - StartTime) * 1e6 / Repeats);
+
+      StartTime = FPlatformTime::Seconds();
+      for (int32 Repeat = 0; Repeat < Repeats; Repeat++)
+      {
+        FDungeonBitboard::FRows Reached;
+        Reached.Reset();
+        Bitboard.SetCell(Reached, Start);
+        Bitboard.Fill(Reached);
+        Sink = Sink + (int64)Reached[Start / Grid.GetWidth() + 1];
+      }
+      FillUs.Add((FPlatformTime::Seconds() - StartTime) * 1e6 / Repeats);
+
+      TArray<int32> Visited;
+      Visited.Init(0, Grid.NumIndices());
+      TArray<int32> Queue;
+      StartTime = FPlatformTime::Seconds();
+      for (int32 Repeat = 0; Repeat < Repeats; Repeat++)
+      {
+        Sink = Sink + QueueReach(Grid, Start, Repeat + 1, Visited, Queue);
+      }
+      QueueUs.Add((FPlatformTime::Seconds() - StartTime) * 1e6 / Repeats);
+    }
+
+    if (FillUs.IsEmpty())
+    {
+      std::printf("%8d %10s no floor fits the bitboard\n", CellCount, "-");
+      return;
+    }
+    std::printf("%8d %10.1f %10.2f %10.2f %10.2f\n", CellCount, (double)TotalRooms / FillUs.Num(),
+      Percentile(BuildUs, 50.0), Percentile(FillUs, 50.0), Percentile(QueueUs, 50.0));
+  }
+}
+
+int main(int ArgC, char** ArgV)
+{
+  const TArray<int32> CellCounts = ParseIntList(ArgC, ArgV, "CellCounts", { 15, 100, 1000, 10000 });
+  const int32 SeedCount = FMath::Max(ParseInt(ArgC, ArgV, "Seeds", 20), 1);
+  const int32 Runs = FMath::Max(ParseInt(ArgC, ArgV, "Runs", 3), 1);
+  const TArray<int32> BitboardRooms = ParseIntList(ArgC, ArgV, "BitboardRooms", { 50, 200, 800 });
+  const EDungeonLayoutEngine Engine = HasFlag(ArgC, ArgV, "WaveCollapse") ? EDungeonLayoutEngine::WaveFunctionCollapse : EDungeonLayoutEngine::Growth;
+
+  std::printf("bitboard instruction set: %s\n", FDungeonBitboard::GetInstructionSet());
+  std::printf("engine: %s\n", Engine == EDungeonLayoutEngine::Growth ? "growth" : "wave function collapse");
+  std::printf("%8s %10s %-20s %10s %10s %10s\n", "cells", "mean_rooms", "phase", "p50_ms", "p90_ms", "p99_ms");
+
+  FDungeonLayoutGenerator Generator;
+  for (int32 CellCount : CellCounts)
+  {
+    FPhaseSamples Phases[] = {
+      { Engine == EDungeonLayoutEngine::Growth ? "growth" : "collapse", {} },
+      { "minimal_connections", {} },
+      { "locked_area", {} },
+      { "extra_doors", {} },
+      { "accessible_area", {} },
+      { "enemies", {} },
+      { "total", {} }
+    };
+    int64 TotalRooms = 0;
+    int32 NumCollapsed = 0;
+
+    FDungeonLayoutParams Params;
+    Params.CellCount = CellCount;
+    Params.Engine = Engine;
+
+    // The first generation warms the generator's arena and is not counted
+    Params.Seed = 0;
+    Generator.Generate(Params);
+
+    for (int32 SeedIndex = 1; SeedIndex <= SeedCount; SeedIndex++)
+    {
+      Params.Seed = FDungeonLayoutGenerator::MixSeed(SeedIndex, (uint32)CellCount);
+      for (int32 Run = 0; Run < Runs; Run++)
+      {
+        const FDungeonLayout Layout = Generator.Generate(Params);
+        TotalRooms += Layout.GetGrid().NumCells();
+        NumCollapsed += Generator.WasLastFloorCollapsed() ? 1 : 0;
+
+        const FDungeonLayoutTimings& Timings = Generator.GetLastTimings();
+        Phases[0].Ms.Add(Timings.Growth * 1000.0);
+        Phases[1].Ms.Add(Timings.MinimalConnections * 1000.0);
+        Phases[2].Ms.Add(Timings.LockedArea * 1000.0);
+        Phases[3].Ms.Add(Timings.ExtraDoors * 1000.0);
+        Phases[4].Ms.Add(Timings.AccessibleArea * 1000.0);
+        Phases[5].Ms.Add(Timings.Enemies * 1000.0);
+        Phases[6].Ms.Add(Timings.GetTotal() * 1000.0);
+      }
+    }
+
+    const double MeanRooms = (double)TotalRooms / (SeedCount * Runs);
+    for (const FPhaseSamples& Phase : Phases)
+    {
+      std::printf("%8d %10.1f %-20s %10.4f %10.4f %10.4f\n", CellCount, MeanRooms, Phase.Name,
+        Percentile(Phase.Ms, 50.0), Percentile(Phase.Ms, 90.0), Percentile(Phase.Ms, 99.0));
+    }
+    if (Engine != EDungeonLayoutEngine::Growth)
+    {
+      std::printf("%8d %10.1f %-20s %d of %d\n", CellCount, MeanRooms, "collapsed", NumCollapsed, SeedCount * Runs);
+    }
+  }
+
+  // A search needs a fill on a built bitboard; the generator builds once per phase
+  std::printf("\nreachability from the safe room, median microseconds\n");
+  std::printf("%8s %10s %10s %10s %10s\n", "cells", "mean_rooms", "build_us", "fill_us", "queue_us");
+  for (int32 CellCount : BitboardRooms)
+  {
+    BenchmarkReachability(Generator, CellCount, SeedCount);
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+// DungeonLayoutFormatTests.cpp
+#include "DungeonTestHarness.h"
+#include "DungeonLayoutFormat.h"
+#include <cstddef>
+
+namespace
+{
+  FDungeonLayout MakeLayout(int32 Seed)
+  {
+    FDungeonLayoutParams Params;
+    Params.Seed = Seed;
+    Params.CellCount = 40;
+    FDungeonLayoutGenerator Generator;
+    return Generator.Generate(Params);
+  }
+
+  void WriteInt(TArray<uint8>& Data, SIZE_T Offset, int32 Value)
+  {
+    FMemory::Memcpy(Data.GetData() + Offset, &Value, sizeof(Value));
+  }
+
+  // Offset of the stored distance of the Index'th cell in generation order
+  SIZE_T DistanceOffset(const FDungeonLayout& Layout, int32 Index)
+  {
+    return sizeof(FDungeonLayoutFileHeader) + (Layout.GetGrid().NumCells() + Layout.GetEnemySlots().Num()) * sizeof(FIntPoint) + Index * sizeof(int32);
+  }
+
+  bool CanRead(const TArray<uint8>& Data)
+  {
+    FDungeonLayout Layout;
+    const bool bRead = FDungeonLayoutFormat::Read(Data.GetData(), Data.Num(), Layout);
+    return bRead && !Layout.IsEmpty();
+  }
+}
+
+DUNGEON_TEST(LayoutFormatRoundTrips)
+{
+  for (int32 Seed = 0; Seed < 20; Seed++)
+  {
+    const FDungeonLayout Layout = MakeLayout(Seed);
+    TArray<uint8> Data;
+    FDungeonLayoutFormat::Write(Layout, 1234u, Data);
+
+    FDungeonLayout Read;
+    uint32 ParamsHash = 0;
+    EXPECT(FDungeonLayoutFormat::Read(Data.GetData(), Data.Num(), Read, &ParamsHash));
+    EXPECT(ParamsHash == 1234u);
+    EXPECT(FDungeonLayoutFormat::Checksum(Read) == FDungeonLayoutFormat::Checksum(Layout));
+    EXPECT(Read.GetMaxSafeRoomDistance() == Layout.GetMaxSafeRoomDistance());
+    for (const FIntPoint& Cell : Layout.GetGrid().GetCells())
+    {
+      EXPECT(Read.GetSafeRoomDistance(Cell) == Layout.GetSafeRoomDistance(Cell));
+    }
+
+    // Truncated data is refused
+    EXPECT(!FDungeonLayoutFormat::Read(Data.GetData(), Data.Num() - 1, Read));
+    EXPECT(Read.IsEmpty());
+  }
+}
+
+DUNGEON_TEST(LayoutFormatRejectsBadDistances)
+{
+  const FDungeonLayout Layout = MakeLayout(7);
+  const FDungeonGrid& Grid = Layout.GetGrid();
+  const int32 MaxDistance = Layout.GetMaxSafeRoomDistance();
+  TArray<uint8> Valid;
+  FDungeonLayoutFormat::Write(Layout, 0, Valid);
+  EXPECT(CanRead(Valid));
+
+  // Cells by their position in the file: the safe room, and one short of the maximum
+  int32 SafeRoom = INDEX_NONE;
+  int32 Other = INDEX_NONE;
+  for (int32 i = 0; i < Grid.NumCells(); i++)
+  {
+    const FIntPoint Cell = Grid.GetCells()[i];
+    if (Cell == Layout.GetSafeRoom()) SafeRoom = i;
+    else if (Other == INDEX_NONE && Layout.GetSafeRoomDistance(Cell) < MaxDistance) Other = i;
+  }
+  EXPECT(SafeRoom != INDEX_NONE && Other != INDEX_NONE && MaxDistance > 1);
+
+  // A room may be unreached, but nothing below that and nothing past the maximum
+  TArray<uint8> Data = Valid;
+  WriteInt(Data, DistanceOffset(Layout, Other), INDEX_NONE);
+  EXPECT(CanRead(Data));
+  for (int32 Distance : { -2, MaxDistance + 1, MAX_int32 })
+  {
+    Data = Valid;
+    WriteInt(Data, DistanceOffset(Layout, Other), Distance);
+    EXPECTF(!CanRead(Data), "distance %d", Distance);
+  }
+
+  // The safe room is where distances start
+  Data = Valid;
+  WriteInt(Data, DistanceOffset(Layout, SafeRoom), 1);
+  EXPECT(!CanRead(Data));
+
+  // The stored maximum has to be the one the distances reach
+  Data = Valid;
+  WriteInt(Data, offsetof(FDungeonLayoutFileHeader, MaxSafeRoomDistance), MaxDistance + 1);
+  EXPECT(!CanRead(Data));
+  Data = Valid;
+  for (int32 i = 0; i < Grid.NumCells(); i++)
+  {
+    if (Layout.GetSafeRoomDistance(Grid.GetCells()[i]) == MaxDistance) WriteInt(Data, DistanceOffset(Layout, i), MaxDistance - 1);
+  }
+  EXPECT(!CanRead(Data));
+}
+
+DUNGEON_TEST(LayoutFormatRejectsOversizedCounts)
+{
+  const FDungeonLayout Layout = MakeLayout(3);
+  TArray<uint8> Valid;
+  FDungeonLayoutFormat::Write(Layout, 0, Valid);
+  EXPECT(Valid.Num() <= FDungeonLayoutFormat::MaxFileSize);
+
+  // Counts past what the generator makes are refused before any size check
+  TArray<uint8> Data = Valid;
+  WriteInt(Data, offsetof(FDungeonLayoutFileHeader, NumCells), FDungeonLayoutGenerator::MaxRooms + 1);
+  EXPECT(!CanRead(Data));
+
+  // Every enemy slot is a room
+  Data = Valid;
+  WriteInt(Data, offsetof(FDungeonLayoutFileHeader, NumEnemySlots), Layout.GetGrid().NumCells() + 1);
+  EXPECT(!CanRead(Data));
+}
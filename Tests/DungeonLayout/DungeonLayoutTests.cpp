@@ -0,0 +1,393 @@
+// DungeonLayoutTests.cpp
+#include "DungeonTestHarness.h"
+#include "DungeonLayout.h"
+#include "DungeonLayoutFormat.h"
+#include "DungeonRoomShapes.h"
+#include <cstdio>
+
+namespace
+{
+  const EDungeonLayoutEngine Engines[] = { EDungeonLayoutEngine::Growth, EDungeonLayoutEngine::WaveFunctionCollapse };
+  const int32 CellCounts[] = { 5, 15, 60, 250, 1000 };
+  const float LoopFractions[] = { 0.0f, 0.3f, 1.0f };
+  const float LockedAreaSizes[] = { 0.1f, 0.3f, 0.6f };
+  constexpr int32 SeedsPerConfig = 6;
+
+  // Calls Check(Params, Layout) for a sweep of engines, sizes and params, and stops at
+  // the first floor it returns false for
+  template <typename CheckType>
+  bool ForEachFloor(CheckType&& Check)
+  {
+    FDungeonLayoutGenerator Generator;
+    for (EDungeonLayoutEngine Engine : Engines)
+    {
+      for (int32 CellCount : CellCounts)
+      {
+        for (float LoopFraction : LoopFractions)
+        {
+          for (float LockedAreaSize : LockedAreaSizes)
+          {
+            for (int32 Seed = 0; Seed < SeedsPerConfig; Seed++)
+            {
+              FDungeonLayoutParams Params;
+              Params.Seed = FDungeonLayoutGenerator::MixSeed(Seed, (uint32)CellCount);
+              Params.CellCount = CellCount;
+              Params.LoopFraction = LoopFraction;
+              Params.LockedAreaSizePercent = LockedAreaSize;
+              Params.Engine = Engine;
+              if (!Check(Params, Generator.Generate(Params))) return false;
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void PrintParams(const FDungeonLayoutParams& Params)
+  {
+    std::fprintf(stderr, "  floor: engine %d, seed %d, cells %d, loop fraction %.2f, locked area %.2f\n",
+      (int32)Params.Engine, Params.Seed, Params.CellCount, Params.LoopFraction, Params.LockedAreaSizePercent);
+  }
+
+  TArray<uint8> Serialise(const FDungeonLayout& Layout)
+  {
+    TArray<uint8> Data;
+    FDungeonLayoutFormat::Write(Layout, 0, Data);
+    return Data;
+  }
+
+  // Breadth-first door distances from Start over the whole grid, written straight
+  // against the door masks rather than through the generator's search
+  TArray<int32> DoorDistances(const FDungeonGrid& Grid, FIntPoint Start, bool bThroughLockedDoor, const FDungeonLayout& Layout)
+  {
+    TArray<int32> Distances;
+    Distances.Init(INDEX_NONE, Grid.NumIndices());
+    TArray<FIntPoint> Queue;
+    Distances[Grid.ToIndex(Start)] = 0;
+    Queue.Add(Start);
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+      const FIntPoint Cell = Queue[Head];
+      for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+      {
+        const FIntPoint Next = Cell + DungeonDoor::Offsets[Dir];
+        if (!(Grid.GetDoors(Cell) & DungeonDoor::FromIndex(Dir)) || Distances[Grid.ToIndex(Next)] != INDEX_NONE) continue;
+
+        const bool bLockedDoor = Layout.HasLockedDoor() &&
+          ((Cell == Layout.GetLockedDoorRoom() && Next == Layout.GetLockedDoorNeighbour()) ||
+          (Next == Layout.GetLockedDoorRoom() && Cell == Layout.GetLockedDoorNeighbour()));
+        if (bLockedDoor && !bThroughLockedDoor) continue;
+
+        Distances[Grid.ToIndex(Next)] = Distances[Grid.ToIndex(Cell)] + 1;
+        Queue.Add(Next);
+      }
+    }
+    return Distances;
+  }
+}
+
+DUNGEON_TEST(SameSeedGivesSameLayout)
+{
+  // A second generator that built a different floor first, so leftovers on its arena
+  // or in its streams would show up as a difference
+  FDungeonLayoutGenerator Other;
+  int32 NumFloors = 0;
+  int32 NumSameAsPrevious = 0;
+  TArray<uint8> Previous;
+  const bool bAllMatched = ForEachFloor([&](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      FDungeonLayoutParams Warmup = Params;
+      Warmup.Seed = Params.Seed + 1;
+      Warmup.CellCount = Params.CellCount * 2;
+      Other.Generate(Warmup);
+
+      const TArray<uint8> Data = Serialise(Layout);
+      const FDungeonLayout Again = Other.Generate(Params);
+      NumFloors++;
+      NumSameAsPrevious += Data == Previous ? 1 : 0;
+      Previous = Data;
+      if (Data == Serialise(Again) && FDungeonLayoutFormat::Checksum(Layout) == FDungeonLayoutFormat::Checksum(Again)) return true;
+
+      PrintParams(Params);
+      return false;
+    });
+  EXPECT(bAllMatched);
+
+  // Consecutive floors differ in seed or params, so they should almost never match
+  EXPECTF(NumSameAsPrevious * 50 < NumFloors, "%d of %d floors repeated the one before", NumSameAsPrevious, NumFloors);
+}
+
+DUNGEON_TEST(DoorsAreSymmetric)
+{
+  const bool bAllSymmetric = ForEachFloor([](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      const FDungeonGrid& Grid = Layout.GetGrid();
+      for (const FIntPoint& Cell : Grid.GetCells())
+      {
+        for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+        {
+          const uint8 Door = DungeonDoor::FromIndex(Dir);
+          const FIntPoint Next = Cell + DungeonDoor::Offsets[Dir];
+          if (!(Grid.GetDoors(Cell) & Door)) continue;
+          if (Grid.IsOccupied(Next) && (Grid.GetDoors(Next) & DungeonDoor::Opposite(Door))) continue;
+
+          PrintParams(Params);
+          std::fprintf(stderr, "  door %d of (%d, %d) has no matching door\n", Dir, Cell.X, Cell.Y);
+          return false;
+        }
+      }
+      return true;
+    });
+  EXPECT(bAllSymmetric);
+}
+
+DUNGEON_TEST(EveryRoomIsReachable)
+{
+  const bool bAllReachable = ForEachFloor([](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      const FDungeonGrid& Grid = Layout.GetGrid();
+      const TArray<int32> Distances = DoorDistances(Grid, Layout.GetSafeRoom(), true, Layout);
+
+      // Every room is reached once the locked door is open, at the distance the layout reports
+      int32 MaxDistance = 0;
+      for (const FIntPoint& Cell : Grid.GetCells())
+      {
+        const int32 Distance = Distances[Grid.ToIndex(Cell)];
+        if (Distance == INDEX_NONE || Distance != Layout.GetSafeRoomDistance(Cell))
+        {
+          PrintParams(Params);
+          std::fprintf(stderr, "  room (%d, %d) is %d doors away, layout says %d\n", Cell.X, Cell.Y, Distance, Layout.GetSafeRoomDistance(Cell));
+          return false;
+        }
+        MaxDistance = FMath::Max(MaxDistance, Distance);
+      }
+
+      const bool bSpecialRoomsPlaced = Grid.IsOccupied(Layout.GetSafeRoom()) && Grid.IsOccupied(Layout.GetEndRoom()) &&
+        (!Layout.HasKeyRoom() || Grid.IsOccupied(Layout.GetKeyRoom()));
+      if (MaxDistance == Layout.GetMaxSafeRoomDistance() && bSpecialRoomsPlaced) return true;
+
+      PrintParams(Params);
+      return false;
+    });
+  EXPECT(bAllReachable);
+}
+
+DUNGEON_TEST(LockedAreaIsOnlyEnteredThroughLockedDoor)
+{
+  // Facing indexes these offsets from the locked room to its neighbour
+  const FIntPoint FacingOffsets[] = { FIntPoint(0, 1), FIntPoint(1, 0), FIntPoint(0, -1), FIntPoint(-1, 0) };
+
+  int32 NumLockedFloors = 0;
+  const bool bAllSealed = ForEachFloor([&](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      const FDungeonGrid& Grid = Layout.GetGrid();
+      auto IsLocked = [&Grid](FIntPoint Cell) { return Grid.HasFlag(Cell, DungeonCell::Locked); };
+      if (!Layout.HasLockedDoor())
+      {
+        // Only floors too small to lock anything go without
+        return Layout.GetLockedRoomCount() == 0 && Grid.NumCells() < 7;
+      }
+      NumLockedFloors++;
+
+      const FIntPoint DoorRoom = Layout.GetLockedDoorRoom();
+      const FIntPoint DoorNeighbour = Layout.GetLockedDoorNeighbour();
+      bool bValid = IsLocked(DoorRoom) && !IsLocked(DoorNeighbour) && Grid.IsConnected(DoorRoom, DoorNeighbour) &&
+        DoorNeighbour - DoorRoom == FacingOffsets[Layout.GetLockedDoorFacing()] &&
+        !IsLocked(Layout.GetSafeRoom()) && (!Layout.HasKeyRoom() || !IsLocked(Layout.GetKeyRoom()));
+
+      // No other door crosses the boundary
+      int32 NumLocked = 0;
+      for (const FIntPoint& Cell : Grid.GetCells())
+      {
+        NumLocked += IsLocked(Cell) ? 1 : 0;
+        for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+        {
+          const FIntPoint Next = Cell + DungeonDoor::Offsets[Dir];
+          const bool bCrosses = (Grid.GetDoors(Cell) & DungeonDoor::FromIndex(Dir)) && IsLocked(Cell) != IsLocked(Next);
+          const bool bIsLockedDoor = (Cell == DoorRoom && Next == DoorNeighbour) || (Cell == DoorNeighbour && Next == DoorRoom);
+          bValid &= !bCrosses || bIsLockedDoor;
+        }
+      }
+
+      // With the locked door shut the safe room reaches exactly the unlocked rooms,
+      // and from the locked door every locked room is reached without leaving the area
+      const TArray<int32> FromSafeRoom = DoorDistances(Grid, Layout.GetSafeRoom(), false, Layout);
+      const TArray<int32> FromLockedDoor = DoorDistances(Grid, DoorRoom, false, Layout);
+      int32 NumAccessible = 0;
+      for (const FIntPoint& Cell : Grid.GetCells())
+      {
+        const bool bReached = FromSafeRoom[Grid.ToIndex(Cell)] != INDEX_NONE;
+        NumAccessible += bReached ? 1 : 0;
+        bValid &= bReached != IsLocked(Cell) && Grid.HasFlag(Cell, DungeonCell::Accessible) == bReached;
+        bValid &= !IsLocked(Cell) || FromLockedDoor[Grid.ToIndex(Cell)] != INDEX_NONE;
+      }
+      bValid &= NumLocked == Layout.GetLockedRoomCount() && NumAccessible == Layout.GetAccessibleRoomCount() &&
+        NumLocked + NumAccessible == Grid.NumCells();
+      if (bValid) return true;
+
+      PrintParams(Params);
+      return false;
+    });
+  EXPECT(bAllSealed);
+  EXPECT(NumLockedFloors > 0);
+}
+
+DUNGEON_TEST(GrownLockedAreasReachTheirTarget)
+{
+  int64 TotalLocked = 0;
+  int64 TotalTarget = 0;
+  const bool bNoneOver = ForEachFloor([&](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      if (Params.Engine != EDungeonLayoutEngine::Growth || !Layout.HasLockedDoor()) return true;
+
+      // The target counts the rooms there were before the key room
+      const int32 NumRooms = Layout.GetGrid().NumCells() - (Layout.HasKeyRoom() ? 1 : 0);
+      const int32 Target = FMath::Max(2, FMath::CeilToInt(NumRooms * Params.LockedAreaSizePercent));
+      TotalLocked += Layout.GetLockedRoomCount();
+      TotalTarget += Target;
+      if (Layout.GetLockedRoomCount() <= Target) return true;
+
+      PrintParams(Params);
+      return false;
+    });
+  EXPECT(bNoneOver);
+
+  // A room is only left out when everything hanging below it would overshoot
+  EXPECTF(TotalLocked * 100 >= TotalTarget * 95, "%lld of %lld target rooms locked", (long long)TotalLocked, (long long)TotalTarget);
+}
+
+DUNGEON_TEST(GrownFloorsGetExactLoopCounts)
+{
+  int32 NumFloorsWithLoops = 0;
+  const bool bAllExact = ForEachFloor([&](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      if (Params.Engine != EDungeonLayoutEngine::Growth) return true;
+
+      const FDungeonGrid& Grid = Layout.GetGrid();
+      int32 NumDoors = 0;
+      int32 NumSameSidePairs = 0;
+      for (const FIntPoint& Cell : Grid.GetCells())
+      {
+        for (const FIntPoint Next : { Cell + FIntPoint(1, 0), Cell + FIntPoint(0, 1) })
+        {
+          if (!Grid.IsOccupied(Next)) continue;
+          NumDoors += Grid.IsConnected(Cell, Next) ? 1 : 0;
+          NumSameSidePairs += Grid.HasFlag(Cell, DungeonCell::Locked) == Grid.HasFlag(Next, DungeonCell::Locked) ? 1 : 0;
+        }
+      }
+
+      // Each side of the locked door is one tree plus its loops, so every same-side
+      // pair beyond the two trees could have closed one
+      const int32 NumRooms = Grid.NumCells();
+      const int32 NumTrees = Layout.HasLockedDoor() ? 2 : 1;
+      const int32 NumCandidates = NumSameSidePairs - (NumRooms - NumTrees);
+      const int32 ExpectedLoops = FMath::RoundToInt(Params.LoopFraction * NumCandidates);
+      const int32 NumLoops = NumDoors - NumRooms + 1;
+      NumFloorsWithLoops += NumLoops > 0 ? 1 : 0;
+      if (NumLoops == ExpectedLoops && (Params.LoopFraction > 0.0f || NumLoops == 0)) return true;
+
+      PrintParams(Params);
+      std::fprintf(stderr, "  %d loops, expected %d of %d candidates\n", NumLoops, ExpectedLoops, NumCandidates);
+      return false;
+    });
+  EXPECT(bAllExact);
+  EXPECT(NumFloorsWithLoops > 0);
+}
+
+DUNGEON_TEST(CollapsedFloorsStayNearCellCount)
+{
+  const bool bAllInBounds = ForEachFloor([](const FDungeonLayoutParams& Params, const FDungeonLayout& Layout)
+    {
+      if (Params.Engine != EDungeonLayoutEngine::WaveFunctionCollapse) return true;
+
+      // Every room but the safe, end and key rooms
+      const int32 NumRooms = Layout.GetGrid().NumCells() - 2 - (Layout.HasKeyRoom() ? 1 : 0);
+      if (NumRooms * 2 >= Params.CellCount && NumRooms <= Params.CellCount * 2) return true;
+
+      PrintParams(Params);
+      std::fprintf(stderr, "  %d rooms\n", NumRooms);
+      return false;
+    });
+  EXPECT(bAllInBounds);
+}
+
+DUNGEON_TEST(CollapsedFloorsKeepTheirRules)
+{
+  // The rules written out again against room shapes: no two crossroads side by side,
+  // and no straight running into a dead end or a turn
+  auto ShapeAt = [](const FDungeonGrid& Grid, FIntPoint Cell) { return DungeonRoomShape::FromDoors(Grid.GetDoors(Cell)).Shape; };
+  FDungeonLayoutGenerator Generator;
+  int32 NumFloors = 0;
+  int32 NumCollapsed = 0;
+  for (int32 CellCount : CellCounts)
+  {
+    for (float LockedAreaSize : LockedAreaSizes)
+    {
+      for (int32 Seed = 0; Seed < 20; Seed++)
+      {
+        FDungeonLayoutParams Params;
+        Params.Seed = FDungeonLayoutGenerator::MixSeed(Seed, (uint32)CellCount);
+        Params.CellCount = CellCount;
+        Params.LockedAreaSizePercent = LockedAreaSize;
+        Params.Engine = EDungeonLayoutEngine::WaveFunctionCollapse;
+        const FDungeonLayout Layout = Generator.Generate(Params);
+        const FDungeonGrid& Grid = Layout.GetGrid();
+        NumFloors++;
+        if (!Generator.WasLastFloorCollapsed()) continue;
+        NumCollapsed++;
+
+        for (const FIntPoint& Cell : Grid.GetCells())
+        {
+          // Only the key room may hang above the first row, as on grown floors
+          EXPECTF(Cell.Y >= 0 || (Layout.HasKeyRoom() && Cell == Layout.GetKeyRoom()), "seed %d, %d cells: room (%d, %d)",
+            Params.Seed, CellCount, Cell.X, Cell.Y);
+
+          const EDungeonRoomShape Shape = ShapeAt(Grid, Cell);
+          for (int32 Dir = 0; Dir < DungeonDoor::NumDirections; Dir++)
+          {
+            const EDungeonRoomShape Beyond = ShapeAt(Grid, Cell + DungeonDoor::Offsets[Dir]);
+            const bool bTouchingCrossroads = Shape == EDungeonRoomShape::Crossroad && Beyond == EDungeonRoomShape::Crossroad;
+            const bool bStraightStops = Shape == EDungeonRoomShape::Straight && (Grid.GetDoors(Cell) & DungeonDoor::FromIndex(Dir)) &&
+              (Beyond == EDungeonRoomShape::DeadEnd || Beyond == EDungeonRoomShape::Turn);
+            EXPECTF(!bTouchingCrossroads && !bStraightStops, "seed %d, %d cells, locked area %.2f: room (%d, %d), direction %d",
+              Params.Seed, CellCount, LockedAreaSize, Cell.X, Cell.Y, Dir);
+          }
+        }
+      }
+    }
+  }
+
+  // Growth only takes over now and then
+  EXPECTF(NumCollapsed * 10 > NumFloors * 9, "%d of %d floors collapsed", NumCollapsed, NumFloors);
+}
+
+DUNGEON_TEST(SteadyStateMakesNoScratchAllocations)
+{
+  for (EDungeonLayoutEngine Engine : Engines)
+  {
+    // Each size on a fresh generator: the first floor sizes the arena, every later
+    // floor of that size fits in it
+    for (int32 CellCount : { 15, 250, 1000, 10000 })
+    {
+      FDungeonLayoutGenerator Generator;
+      FDungeonLayoutParams Params;
+      Params.CellCount = CellCount;
+      Params.Engine = Engine;
+      for (int32 Seed = 0; Seed < 50; Seed++)
+      {
+        Params.Seed = FDungeonLayoutGenerator::MixSeed(Seed, (uint32)CellCount);
+        Params.LoopFraction = Seed % 3 * 0.5f;
+        Generator.Generate(Params);
+        const int32 Allocations = Generator.GetLastScratchAllocations();
+        EXPECTF(Seed == 0 ? Allocations > 0 : Allocations == 0, "engine %d, %d cells, floor %d: %d allocations",
+          (int32)Engine, CellCount, Seed, Allocations);
+      }
+
+      // Smaller floors fit too
+      Params.CellCount = CellCount / 3;
+      Generator.Generate(Params);
+      EXPECT(Generator.GetLastScratchAllocations() == 0);
+    }
+  }
+}
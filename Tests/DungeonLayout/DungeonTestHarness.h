@@ -0,0 +1,33 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Just enough of a test runner for the host build. DUNGEON_TEST bodies register
+// themselves before main; a failed EXPECT reports and leaves the test at once.
+struct FDungeonTest
+{
+  FDungeonTest(const char* InName, void (*InRun)());
+
+  const char* Name;
+  void (*Run)();
+  FDungeonTest* Next = nullptr;
+};
+
+namespace DungeonTest
+{
+  void Fail(const char* File, int32 Line, const char* Format, ...);
+
+  // Deterministic per-test random numbers; every test gets the same sequence on every run
+  FRandomStream MakeStream(const char* TestName);
+}
+
+#define DUNGEON_TEST(Name) \
+  static void Name(); \
+  static const FDungeonTest Name##Registration(#Name, &Name); \
+  static void Name()
+
+#define EXPECT(Expr) \
+  do { if (!(Expr)) { DungeonTest::Fail(__FILE__, __LINE__, "%s", #Expr); return; } } while (0)
+
+// As EXPECT, with a printf message saying which case failed
+#define EXPECTF(Expr, Format, ...) \
+  do { if (!(Expr)) { DungeonTest::Fail(__FILE__, __LINE__, "%s: " Format, #Expr, __VA_ARGS__); return; } } while (0)
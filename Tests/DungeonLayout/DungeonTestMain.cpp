@@ -0,0 +1,65 @@
+// DungeonTestMain.cpp
+#include "DungeonTestHarness.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+  FDungeonTest* FirstTest = nullptr;
+  FDungeonTest** LastTest = &FirstTest;
+  bool bCurrentTestFailed = false;
+}
+
+FDungeonTest::FDungeonTest(const char* InName, void (*InRun)())
+  : Name(InName), Run(InRun)
+{
+  // Keep registration order, i.e. the order tests appear in each file
+  *LastTest = this;
+  LastTest = &Next;
+}
+
+void DungeonTest::Fail(const char* File, int32 Line, const char* Format, ...)
+{
+  bCurrentTestFailed = true;
+  std::fprintf(stderr, "%s:%d: expected ", File, Line);
+  va_list Args;
+  va_start(Args, Format);
+  std::vfprintf(stderr, Format, Args);
+  va_end(Args);
+  std::fprintf(stderr, "\n");
+}
+
+FRandomStream DungeonTest::MakeStream(const char* TestName)
+{
+  // FNV-1a over the name
+  uint32 Hash = 2166136261u;
+  for (const char* Char = TestName; *Char; Char++)
+  {
+    Hash = (Hash ^ (uint8)*Char) * 16777619u;
+  }
+  return FRandomStream((int32)Hash);
+}
+
+// Runs every test, or only those whose name contains the first argument
+int main(int ArgC, char** ArgV)
+{
+  const char* Filter = ArgC > 1 ? ArgV[1] : "";
+  int32 NumRun = 0;
+  int32 NumFailed = 0;
+  for (const FDungeonTest* Test = FirstTest; Test; Test = Test->Next)
+  {
+    if (!std::strstr(Test->Name, Filter)) continue;
+
+    bCurrentTestFailed = false;
+    const double StartTime = FPlatformTime::Seconds();
+    Test->Run();
+    const double Ms = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+    std::printf("%s %s (%.0f ms)\n", bCurrentTestFailed ? "FAILED" : "passed", Test->Name, Ms);
+    NumRun++;
+    NumFailed += bCurrentTestFailed ? 1 : 0;
+  }
+
+  std::printf("%d of %d tests passed\n", NumRun - NumFailed, NumRun);
+  return NumRun > 0 && NumFailed == 0 ? 0 : 1;
+}